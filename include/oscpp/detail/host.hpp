@@ -27,9 +27,17 @@
 
 #include <oscpp/detail/endian.hpp>
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <stdexcept>
 
+#if defined(__x86_64__)
+#    include <immintrin.h>
+#elif defined(__ARM_NEON)
+#    include <arm_neon.h>
+#endif
+
 namespace OSCPP {
 #if defined(__GNUC__)
 inline static uint32_t bswap32(uint32_t x)
@@ -113,6 +121,144 @@ template <> inline uint64_t convert64<HostByteOrder>(uint64_t x)
 {
     return x;
 }
+
+namespace detail {
+inline void bswap32ArrayScalar(const char* src, char* dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t x;
+        std::memcpy(&x, src + 4 * i, 4);
+        x = bswap32(x);
+        std::memcpy(dst + 4 * i, &x, 4);
+    }
+}
+
+#if defined(__x86_64__)
+[[gnu::target("ssse3")]] inline void
+bswap32ArraySSSE3(const char* src, char* dst, size_t count)
+{
+    const __m128i shuffle =
+        _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i x =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i),
+                         _mm_shuffle_epi8(x, shuffle));
+    }
+    bswap32ArrayScalar(src + 4 * i, dst + 4 * i, count - i);
+}
+
+[[gnu::target("avx2")]] inline void
+bswap32ArrayAVX2(const char* src, char* dst, size_t count)
+{
+    const __m256i shuffle = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i x =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 4 * i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 4 * i),
+                            _mm256_shuffle_epi8(x, shuffle));
+    }
+    bswap32ArraySSSE3(src + 4 * i, dst + 4 * i, count - i);
+}
+
+//* Instruction sets available for the bulk conversions, detected once.
+enum SimdLevel
+{
+    SimdNone,
+    SimdSSSE3,
+    SimdAVX2
+};
+
+inline SimdLevel simdLevel()
+{
+    static const SimdLevel level = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return SimdAVX2;
+        if (__builtin_cpu_supports("ssse3"))
+            return SimdSSSE3;
+        return SimdNone;
+    }();
+    return level;
+}
+#elif defined(__ARM_NEON)
+inline void bswap32ArrayNEON(const char* src, char* dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const uint8x16_t x =
+            vld1q_u8(reinterpret_cast<const uint8_t*>(src + 4 * i));
+        vst1q_u8(reinterpret_cast<uint8_t*>(dst + 4 * i), vrev32q_u8(x));
+    }
+    bswap32ArrayScalar(src + 4 * i, dst + 4 * i, count - i);
+}
+#endif
+} // namespace detail
+
+//! Byte swap an array of 32 bit words.
+/*!
+ * Copies count words from src to dst and swaps the bytes of each, using
+ * SIMD byte shuffles where available. Neither pointer has to be aligned,
+ * src and dst may be the same but must not overlap otherwise.
+ */
+inline void bswap32Array(const void* src, void* dst, size_t count)
+{
+    const char* s = static_cast<const char*>(src);
+    char*       d = static_cast<char*>(dst);
+#if defined(__x86_64__)
+    switch (detail::simdLevel())
+    {
+        case detail::SimdAVX2:
+            detail::bswap32ArrayAVX2(s, d, count);
+            return;
+        case detail::SimdSSSE3:
+            detail::bswap32ArraySSSE3(s, d, count);
+            return;
+        case detail::SimdNone:
+            break;
+    }
+    detail::bswap32ArrayScalar(s, d, count);
+#elif defined(__ARM_NEON)
+    detail::bswap32ArrayNEON(s, d, count);
+#else
+    detail::bswap32ArrayScalar(s, d, count);
+#endif
+}
+
+//! Convert an array of 32 bit words from byte order B to host byte order,
+//! or back.
+template <ByteOrder B> inline void convert32Array(const void*, void*, size_t)
+{
+    throw std::logic_error("Invalid byte order");
+}
+
+template <>
+inline void convert32Array<NetworkByteOrder>(const void* src, void* dst,
+                                             size_t count)
+{
+#if defined(OSCPP_LITTLE_ENDIAN)
+    bswap32Array(src, dst, count);
+#else
+    if (src != dst)
+        std::memmove(dst, src, 4 * count);
+#endif
+}
+
+template <>
+inline void convert32Array<HostByteOrder>(const void* src, void* dst,
+                                          size_t count)
+{
+    if (src != dst)
+        std::memmove(dst, src, 4 * count);
+}
 } // namespace OSCPP
 
 #endif // OSCPP_HOST_HPP_INCLUDED
@@ -36,6 +36,65 @@
 
 namespace OSCPP {
 
+namespace detail {
+inline const char *findNullScalar(const char *ptr, const char *end) {
+  while (ptr < end && *ptr != '\0')
+    ptr++;
+  return ptr;
+}
+
+#if defined(__x86_64__)
+inline const char *findNullSSE2(const char *ptr, const char *end) {
+  const __m128i zero = _mm_setzero_si128();
+  for (; end - ptr >= 16; ptr += 16) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+    const unsigned mask =
+        static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, zero)));
+    if (mask != 0)
+      return ptr + __builtin_ctz(mask);
+  }
+  return findNullScalar(ptr, end);
+}
+
+[[gnu::target("avx2")]] inline const char *findNullAVX2(const char *ptr,
+                                                        const char *end) {
+  const __m256i zero = _mm256_setzero_si256();
+  for (; end - ptr >= 32; ptr += 32) {
+    const __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ptr));
+    const unsigned mask = static_cast<unsigned>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, zero)));
+    if (mask != 0)
+      return ptr + __builtin_ctz(mask);
+  }
+  return findNullSSE2(ptr, end);
+}
+#elif defined(__aarch64__)
+inline const char *findNullNEON(const char *ptr, const char *end) {
+  for (; end - ptr >= 16; ptr += 16) {
+    const uint8x16_t x = vld1q_u8(reinterpret_cast<const uint8_t *>(ptr));
+    if (vmaxvq_u8(vceqzq_u8(x)) != 0)
+      return findNullScalar(ptr, ptr + 16);
+  }
+  return findNullScalar(ptr, end);
+}
+#endif
+
+// Find the first null character in [ptr, end), end if there is none. Never
+// reads outside of the range.
+inline const char *findNull(const char *ptr, const char *end) {
+#if defined(__x86_64__)
+  if (simdLevel() == SimdAVX2)
+    return findNullAVX2(ptr, end);
+  return findNullSSE2(ptr, end);
+#elif defined(__aarch64__)
+  return findNullNEON(ptr, end);
+#else
+  return findNullScalar(ptr, end);
+#endif
+}
+} // namespace detail
+
 class Stream {
 public:
   Stream() { m_begin = m_end = m_pos = 0; }
@@ -271,24 +330,45 @@ public:
     return f;
   }
 
+  // Read count consecutive int32 values with one bounds and alignment check.
+  // throw (UnderrunError)
+  inline void getInt32Array(int32_t *dst, size_t count) {
+    checkReadable(4 * count);
+    checkAlignment(4);
+    convert32Array<B>(pos(), dst, count);
+    advance(4 * count);
+  }
+
+  // Read count consecutive float32 values with one bounds and alignment
+  // check.
+  // throw (UnderrunError)
+  inline void getFloat32Array(float *dst, size_t count) {
+    checkReadable(4 * count);
+    checkAlignment(4);
+    convert32Array<B>(pos(), dst, count);
+    advance(4 * count);
+  }
+
+  // Read a null-terminated string padded to 4 bytes. The terminator is
+  // searched with SIMD compares, the padding has to be all null
+  // characters.
   // throw (UnderrunError, ParseError)
   const char *getString() {
     checkReadable(4); // min string length
 
-    const char *ptr = static_cast<const char *>(pos()) + 3;
-    const char *end = static_cast<const char *>(this->end());
+    const char *x = pos();
+    const char *null = detail::findNull(x, end());
+    if (null == end())
+      throw UnderrunError();
 
-    while (true) {
-      if (ptr >= end)
-        throw UnderrunError();
-      if (*ptr == '\0')
-        break;
-      ptr += 4;
+    const size_t n = align(null - x + 1);
+    checkReadable(n);
+    for (const char *ptr = null + 1; ptr < x + n; ptr++) {
+      if (*ptr != '\0')
+        throw ParseError("Invalid string padding");
     }
 
-    const char *x = pos();
-    advance(ptr - pos() + 1);
-
+    advance(n);
     return x;
   }
 };
@@ -197,12 +197,113 @@ public:
         }
     }
 
+    //! Get a run of numerical arguments as floats.
+    /*!
+     * Read up to count consecutive int or float arguments into out,
+     * converting ints like float32() does. Every run of equal type tags is
+     * decoded with one bounds check and bulk byte swapping. Reading stops at
+     * the first argument of another type.
+     *
+     * \return The number of arguments read.
+     * \exception OSCPP::UnderrunError stream buffer underrun.
+     */
+    size_t float32s(float* out, size_t count)
+    {
+        size_t done = 0;
+        while (done < count)
+        {
+            const char   t   = m_tags.atEnd() ? '\0' : m_tags.peekChar();
+            const size_t run = numericRun(t, count - done);
+            if (run == 0)
+                break;
+            m_args.getFloat32Array(out + done, run);
+            if (t == 'i')
+            {
+                for (size_t i = done; i < done + run; i++)
+                {
+                    int32_t x;
+                    std::memcpy(&x, &out[i], 4);
+                    out[i] = (float)x;
+                }
+            }
+            m_tags.skip(run);
+            done += run;
+        }
+        return done;
+    }
+
+    //! Get a run of numerical arguments as integers.
+    /*!
+     * Read up to count consecutive int or float arguments into out,
+     * converting floats like int32() does. See float32s().
+     *
+     * \return The number of arguments read.
+     * \exception OSCPP::UnderrunError stream buffer underrun.
+     */
+    size_t int32s(int32_t* out, size_t count)
+    {
+        size_t done = 0;
+        while (done < count)
+        {
+            const char   t   = m_tags.atEnd() ? '\0' : m_tags.peekChar();
+            const size_t run = numericRun(t, count - done);
+            if (run == 0)
+                break;
+            m_args.getInt32Array(out + done, run);
+            if (t == 'f')
+            {
+                for (size_t i = done; i < done + run; i++)
+                {
+                    float x;
+                    std::memcpy(&x, &out[i], 4);
+                    out[i] = (int32_t)x;
+                }
+            }
+            m_tags.skip(run);
+            done += run;
+        }
+        return done;
+    }
+
+    //! Get a blob argument holding big-endian 32 bit floats.
+    /*!
+     * Decode up to count floats of the next blob argument into out with
+     * bulk byte swapping. The blob is consumed completely.
+     *
+     * \return The number of floats in the blob, which may exceed count.
+     * \exception OSCPP::UnderrunError stream buffer underrun.
+     * \exception OSCPP::ParseError argument is not a blob or its size is not
+     * a multiple of 4.
+     */
+    size_t float32Blob(float* out, size_t count)
+    {
+        const Blob b = blob();
+        if (b.size() % 4 != 0)
+            throw ParseError("Blob size is not a multiple of 4");
+        const size_t n = b.size() / 4;
+        convert32Array<NetworkByteOrder>(b.data(), out, std::min(n, count));
+        return n;
+    }
+
     template <typename T> T next()
     {
         return T::OSC_Server_ArgStream_next_unimplemented;
     }
 
 private:
+    // The length of the run of numerical tag t at the start of the tags, at
+    // most count.
+    size_t numericRun(char t, size_t count) const
+    {
+        if (t != 'i' && t != 'f')
+            return 0;
+        const char*  tags  = m_tags.pos();
+        const size_t limit = std::min(count, m_tags.consumable());
+        size_t       run   = 1;
+        while (run < limit && tags[run] == t)
+            run++;
+        return run;
+    }
     // Parse a blob (type tag already consumed).
     Blob parseBlob()
     {
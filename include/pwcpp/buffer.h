@@ -107,6 +107,19 @@ public:
       : buffer(nullptr), port(nullptr), buffer_enqueue(buffer_enqueue),
         pod_converter(pod_converter) {}
 
+  /*! \brief Construct a buffer for testing output.
+   *
+   * \param buffer_enqueue The function to enqueue the buffer.
+   * \param pod_converter The function to convert the buffer to a pod.
+   * \param spa_data_provider The function to provide the spa data for
+   * writing.
+   */
+  Buffer(pipewire_buffer_enqueue buffer_enqueue,
+         pipewire_pod_converter pod_converter,
+         pwcpp::spa_data_provider spa_data_provider)
+      : buffer(nullptr), port(nullptr), buffer_enqueue(buffer_enqueue),
+        pod_converter(pod_converter), spa_data_provider(spa_data_provider) {}
+
   /*! \brief Get the pod from the data in the buffer at the given
    * index for reading .
    *
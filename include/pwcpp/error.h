@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstring>
 #include <format>
 #include <string>
 
@@ -15,6 +16,13 @@ enum class error_type {
   NOT_IMPLEMENTED,
   ERROR_HANDLING_PROPERTY,
   PARAMETER_NOT_FOUND,
+  SEQUENCE_WRITING_OFFSET_NOT_ASCENDING,
+  SEQUENCE_WRITING_BUFFER_OVERFLOW,
+  SEQUENCE_MERGING_TOO_MANY_SEQUENCES,
+  OSC_INVALID_ADDRESS_PATTERN,
+  OSC_PATTERNS_TOO_COMPLEX,
+  OSC_SOCKET_ERROR,
+  OSC_SEND_QUEUE_FULL,
 };
 
 /*! \brief An error.
@@ -70,5 +78,69 @@ struct error {
       error_type::PARAMETER_NOT_FOUND
     };
   }
+
+  /*! \brief Create an error to indicate that a control was written with a
+   * smaller offset than the control before it. */
+  static struct error sequence_writing_offset_not_ascending() {
+    return {
+      "Sequence control offsets must be ascending",
+      error_type::SEQUENCE_WRITING_OFFSET_NOT_ASCENDING
+    };
+  }
+
+  /*! \brief Create an error to indicate that a control does not fit into the
+   * buffer of the sequence. */
+  static struct error sequence_writing_buffer_overflow() {
+    return {
+      "Sequence buffer overflow", error_type::SEQUENCE_WRITING_BUFFER_OVERFLOW
+    };
+  }
+
+  /*! \brief Create an error to indicate that more sequences were merged than
+   * the merger has room for. */
+  static struct error sequence_merging_too_many_sequences() {
+    return {
+      "Too many sequences to merge",
+      error_type::SEQUENCE_MERGING_TOO_MANY_SEQUENCES
+    };
+  }
+
+  /*! \brief Create an error to indicate that an OSC address pattern is not
+   * valid. */
+  static struct error osc_invalid_address_pattern() {
+    return {
+      "Invalid OSC address pattern", error_type::OSC_INVALID_ADDRESS_PATTERN
+    };
+  }
+
+  /*! \brief Create an error to indicate that a set of OSC address patterns
+   * compiles to more states than allowed. */
+  static struct error osc_patterns_too_complex() {
+    return {
+      "OSC address patterns are too complex",
+      error_type::OSC_PATTERNS_TOO_COMPLEX
+    };
+  }
+
+  /*! \brief Create an error to indicate that a socket operation of an OSC
+   * endpoint failed.
+   *
+   * \param operation The failed operation, e.g. "bind".
+   * \param error_number The errno of the failure.
+   */
+  static struct error osc_socket(const std::string &operation,
+                                 const int error_number) {
+    return {
+      std::format("OSC socket {} failed: {}", operation,
+                  std::strerror(error_number)),
+      error_type::OSC_SOCKET_ERROR
+    };
+  }
+
+  /*! \brief Create an error to indicate that all send buffers of an OSC
+   * endpoint are in use. */
+  static struct error osc_send_queue_full() {
+    return {"OSC send queue full", error_type::OSC_SEND_QUEUE_FULL};
+  }
 };
 } // namespace pwcpp
@@ -0,0 +1,246 @@
+#pragma once
+
+#include "pwcpp/midi/message.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <variant>
+
+namespace pwcpp::midi {
+
+/*! \brief Which events of a controller are kept when coalescing. */
+enum class coalesce_mode {
+  /*! \brief Only the last event of every controller. */
+  LAST,
+  /*! \brief The first and the last event of every controller, keeps the
+   * start of a sweep at its original offset. */
+  FIRST_AND_LAST,
+};
+
+namespace detail {
+inline constexpr uint32_t coalesce_keys = 2 * 16 * 128 + 2 * 16;
+
+/*! \brief A dense key for the messages that are coalesced: control changes,
+ * poly pressure, pitch bend and channel pressure. Notes, program changes and
+ * registered or assignable controllers, which are sent as deliberate
+ * parameter changes, are left alone. */
+inline std::optional<uint32_t> coalesce_key(const midi::message &message) {
+  return std::visit(
+      [](const auto &m) -> std::optional<uint32_t> {
+        using T = std::decay_t<decltype(m)>;
+        const uint32_t channel = m.channel & 0x0f;
+        if constexpr (std::is_same_v<T, control_change>) {
+          return channel << 7 | (m.cc_number & 0x7f);
+        } else if constexpr (std::is_same_v<T, poly_pressure>) {
+          return 2048 + (channel << 7 | (m.note & 0x7f));
+        } else if constexpr (std::is_same_v<T, pitch_bend>) {
+          return 4096 + channel;
+        } else if constexpr (std::is_same_v<T, channel_pressure>) {
+          return 4112 + channel;
+        } else {
+          return std::nullopt;
+        }
+      },
+      message);
+}
+} // namespace detail
+
+/*! \brief Collapses redundant controller events of a cycle.
+ *
+ * Control changes, poly pressure, pitch bend and channel pressure of the
+ * same channel and number within one cycle are reduced to the last, or the
+ * first and the last, event. All other messages pass unchanged and the order
+ * of the kept messages doesn't change.
+ *
+ * The table of seen controllers is stamped with a generation that increases
+ * every cycle, so it never has to be cleared.
+ */
+class Coalescer {
+public:
+  explicit Coalescer(coalesce_mode mode = coalesce_mode::LAST) : mode(mode) {}
+
+  /*! \brief Coalesce the messages of one cycle in place.
+   *
+   * \return The number of kept messages, they are moved to the front.
+   */
+  std::size_t coalesce(std::span<timed_message> messages) {
+    if (++generation == 0) {
+      entries.fill({});
+      generation = 1;
+    }
+
+    for (std::size_t i = 0; i < messages.size(); ++i) {
+      if (auto key = detail::coalesce_key(messages[i].message)) {
+        auto &entry = entries[key.value()];
+        if (entry.generation != generation) {
+          entry = {generation, static_cast<uint32_t>(i),
+                   static_cast<uint32_t>(i)};
+        } else {
+          entry.last = static_cast<uint32_t>(i);
+        }
+      }
+    }
+
+    std::size_t kept(0);
+    for (std::size_t i = 0; i < messages.size(); ++i) {
+      if (auto key = detail::coalesce_key(messages[i].message)) {
+        const auto &entry = entries[key.value()];
+        if (i != entry.last &&
+            (mode == coalesce_mode::LAST || i != entry.first)) {
+          continue;
+        }
+      }
+
+      if (kept != i) {
+        messages[kept] = messages[i];
+      }
+      kept++;
+    }
+
+    return kept;
+  }
+
+private:
+  struct entry {
+    uint32_t generation = 0;
+    uint32_t first = 0;
+    uint32_t last = 0;
+  };
+
+  coalesce_mode mode;
+  uint32_t generation = 0;
+  std::array<entry, detail::coalesce_keys> entries{};
+};
+
+/*! \brief Limits the rate of controller events.
+ *
+ * An event of a controller is only passed if at least the configured
+ * interval elapsed since the last passed event of the same controller.
+ * Otherwise it becomes the pending event of the controller, replacing an
+ * older pending one. A pending event is sent at offset 0 of the first cycle
+ * that starts after its interval elapsed, so the final value of a sweep is
+ * never lost. The same messages as for Coalescer are limited, all others
+ * pass.
+ */
+class RateLimiter {
+public:
+  /*! \brief Construct a rate limiter.
+   *
+   * \param default_interval The minimum interval in samples between two
+   * events of every controller, 0 passes all events.
+   */
+  explicit RateLimiter(const uint32_t default_interval = 0) {
+    for (auto &state : states) {
+      state.interval = default_interval;
+    }
+  }
+
+  /*! \brief Set the interval of a control change controller. */
+  void set_control_change_interval(const uint8_t channel,
+                                   const uint8_t cc_number,
+                                   const uint32_t interval) {
+    states[(channel & 0x0f) << 7 | (cc_number & 0x7f)].interval = interval;
+  }
+
+  /*! \brief Set the interval of the pitch bend of a channel. */
+  void set_pitch_bend_interval(const uint8_t channel, const uint32_t interval) {
+    states[4096 + (channel & 0x0f)].interval = interval;
+  }
+
+  /*! \brief Limit the messages of one cycle.
+   *
+   * \param cycle_start The position of the first sample of the cycle, e.g.
+   * `spa_io_position::clock.position`.
+   * \param in The messages of the cycle in offset order.
+   * \param out Receives the passed messages, pending messages that are due
+   * come first.
+   *
+   * \return The number of messages written to `out`. Messages that don't fit
+   * are dropped and counted.
+   */
+  std::size_t limit(const uint64_t cycle_start,
+                    std::span<const timed_message> in,
+                    std::span<timed_message> out) {
+    std::size_t written(0);
+    auto emit = [&](const timed_message &message) {
+      if (written < out.size()) {
+        out[written++] = message;
+      } else {
+        dropped_messages++;
+      }
+    };
+
+    for (std::size_t i = 0; i < pending_count;) {
+      auto &state = states[pending_keys[i]];
+      if (cycle_start >= state.last_sent + state.interval) {
+        emit({0, state.pending});
+        state.last_sent = cycle_start;
+        state.has_pending = false;
+        pending_keys[i] = pending_keys[--pending_count];
+      } else {
+        ++i;
+      }
+    }
+
+    for (const auto &message : in) {
+      auto key = detail::coalesce_key(message.message);
+      if (!key.has_value()) {
+        emit(message);
+        continue;
+      }
+
+      auto &state = states[key.value()];
+      const uint64_t time = cycle_start + message.offset;
+      if (!state.sent || time >= state.last_sent + state.interval) {
+        emit(message);
+        state.sent = true;
+        state.last_sent = time;
+        if (state.has_pending) {
+          state.has_pending = false;
+          remove_pending(key.value());
+        }
+        continue;
+      }
+
+      state.pending = message.message;
+      if (!state.has_pending) {
+        state.has_pending = true;
+        pending_keys[pending_count++] = static_cast<uint16_t>(key.value());
+      }
+    }
+
+    return written;
+  }
+
+  /*! \brief The number of messages dropped because `out` was full. */
+  [[nodiscard]] std::size_t dropped() const { return dropped_messages; }
+
+private:
+  struct state {
+    uint32_t interval = 0;
+    bool sent = false;
+    bool has_pending = false;
+    uint64_t last_sent = 0;
+    midi::message pending;
+  };
+
+  void remove_pending(const uint32_t key) {
+    for (std::size_t i = 0; i < pending_count; ++i) {
+      if (pending_keys[i] == key) {
+        pending_keys[i] = pending_keys[--pending_count];
+        return;
+      }
+    }
+  }
+
+  std::array<state, detail::coalesce_keys> states{};
+  std::array<uint16_t, detail::coalesce_keys> pending_keys{};
+  std::size_t pending_count = 0;
+  std::size_t dropped_messages = 0;
+};
+
+} // namespace pwcpp::midi
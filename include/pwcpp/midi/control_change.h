@@ -10,6 +10,8 @@ struct control_change {
   uint8_t channel;
   uint8_t cc_number;
   uint32_t value;
+
+  bool operator==(const control_change &) const = default;
 };
 
 inline void print(const control_change &control_change) {
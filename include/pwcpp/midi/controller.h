@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <ostream>
+
+namespace pwcpp::midi {
+/*! \brief A registered parameter number (RPN) change. */
+struct registered_controller {
+  uint8_t channel;
+  uint8_t bank;
+  uint8_t index;
+  uint32_t value;
+
+  bool operator==(const registered_controller &) const = default;
+};
+
+/*! \brief A non-registered parameter number (NRPN) change. */
+struct assignable_controller {
+  uint8_t channel;
+  uint8_t bank;
+  uint8_t index;
+  uint32_t value;
+
+  bool operator==(const assignable_controller &) const = default;
+};
+
+inline void print(const registered_controller &controller) {
+  std::cout << "registered_controller{channel = "
+            << static_cast<int>(controller.channel)
+            << ", bank = " << static_cast<int>(controller.bank)
+            << ", index = " << static_cast<int>(controller.index)
+            << ", value = " << controller.value << "}" << std::endl;
+}
+
+inline void print(const assignable_controller &controller) {
+  std::cout << "assignable_controller{channel = "
+            << static_cast<int>(controller.channel)
+            << ", bank = " << static_cast<int>(controller.bank)
+            << ", index = " << static_cast<int>(controller.index)
+            << ", value = " << controller.value << "}" << std::endl;
+}
+} // namespace pwcpp::midi
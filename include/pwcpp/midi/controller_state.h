@@ -0,0 +1,328 @@
+#pragma once
+
+#include "pwcpp/midi/message.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <variant>
+
+namespace pwcpp::midi {
+
+/*! \brief The current controller values of all 16 channels.
+ *
+ * The state is updated from the messages of `parse_midi`, `parse_midi_batch`
+ * or `Translator::parse` and read by the signal processing. Control changes
+ * are kept in a dense 16 x 128 table, registered and assignable controllers
+ * in a fixed capacity hash map per kind. All reads are O(1) and nothing is
+ * allocated, so the state can be used inside the process callback.
+ *
+ * Every update marks the controller as dirty. Dirty controllers can be
+ * visited with ControllerState::for_each_dirty, which clears the marks.
+ *
+ * \tparam PARAMETER_CAPACITY The number of registered and assignable
+ * controllers that are kept, each.
+ */
+template <std::size_t PARAMETER_CAPACITY = 64> class ControllerState {
+public:
+  static constexpr std::size_t channels = 16;
+  static constexpr std::size_t controllers = 128;
+
+  static_assert(std::has_single_bit(PARAMETER_CAPACITY),
+                "The parameter capacity has to be a power of two.");
+
+  /*! \brief The kind of a parameter controller. */
+  enum class parameter_type : uint8_t { REGISTERED, ASSIGNABLE };
+
+  ControllerState() { clear(); }
+
+  /*! \brief Reset all values and dirty marks. */
+  void clear() {
+    for (auto &values : controller_values) {
+      values.fill(0);
+    }
+    controller_received.fill({});
+    controller_dirty.fill({});
+    pitch_bend_values.fill(0x80000000u);
+    channel_pressure_values.fill(0);
+    programs.fill(std::nullopt);
+    channel_dirty = 0;
+    for (auto &map : parameters) {
+      map.clear();
+    }
+  }
+
+  /*! \brief Apply a message to the state.
+   *
+   * Messages that don't change controllers, like notes, are ignored.
+   */
+  void update(const midi::message &message) {
+    std::visit(
+        [this](const auto &m) {
+          using T = std::decay_t<decltype(m)>;
+          if constexpr (std::is_same_v<T, control_change>) {
+            update_controller(m.channel & 0x0f, m.cc_number & 0x7f, m.value);
+          } else if constexpr (std::is_same_v<T, pitch_bend>) {
+            pitch_bend_values[m.channel & 0x0f] = m.value;
+            channel_dirty |= 1u << (m.channel & 0x0f);
+          } else if constexpr (std::is_same_v<T, channel_pressure>) {
+            channel_pressure_values[m.channel & 0x0f] = m.value;
+            channel_dirty |= 1u << (m.channel & 0x0f);
+          } else if constexpr (std::is_same_v<T, program_change>) {
+            programs[m.channel & 0x0f] = m;
+            channel_dirty |= 1u << (m.channel & 0x0f);
+          } else if constexpr (std::is_same_v<T, registered_controller>) {
+            parameters[0].insert(parameter_key(m.channel, m.bank, m.index),
+                                 m.value);
+          } else if constexpr (std::is_same_v<T, assignable_controller>) {
+            parameters[1].insert(parameter_key(m.channel, m.bank, m.index),
+                                 m.value);
+          }
+        },
+        message);
+  }
+
+  /*! \brief Apply the messages in order. */
+  void update(std::span<const timed_message> messages) {
+    for (const auto &message : messages) {
+      update(message.message);
+    }
+  }
+
+  /*! \brief Apply the messages returned by `parse_midi` in order. */
+  template <std::size_t MAX_N>
+  void update(const std::array<std::optional<midi::message>, MAX_N> &messages) {
+    for (const auto &message : messages) {
+      if (message.has_value()) {
+        update(message.value());
+      }
+    }
+  }
+
+  /*! \brief The value of a controller with midi 2.0 resolution. */
+  [[nodiscard]] uint32_t value(const uint8_t channel,
+                               const uint8_t cc_number) const {
+    return controller_values[channel & 0x0f][cc_number & 0x7f];
+  }
+
+  /*! \brief The 14 bit value of controller 0 - 31 and its LSB controller.
+   *
+   * If the LSB controller was received after the last change of the MSB
+   * controller both are combined, as a midi 1.0 device sends them. Otherwise
+   * the upper 14 bit of the value are returned.
+   */
+  [[nodiscard]] uint16_t value_14_bit(const uint8_t channel,
+                                      const uint8_t cc_number) const {
+    const auto c = channel & 0x0f;
+    const auto msb = cc_number & 0x1f;
+    const auto lsb = msb + 32;
+    const uint32_t msb_value = controller_values[c][msb];
+    if (!is_set(controller_received[c], lsb)) {
+      return static_cast<uint16_t>(msb_value >> 18);
+    }
+
+    return static_cast<uint16_t>((msb_value >> 25) << 7 |
+                                 controller_values[c][lsb] >> 25);
+  }
+
+  /*! \brief Check whether a controller was received since the last clear. */
+  [[nodiscard]] bool received(const uint8_t channel,
+                              const uint8_t cc_number) const {
+    return is_set(controller_received[channel & 0x0f], cc_number & 0x7f);
+  }
+
+  /*! \brief The pitch bend of a channel, centered at 0x80000000. */
+  [[nodiscard]] uint32_t pitch_bend_value(const uint8_t channel) const {
+    return pitch_bend_values[channel & 0x0f];
+  }
+
+  /*! \brief The channel pressure of a channel. */
+  [[nodiscard]] uint32_t channel_pressure_value(const uint8_t channel) const {
+    return channel_pressure_values[channel & 0x0f];
+  }
+
+  /*! \brief The last program change of a channel, if any. */
+  [[nodiscard]] const std::optional<program_change> &
+  program(const uint8_t channel) const {
+    return programs[channel & 0x0f];
+  }
+
+  /*! \brief The value of a registered or assignable controller, if it was
+   * received. */
+  [[nodiscard]] std::optional<uint32_t>
+  parameter(const parameter_type type, const uint8_t channel,
+            const uint8_t bank, const uint8_t index) const {
+    return parameters[static_cast<std::size_t>(type)].find(
+        parameter_key(channel, bank, index));
+  }
+
+  /*! \brief The number of parameter changes that were dropped because the
+   * map of their kind was full. */
+  [[nodiscard]] std::size_t dropped_parameters() const {
+    return parameters[0].dropped + parameters[1].dropped;
+  }
+
+  /*! \brief Check whether a controller changed since it was last visited. */
+  [[nodiscard]] bool dirty(const uint8_t channel,
+                           const uint8_t cc_number) const {
+    return is_set(controller_dirty[channel & 0x0f], cc_number & 0x7f);
+  }
+
+  /*! \brief Visit the controllers that changed since the last visit in
+   * channel and controller order and clear their dirty marks.
+   *
+   * \param f Called with channel, controller number and value.
+   */
+  template <typename F> void for_each_dirty(F &&f) {
+    for (uint8_t channel = 0; channel < channels; ++channel) {
+      for (std::size_t word = 0; word < 2; ++word) {
+        auto bits = controller_dirty[channel][word];
+        controller_dirty[channel][word] = 0;
+        while (bits != 0) {
+          const auto cc_number =
+              static_cast<uint8_t>(word * 64 + std::countr_zero(bits));
+          f(channel, cc_number, controller_values[channel][cc_number]);
+          bits &= bits - 1;
+        }
+      }
+    }
+  }
+
+  /*! \brief Visit the registered or assignable controllers that changed since
+   * the last visit and clear their dirty marks.
+   *
+   * \param f Called with channel, bank, index and value.
+   */
+  template <typename F>
+  void for_each_dirty_parameter(const parameter_type type, F &&f) {
+    auto &map = parameters[static_cast<std::size_t>(type)];
+    for (std::size_t word = 0; word < map.dirty.size(); ++word) {
+      auto bits = map.dirty[word];
+      map.dirty[word] = 0;
+      while (bits != 0) {
+        const auto slot = word * 64 + std::countr_zero(bits);
+        const auto key = map.keys[slot];
+        f(static_cast<uint8_t>(key >> 14), static_cast<uint8_t>(key >> 7 & 0x7f),
+          static_cast<uint8_t>(key & 0x7f), map.values[slot]);
+        bits &= bits - 1;
+      }
+    }
+  }
+
+  /*! \brief The channels whose pitch bend, channel pressure or program
+   * changed since the last call, one bit per channel. Clears the marks. */
+  uint16_t take_dirty_channels() {
+    const auto dirty = channel_dirty;
+    channel_dirty = 0;
+    return dirty;
+  }
+
+private:
+  using bitset_128 = std::array<uint64_t, 2>;
+
+  static bool is_set(const bitset_128 &bits, const std::size_t bit) {
+    return (bits[bit >> 6] >> (bit & 63) & 1) != 0;
+  }
+
+  static void set(bitset_128 &bits, const std::size_t bit) {
+    bits[bit >> 6] |= uint64_t(1) << (bit & 63);
+  }
+
+  static void reset(bitset_128 &bits, const std::size_t bit) {
+    bits[bit >> 6] &= ~(uint64_t(1) << (bit & 63));
+  }
+
+  void update_controller(const uint8_t channel, const uint8_t cc_number,
+                         const uint32_t value) {
+    controller_values[channel][cc_number] = value;
+    set(controller_received[channel], cc_number);
+    set(controller_dirty[channel], cc_number);
+
+    // A new MSB invalidates the LSB, midi 1.0 devices send the LSB after it.
+    if (cc_number < 32) {
+      reset(controller_received[channel], cc_number + 32);
+    } else if (cc_number < 64) {
+      set(controller_dirty[channel], cc_number - 32);
+    }
+  }
+
+  static constexpr uint32_t parameter_key(const uint8_t channel,
+                                          const uint8_t bank,
+                                          const uint8_t index) {
+    return static_cast<uint32_t>(channel & 0x0f) << 14 |
+           static_cast<uint32_t>(bank & 0x7f) << 7 | (index & 0x7f);
+  }
+
+  /*! \brief Open addressing hash map with linear probing, entries are never
+   * removed. */
+  struct parameter_map {
+    static constexpr uint32_t empty = 0xffffffffu;
+
+    std::array<uint32_t, PARAMETER_CAPACITY> keys;
+    std::array<uint32_t, PARAMETER_CAPACITY> values;
+    std::array<uint64_t, (PARAMETER_CAPACITY + 63) / 64> dirty;
+    std::size_t size;
+    std::size_t dropped;
+
+    void clear() {
+      keys.fill(empty);
+      values.fill(0);
+      dirty.fill(0);
+      size = 0;
+      dropped = 0;
+    }
+
+    static std::size_t hash(const uint32_t key) {
+      return (key * 0x9e3779b1u) >> 8;
+    }
+
+    void insert(const uint32_t key, const uint32_t value) {
+      for (std::size_t probe = 0; probe < PARAMETER_CAPACITY; ++probe) {
+        const auto slot = (hash(key) + probe) & (PARAMETER_CAPACITY - 1);
+        if (keys[slot] == empty) {
+          keys[slot] = key;
+          size++;
+        } else if (keys[slot] != key) {
+          continue;
+        }
+
+        values[slot] = value;
+        dirty[slot >> 6] |= uint64_t(1) << (slot & 63);
+        return;
+      }
+
+      dropped++;
+    }
+
+    [[nodiscard]] std::optional<uint32_t> find(const uint32_t key) const {
+      for (std::size_t probe = 0; probe < PARAMETER_CAPACITY; ++probe) {
+        const auto slot = (hash(key) + probe) & (PARAMETER_CAPACITY - 1);
+        if (keys[slot] == key) {
+          return values[slot];
+        }
+
+        if (keys[slot] == empty) {
+          break;
+        }
+      }
+
+      return std::nullopt;
+    }
+  };
+
+  alignas(64) std::array<std::array<uint32_t, controllers>, channels>
+      controller_values;
+  std::array<bitset_128, channels> controller_received;
+  std::array<bitset_128, channels> controller_dirty;
+  std::array<uint32_t, channels> pitch_bend_values;
+  std::array<uint32_t, channels> channel_pressure_values;
+  std::array<std::optional<program_change>, channels> programs;
+  uint16_t channel_dirty;
+  std::array<parameter_map, 2> parameters;
+};
+
+} // namespace pwcpp::midi
@@ -1,12 +1,28 @@
 #pragma once
 
 #include "pwcpp/midi/control_change.h"
+#include "pwcpp/midi/controller.h"
 #include "pwcpp/midi/note.h"
+#include "pwcpp/midi/pitch_bend.h"
+#include "pwcpp/midi/pressure.h"
+#include "pwcpp/midi/program_change.h"
 
+#include <cstdint>
 #include <variant>
 
 namespace pwcpp::midi {
-using message = std::variant<control_change, note_off, note_on>;
+using message =
+    std::variant<control_change, note_off, note_on, poly_pressure,
+                 channel_pressure, pitch_bend, program_change,
+                 registered_controller, assignable_controller>;
+
+/*! \brief A midi message together with its sample offset in the cycle. */
+struct timed_message {
+  uint32_t offset;
+  midi::message message;
+
+  bool operator==(const timed_message &) const = default;
+};
 
 inline void print(message &message) {
   std::visit([](auto &m) { print(m); }, message);
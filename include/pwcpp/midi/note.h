@@ -9,12 +9,16 @@ struct note_on {
   uint8_t channel;
   uint8_t note;
   uint16_t velocity;
+
+  bool operator==(const note_on &) const = default;
 };
 
 struct note_off {
   uint8_t channel;
   uint8_t note;
   uint16_t velocity;
+
+  bool operator==(const note_off &) const = default;
 };
 
 inline void print(const note_on &note) {
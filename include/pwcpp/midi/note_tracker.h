@@ -0,0 +1,158 @@
+#pragma once
+
+#include "pwcpp/midi/message.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <variant>
+
+namespace pwcpp::midi {
+
+/*! \brief The controller number of the sustain pedal. */
+inline constexpr uint8_t sustain_pedal = 64;
+
+/*! \brief Check whether a sustain pedal value with midi 2.0 resolution means
+ * the pedal is down. */
+constexpr bool is_pedal_down(const uint32_t value) {
+  return value >= 0x80000000u;
+}
+
+/*! \brief Tracks the sounding notes of all channels.
+ *
+ * A note sounds while its key is held or, after its key was released, while
+ * the sustain pedal of its channel is down. The tracker keeps a bitset of
+ * held and sustained notes and the velocity of every note, so queries are
+ * O(1) and nothing is allocated.
+ */
+class NoteTracker {
+public:
+  /*! \brief Apply a message, only notes and the sustain pedal matter. */
+  void update(const midi::message &message) {
+    std::visit(
+        [this](const auto &m) {
+          using T = std::decay_t<decltype(m)>;
+          const auto channel = m.channel & 0x0f;
+          if constexpr (std::is_same_v<T, note_on>) {
+            set(held[channel], m.note & 0x7f);
+            reset(sustained[channel], m.note & 0x7f);
+            velocities[channel][m.note & 0x7f] = m.velocity;
+          } else if constexpr (std::is_same_v<T, note_off>) {
+            if (is_set(held[channel], m.note & 0x7f)) {
+              reset(held[channel], m.note & 0x7f);
+              if (pedal[channel]) {
+                set(sustained[channel], m.note & 0x7f);
+              }
+            }
+          } else if constexpr (std::is_same_v<T, control_change>) {
+            if (m.cc_number == sustain_pedal) {
+              pedal[channel] = is_pedal_down(m.value);
+              if (!pedal[channel]) {
+                sustained[channel] = {};
+              }
+            }
+          }
+        },
+        message);
+  }
+
+  /*! \brief Check whether the key of a note is held. */
+  [[nodiscard]] bool is_held(const uint8_t channel, const uint8_t note) const {
+    return is_set(held[channel & 0x0f], note & 0x7f);
+  }
+
+  /*! \brief Check whether a note is held or sustained. */
+  [[nodiscard]] bool is_sounding(const uint8_t channel,
+                                 const uint8_t note) const {
+    return is_set(held[channel & 0x0f], note & 0x7f) ||
+           is_set(sustained[channel & 0x0f], note & 0x7f);
+  }
+
+  /*! \brief Check whether the sustain pedal of a channel is down. */
+  [[nodiscard]] bool is_sustained(const uint8_t channel) const {
+    return pedal[channel & 0x0f];
+  }
+
+  /*! \brief The velocity of the last note on of a note. */
+  [[nodiscard]] uint16_t velocity(const uint8_t channel,
+                                  const uint8_t note) const {
+    return velocities[channel & 0x0f][note & 0x7f];
+  }
+
+  /*! \brief The number of sounding notes of a channel. */
+  [[nodiscard]] std::size_t sounding(const uint8_t channel) const {
+    const auto &h = held[channel & 0x0f];
+    const auto &s = sustained[channel & 0x0f];
+    return std::popcount(h[0] | s[0]) + std::popcount(h[1] | s[1]);
+  }
+
+  /*! \brief Visit the sounding notes in channel and note order.
+   *
+   * \param f Called with channel, note and velocity.
+   */
+  template <typename F> void for_each_sounding(F &&f) const {
+    for (uint8_t channel = 0; channel < 16; ++channel) {
+      for (std::size_t word = 0; word < 2; ++word) {
+        auto bits = held[channel][word] | sustained[channel][word];
+        while (bits != 0) {
+          const auto note =
+              static_cast<uint8_t>(word * 64 + std::countr_zero(bits));
+          f(channel, note, velocities[channel][note]);
+          bits &= bits - 1;
+        }
+      }
+    }
+  }
+
+  /*! \brief Stop all sounding notes, e.g. for panic or when bypassing.
+   *
+   * Emits a note off for every sounding note and a sustain pedal release for
+   * every channel with the pedal down, then clears the state.
+   *
+   * \param emit Called with every message to send.
+   */
+  template <typename F> void all_notes_off(F &&emit) {
+    for_each_sounding([&emit](uint8_t channel, uint8_t note, uint16_t) {
+      emit(midi::message(note_off{channel, note, 0}));
+    });
+
+    for (uint8_t channel = 0; channel < 16; ++channel) {
+      if (pedal[channel]) {
+        emit(midi::message(control_change{channel, sustain_pedal, 0}));
+      }
+    }
+
+    clear();
+  }
+
+  /*! \brief Forget all notes and pedals. */
+  void clear() {
+    held = {};
+    sustained = {};
+    pedal = {};
+  }
+
+private:
+  using bitset_128 = std::array<uint64_t, 2>;
+
+  static bool is_set(const bitset_128 &bits, const std::size_t bit) {
+    return (bits[bit >> 6] >> (bit & 63) & 1) != 0;
+  }
+
+  static void set(bitset_128 &bits, const std::size_t bit) {
+    bits[bit >> 6] |= uint64_t(1) << (bit & 63);
+  }
+
+  static void reset(bitset_128 &bits, const std::size_t bit) {
+    bits[bit >> 6] &= ~(uint64_t(1) << (bit & 63));
+  }
+
+  std::array<bitset_128, 16> held{};
+  std::array<bitset_128, 16> sustained{};
+  std::array<bool, 16> pedal{};
+  std::array<std::array<uint16_t, 128>, 16> velocities{};
+};
+
+} // namespace pwcpp::midi
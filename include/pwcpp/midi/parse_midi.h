@@ -50,6 +50,51 @@ inline std::optional<midi::message> parse_ump_64(const void *data) {
         .velocity = static_cast<uint16_t>((d[1] >> 16) & 0xffff)
       };
     }
+
+    if (status >= 0xa0 && status <= 0xaf) {
+      return poly_pressure{
+        .channel = static_cast<unsigned char>((status & 0x0f)),
+        .note = static_cast<unsigned char>(d[0] >> 8 & 0x7f), .value = d[1]
+      };
+    }
+
+    if (status >= 0xc0 && status <= 0xcf) {
+      return program_change{
+        .channel = static_cast<unsigned char>((status & 0x0f)),
+        .program = static_cast<unsigned char>(d[1] >> 24 & 0x7f),
+        .bank_valid = (d[0] & 0x01) != 0,
+        .bank_msb = static_cast<unsigned char>(d[1] >> 8 & 0x7f),
+        .bank_lsb = static_cast<unsigned char>(d[1] & 0x7f)
+      };
+    }
+
+    if (status >= 0xd0 && status <= 0xdf) {
+      return channel_pressure{
+        .channel = static_cast<unsigned char>((status & 0x0f)), .value = d[1]
+      };
+    }
+
+    if (status >= 0xe0 && status <= 0xef) {
+      return pitch_bend{
+        .channel = static_cast<unsigned char>((status & 0x0f)), .value = d[1]
+      };
+    }
+
+    if (status >= 0x20 && status <= 0x2f) {
+      return registered_controller{
+        .channel = static_cast<unsigned char>((status & 0x0f)),
+        .bank = static_cast<unsigned char>(d[0] >> 8 & 0x7f),
+        .index = static_cast<unsigned char>(d[0] & 0x7f), .value = d[1]
+      };
+    }
+
+    if (status >= 0x30 && status <= 0x3f) {
+      return assignable_controller{
+        .channel = static_cast<unsigned char>((status & 0x0f)),
+        .bank = static_cast<unsigned char>(d[0] >> 8 & 0x7f),
+        .index = static_cast<unsigned char>(d[0] & 0x7f), .value = d[1]
+      };
+    }
   }
 
   return std::nullopt;
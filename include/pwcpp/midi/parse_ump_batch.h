@@ -0,0 +1,349 @@
+#pragma once
+
+#include "pwcpp/buffer.h"
+#include "pwcpp/error.h"
+#include "pwcpp/midi/message.h"
+#include "pwcpp/midi/parse_midi.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <span>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace pwcpp::midi {
+
+/*! \brief 64 bit UMP messages gathered from a sequence.
+ *
+ * The header and payload words are stored in separate arrays so the headers
+ * can be classified with vector instructions.
+ */
+template <std::size_t MAX_N>
+struct ump_64_batch {
+  alignas(32) std::array<uint32_t, MAX_N> headers;
+  alignas(32) std::array<uint32_t, MAX_N> payloads;
+  std::array<uint32_t, MAX_N> offsets;
+  std::size_t size = 0;
+};
+
+namespace detail {
+/*! \brief The status nibbles of the midi 2.0 channel voice messages that
+ * `parse_ump_64` decodes. */
+constexpr std::array<uint32_t, 9> ump_64_decoded_statuses{
+    0x2, 0x3, 0x8, 0x9, 0xa, 0xb, 0xc, 0xd, 0xe};
+
+/*! \brief Extract message type and status nibble from a header word.
+ *
+ * The result is `message_type << 8 | status >> 4`, the group nibble in between
+ * is masked out.
+ */
+constexpr uint32_t ump_64_key(const uint32_t header) {
+  return (header >> 20) & 0xf0f;
+}
+
+/*! \brief Bit `n` is set if status nibble `n` is decoded. */
+constexpr uint32_t ump_64_decoded_status_mask = [] {
+  uint32_t mask = 0;
+  for (auto status : ump_64_decoded_statuses) {
+    mask |= 1u << status;
+  }
+  return mask;
+}();
+
+constexpr bool is_decoded_ump_64(const uint32_t header) {
+  const auto key = ump_64_key(header);
+  for (auto status : ump_64_decoded_statuses) {
+    if (key == (0x400 | status)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/*! \brief Decode a message accepted by `is_decoded_ump_64` in place.
+ *
+ * Extracts the same fields as `parse_ump_64`.
+ */
+inline void decode_ump_64(const uint32_t header, const uint32_t payload,
+                          midi::message &message) {
+  const auto channel = static_cast<uint8_t>((header >> 16) & 0x0f);
+  const auto number = static_cast<uint8_t>(header >> 8 & 0x7f);
+
+  switch ((header >> 20) & 0xf) {
+  case 0x2:
+    message.emplace<registered_controller>(
+        channel, number, static_cast<uint8_t>(header & 0x7f), payload);
+    break;
+  case 0x3:
+    message.emplace<assignable_controller>(
+        channel, number, static_cast<uint8_t>(header & 0x7f), payload);
+    break;
+  case 0x8:
+    message.emplace<note_off>(channel, number,
+                              static_cast<uint16_t>((payload >> 16) & 0xffff));
+    break;
+  case 0x9:
+    message.emplace<note_on>(channel, number,
+                             static_cast<uint16_t>((payload >> 16) & 0xffff));
+    break;
+  case 0xa:
+    message.emplace<poly_pressure>(channel, number, payload);
+    break;
+  case 0xb:
+    message.emplace<control_change>(channel, number, payload);
+    break;
+  case 0xc:
+    message.emplace<program_change>(
+        channel, static_cast<uint8_t>(payload >> 24 & 0x7f),
+        (header & 0x01) != 0, static_cast<uint8_t>(payload >> 8 & 0x7f),
+        static_cast<uint8_t>(payload & 0x7f));
+    break;
+  case 0xd:
+    message.emplace<channel_pressure>(channel, payload);
+    break;
+  default:
+    message.emplace<pitch_bend>(channel, payload);
+    break;
+  }
+}
+
+/*! \brief Lane indices of the set bits of every 8 bit mask, packed into one
+ * byte each. */
+constexpr std::array<uint64_t, 256> make_compaction_table() {
+  std::array<uint64_t, 256> table{};
+  for (uint32_t mask = 0; mask < 256; ++mask) {
+    uint64_t lanes = 0;
+    uint32_t count = 0;
+    for (uint32_t bit = 0; bit < 8; ++bit) {
+      if ((mask >> bit) & 1) {
+        lanes |= static_cast<uint64_t>(bit) << (8 * count++);
+      }
+    }
+    table[mask] = lanes;
+  }
+
+  return table;
+}
+
+inline constexpr std::array<uint64_t, 256> compaction_table =
+    make_compaction_table();
+
+inline std::size_t classify_ump_64_scalar(std::span<const uint32_t> headers,
+                                          std::span<uint32_t> selected,
+                                          std::size_t begin = 0) {
+  std::size_t count(0);
+  for (std::size_t i = begin; i < headers.size(); ++i) {
+    if (is_decoded_ump_64(headers[i])) {
+      selected[count++] = static_cast<uint32_t>(i);
+    }
+  }
+
+  return count;
+}
+
+#if defined(__x86_64__)
+[[gnu::target("sse2")]] inline std::size_t
+classify_ump_64_sse2(std::span<const uint32_t> headers,
+                     std::span<uint32_t> selected) {
+  const __m128i key_mask = _mm_set1_epi32(0xf0f);
+  std::size_t count(0);
+  std::size_t i(0);
+  for (; i + 4 <= headers.size(); i += 4) {
+    const __m128i words = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(headers.data() + i));
+    const __m128i keys = _mm_and_si128(_mm_srli_epi32(words, 20), key_mask);
+    __m128i matches = _mm_setzero_si128();
+    for (auto status : ump_64_decoded_statuses) {
+      matches = _mm_or_si128(
+          matches,
+          _mm_cmpeq_epi32(keys, _mm_set1_epi32(static_cast<int>(0x400 | status))));
+    }
+
+    auto bits =
+        static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(matches)));
+    while (bits != 0) {
+      selected[count++] = static_cast<uint32_t>(i + std::countr_zero(bits));
+      bits &= bits - 1;
+    }
+  }
+
+  auto tail = classify_ump_64_scalar(headers, selected.subspan(count), i);
+  return count + tail;
+}
+
+[[gnu::target("avx2")]] inline std::size_t
+classify_ump_64_avx2(std::span<const uint32_t> headers,
+                     std::span<uint32_t> selected) {
+  const __m256i nibble_mask = _mm256_set1_epi32(0xf);
+  const __m256i message_type = _mm256_set1_epi32(0x4);
+  const __m256i status_mask =
+      _mm256_set1_epi32(static_cast<int>(ump_64_decoded_status_mask));
+  const __m256i one = _mm256_set1_epi32(1);
+  std::size_t count(0);
+  std::size_t i(0);
+  for (; i + 8 <= headers.size(); i += 8) {
+    const __m256i words = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(headers.data() + i));
+    // Look the status nibble up in the mask of decoded statuses.
+    const __m256i statuses =
+        _mm256_and_si256(_mm256_srli_epi32(words, 20), nibble_mask);
+    const __m256i decoded = _mm256_cmpeq_epi32(
+        _mm256_and_si256(_mm256_srlv_epi32(status_mask, statuses), one), one);
+    const __m256i matches = _mm256_and_si256(
+        decoded, _mm256_cmpeq_epi32(_mm256_srli_epi32(words, 28), message_type));
+
+    const auto bits =
+        static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(matches)));
+    if (bits == 0) {
+      continue;
+    }
+
+    // count never exceeds i, so the full eight lanes fit into selected.
+    const __m256i indices = _mm256_add_epi32(
+        _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(
+            static_cast<long long>(compaction_table[bits]))),
+        _mm256_set1_epi32(static_cast<int>(i)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(selected.data() + count),
+                        indices);
+    count += static_cast<std::size_t>(std::popcount(bits));
+  }
+
+  auto tail = classify_ump_64_scalar(headers, selected.subspan(count), i);
+  return count + tail;
+}
+
+inline bool cpu_supports_avx2() {
+  static const bool supported = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+  }();
+  return supported;
+}
+#endif
+} // namespace detail
+
+/*! \brief Select the 64 bit UMP messages that `parse_ump_64` can decode.
+ *
+ * Uses AVX2 or SSE2 when available and falls back to a scalar loop
+ * otherwise. All variants select the same messages.
+ *
+ * \param headers The first word of each message.
+ * \param selected Receives the indices of the decodable messages in
+ * ascending order, must be at least as large as `headers`.
+ *
+ * \return The number of selected messages.
+ */
+inline std::size_t classify_ump_64(std::span<const uint32_t> headers,
+                                   std::span<uint32_t> selected) {
+#if defined(__x86_64__)
+  if (detail::cpu_supports_avx2()) {
+    return detail::classify_ump_64_avx2(headers, selected);
+  }
+
+  return detail::classify_ump_64_sse2(headers, selected);
+#else
+  return detail::classify_ump_64_scalar(headers, selected);
+#endif
+}
+
+/*! \brief Collect the 64 bit UMP controls of a sequence into a batch.
+ *
+ * \return The number of gathered messages or an error if the sequence
+ * contains more than `MAX_N` of them.
+ */
+template <std::size_t MAX_N>
+std::expected<std::size_t, error>
+gather_ump_64(struct spa_pod_sequence *sequence, ump_64_batch<MAX_N> &batch) {
+  std::size_t size(0);
+
+  struct spa_pod_control *pod_control;
+  SPA_POD_SEQUENCE_FOREACH(sequence, pod_control) {
+    if (pod_control->type != SPA_CONTROL_UMP ||
+        SPA_POD_BODY_SIZE(&pod_control->value) != 8) {
+      continue;
+    }
+
+    if (size >= MAX_N) {
+      batch.size = size;
+      return std::unexpected(error::midi_parsing_too_many_messages());
+    }
+
+    uint32_t words[2];
+    std::memcpy(words, SPA_POD_BODY(&pod_control->value), sizeof(words));
+    batch.headers[size] = words[0];
+    batch.payloads[size] = words[1];
+    batch.offsets[size] = pod_control->offset;
+    size++;
+  }
+
+  batch.size = size;
+  return size;
+}
+
+/*! \brief Decode the messages of a batch into timed messages.
+ *
+ * Produces the same messages in the same order as decoding every message
+ * with `parse_ump_64`, but only visits the messages selected by
+ * `classify_ump_64` and constructs them in place.
+ *
+ * \return The number of messages written to `messages`.
+ */
+template <std::size_t MAX_N>
+std::size_t decode_ump_64_batch(const ump_64_batch<MAX_N> &batch,
+                                std::span<timed_message> messages) {
+  std::array<uint32_t, MAX_N> selected;
+  const auto count = classify_ump_64(
+      std::span<const uint32_t>(batch.headers.data(), batch.size), selected);
+
+  std::size_t written(0);
+  for (std::size_t i = 0; i < count && written < messages.size(); ++i) {
+    const auto index = selected[i];
+    auto &message = messages[written++];
+    message.offset = batch.offsets[index];
+    detail::decode_ump_64(batch.headers[index], batch.payloads[index],
+                          message.message);
+  }
+
+  return written;
+}
+
+/*! \brief Parse the midi messages of a buffer in one batch.
+ *
+ * The batch counterpart of `parse_midi`. The messages keep the sample offset
+ * of their control.
+ *
+ * \param buffer The buffer to read the sequence from.
+ * \param messages Receives the decoded messages.
+ *
+ * \return The number of decoded messages.
+ */
+template <std::size_t MAX_N>
+std::expected<std::size_t, error>
+parse_midi_batch(Buffer &buffer, std::array<timed_message, MAX_N> &messages) {
+  auto pod = buffer.get_pod(0);
+
+  if (!pod.has_value()) {
+    return 0;
+  }
+
+  if (!spa_pod_is_sequence(pod.value())) {
+    return std::unexpected(error::midi_parsing_pod_not_a_sequence());
+  }
+
+  ump_64_batch<MAX_N> batch;
+  auto gathered = gather_ump_64(
+      reinterpret_cast<struct spa_pod_sequence *>(pod.value()), batch);
+  if (!gathered.has_value()) {
+    return std::unexpected(gathered.error());
+  }
+
+  return decode_ump_64_batch(batch, messages);
+}
+} // namespace pwcpp::midi
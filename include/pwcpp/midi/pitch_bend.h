@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <ostream>
+
+namespace pwcpp::midi {
+struct pitch_bend {
+  uint8_t channel;
+  uint32_t value;
+
+  bool operator==(const pitch_bend &) const = default;
+};
+
+inline void print(const pitch_bend &pitch_bend) {
+  std::cout << "pitch_bend{channel = " << static_cast<int>(pitch_bend.channel)
+            << ", value = " << pitch_bend.value << "}" << std::endl;
+}
+} // namespace pwcpp::midi
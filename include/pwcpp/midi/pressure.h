@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <ostream>
+
+namespace pwcpp::midi {
+struct poly_pressure {
+  uint8_t channel;
+  uint8_t note;
+  uint32_t value;
+
+  bool operator==(const poly_pressure &) const = default;
+};
+
+struct channel_pressure {
+  uint8_t channel;
+  uint32_t value;
+
+  bool operator==(const channel_pressure &) const = default;
+};
+
+inline void print(const poly_pressure &pressure) {
+  std::cout << "poly_pressure{channel = " << static_cast<int>(pressure.channel)
+            << ", note = " << static_cast<int>(pressure.note)
+            << ", value = " << pressure.value << "}" << std::endl;
+}
+
+inline void print(const channel_pressure &pressure) {
+  std::cout << "channel_pressure{channel = "
+            << static_cast<int>(pressure.channel)
+            << ", value = " << pressure.value << "}" << std::endl;
+}
+} // namespace pwcpp::midi
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <ostream>
+
+namespace pwcpp::midi {
+struct program_change {
+  uint8_t channel;
+  uint8_t program;
+  bool bank_valid;
+  uint8_t bank_msb;
+  uint8_t bank_lsb;
+
+  bool operator==(const program_change &) const = default;
+};
+
+inline void print(const program_change &program_change) {
+  std::cout << "program_change{channel = "
+            << static_cast<int>(program_change.channel)
+            << ", program = " << static_cast<int>(program_change.program)
+            << ", bank_valid = " << program_change.bank_valid
+            << ", bank_msb = " << static_cast<int>(program_change.bank_msb)
+            << ", bank_lsb = " << static_cast<int>(program_change.bank_lsb)
+            << "}" << std::endl;
+}
+} // namespace pwcpp::midi
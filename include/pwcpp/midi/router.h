@@ -0,0 +1,330 @@
+#pragma once
+
+#include "pwcpp/error.h"
+#include "pwcpp/midi/message.h"
+#include "pwcpp/rt/swappable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <initializer_list>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace pwcpp::midi {
+
+/*! \brief The kind of a message, the index of its alternative in
+ * midi::message. */
+enum class message_kind : uint8_t {
+  CONTROL_CHANGE,
+  NOTE_OFF,
+  NOTE_ON,
+  POLY_PRESSURE,
+  CHANNEL_PRESSURE,
+  PITCH_BEND,
+  PROGRAM_CHANGE,
+  REGISTERED_CONTROLLER,
+  ASSIGNABLE_CONTROLLER,
+};
+
+inline constexpr std::size_t message_kinds = std::variant_size_v<message>;
+static_assert(message_kinds ==
+              static_cast<std::size_t>(message_kind::ASSIGNABLE_CONTROLLER) + 1);
+
+/*! \brief A bit mask of message kinds. */
+constexpr uint16_t kind_mask(std::initializer_list<message_kind> kinds) {
+  uint16_t mask(0);
+  for (auto kind : kinds) {
+    mask |= 1u << static_cast<uint8_t>(kind);
+  }
+  return mask;
+}
+
+/*! \brief The number a rule matches on: the controller number, the note, the
+ * program or the index of a registered or assignable controller. Channel
+ * pressure and pitch bend have number 0. */
+inline uint8_t message_number(const midi::message &message) {
+  return std::visit(
+      [](const auto &m) -> uint8_t {
+        using T = std::decay_t<decltype(m)>;
+        if constexpr (std::is_same_v<T, control_change>) {
+          return m.cc_number & 0x7f;
+        } else if constexpr (std::is_same_v<T, program_change>) {
+          return m.program & 0x7f;
+        } else if constexpr (std::is_same_v<T, channel_pressure> ||
+                             std::is_same_v<T, pitch_bend>) {
+          return 0;
+        } else if constexpr (std::is_same_v<T, registered_controller> ||
+                             std::is_same_v<T, assignable_controller>) {
+          return m.index & 0x7f;
+        } else {
+          return m.note & 0x7f;
+        }
+      },
+      message);
+}
+
+/*! \brief An inclusive range. */
+struct route_range {
+  uint8_t first = 0;
+  uint8_t last = 0xff;
+
+  [[nodiscard]] constexpr bool contains(const uint8_t value) const {
+    return value >= first && value <= last;
+  }
+};
+
+/*! \brief The messages a rule applies to. */
+struct route_match {
+  route_range ports{};
+  route_range channels{};
+  uint16_t kinds = 0xffff;
+  route_range numbers{};
+};
+
+/*! \brief What a rule does with a matched message. */
+struct route_action {
+  /*! \brief The output port the message is sent to. */
+  uint8_t output_port = 0;
+  /*! \brief Replaces the channel if set. */
+  std::optional<uint8_t> channel = std::nullopt;
+  /*! \brief Added to the number, messages moved outside of 0 - 127 are
+   * dropped. */
+  int8_t number_offset = 0;
+  /*! \brief The value range in midi 2.0 resolution the full input range is
+   * mapped to. A minimum above the maximum inverts the values. */
+  uint32_t value_minimum = 0;
+  uint32_t value_maximum = 0xffffffff;
+};
+
+/*! \brief Sends every message matched by `match` as described by `action`.
+ */
+struct route_rule {
+  route_match match;
+  route_action action;
+};
+
+/*! \brief The compiled form of a list of rules.
+ *
+ * Every combination of input port, message kind, channel and number has an
+ * entry in a flat table that points to the actions of all rules matching it,
+ * so routing a message costs one lookup independent of the number of rules.
+ * Messages no rule matches are dropped. Compile on the main loop, route in
+ * the process callback.
+ */
+class RouteTable {
+public:
+  /*! \brief Compile the rules for the given number of input ports.
+   *
+   * Rules apply in the given order, a message matched by several rules is
+   * sent several times.
+   *
+   * \return The table, or a configuration error if there are more rules or
+   * distinct sets of matching rules than the 16 bit entries can index.
+   */
+  static std::expected<RouteTable, error>
+  compile(std::span<const route_rule> rules, const uint8_t input_ports) {
+    constexpr std::size_t max_index = std::numeric_limits<uint16_t>::max();
+    if (rules.size() > max_index) {
+      return std::unexpected(error::configuration());
+    }
+
+    RouteTable table(input_ports);
+    auto &entries = table.entries;
+    auto &lists_offsets = table.lists_offsets;
+    auto &actions = table.actions;
+
+    // Index 0 is the empty list of unmatched messages.
+    std::map<std::vector<uint16_t>, uint16_t> lists{{{}, 0}};
+    lists_offsets.push_back({0, 0});
+
+    std::vector<uint16_t> matching;
+    for (std::size_t entry = 0; entry < entries.size(); ++entry) {
+      const auto number = static_cast<uint8_t>(entry & 0x7f);
+      const auto channel = static_cast<uint8_t>(entry >> 7 & 0x0f);
+      const auto kind = (entry >> 11) % message_kinds;
+      const auto port = static_cast<uint8_t>((entry >> 11) / message_kinds);
+
+      matching.clear();
+      for (std::size_t rule = 0; rule < rules.size(); ++rule) {
+        const auto &match = rules[rule].match;
+        if (match.ports.contains(port) && match.channels.contains(channel) &&
+            (match.kinds >> kind & 1) != 0 &&
+            match.numbers.contains(number)) {
+          matching.push_back(static_cast<uint16_t>(rule));
+        }
+      }
+
+      auto list = lists.find(matching);
+      if (list == lists.end()) {
+        if (lists.size() > max_index) {
+          return std::unexpected(error::configuration());
+        }
+        list = lists.emplace(matching, static_cast<uint16_t>(lists.size()))
+                   .first;
+        lists_offsets.push_back(
+            {static_cast<uint32_t>(actions.size()),
+             static_cast<uint32_t>(matching.size())});
+        for (auto rule : matching) {
+          actions.push_back(rules[rule].action);
+        }
+      }
+      entries[entry] = list->second;
+    }
+    return table;
+  }
+
+  /*! \brief Route a message received on an input port.
+   *
+   * \param port The input port of the message.
+   * \param message The message.
+   * \param emit Called with the output port and the transformed message for
+   * every matching rule.
+   */
+  template <typename F>
+  void route(const uint8_t port, const timed_message &message,
+             F &&emit) const {
+    if (port >= input_ports) {
+      return;
+    }
+
+    const auto kind = message.message.index();
+    const auto channel = std::visit(
+        [](const auto &m) { return static_cast<uint8_t>(m.channel & 0x0f); },
+        message.message);
+    const auto number = message_number(message.message);
+    const auto entry =
+        ((port * message_kinds + kind) * 16 + channel) * 128 + number;
+
+    const auto [offset, size] = lists_offsets[entries[entry]];
+    for (uint32_t i = offset; i < offset + size; ++i) {
+      if (auto routed = apply(actions[i], message)) {
+        emit(actions[i].output_port, routed.value());
+      }
+    }
+  }
+
+private:
+  explicit RouteTable(const uint8_t input_ports)
+      : input_ports(input_ports),
+        entries(static_cast<std::size_t>(input_ports) * message_kinds * 16 *
+                    128,
+                0) {}
+
+  static uint32_t scale(const route_action &action, const uint32_t value) {
+    if (action.value_minimum <= action.value_maximum) {
+      const uint64_t range =
+          static_cast<uint64_t>(action.value_maximum - action.value_minimum) +
+          1;
+      return action.value_minimum +
+             static_cast<uint32_t>((value * range) >> 32);
+    }
+
+    const uint64_t range =
+        static_cast<uint64_t>(action.value_minimum - action.value_maximum) + 1;
+    return action.value_minimum - static_cast<uint32_t>((value * range) >> 32);
+  }
+
+  static std::optional<timed_message> apply(const route_action &action,
+                                            const timed_message &message) {
+    timed_message routed = message;
+    bool in_range = true;
+    std::visit(
+        [&](auto &m) {
+          using T = std::decay_t<decltype(m)>;
+          if (action.channel.has_value()) {
+            m.channel = action.channel.value() & 0x0f;
+          }
+
+          auto move = [&](uint8_t &number) {
+            const int moved = number + action.number_offset;
+            in_range = moved >= 0 && moved < 128;
+            number = static_cast<uint8_t>(moved);
+          };
+
+          if constexpr (std::is_same_v<T, control_change>) {
+            move(m.cc_number);
+            m.value = scale(action, m.value);
+          } else if constexpr (std::is_same_v<T, note_on> ||
+                               std::is_same_v<T, note_off>) {
+            move(m.note);
+            const uint32_t velocity = m.velocity;
+            m.velocity = static_cast<uint16_t>(
+                scale(action, velocity << 16 | velocity) >> 16);
+          } else if constexpr (std::is_same_v<T, poly_pressure>) {
+            move(m.note);
+            m.value = scale(action, m.value);
+          } else if constexpr (std::is_same_v<T, program_change>) {
+            move(m.program);
+          } else if constexpr (std::is_same_v<T, registered_controller> ||
+                               std::is_same_v<T, assignable_controller>) {
+            move(m.index);
+            m.value = scale(action, m.value);
+          } else {
+            m.value = scale(action, m.value);
+          }
+        },
+        routed.message);
+
+    if (!in_range) {
+      return std::nullopt;
+    }
+
+    return routed;
+  }
+
+  struct list {
+    uint32_t offset;
+    uint32_t size;
+  };
+
+  uint8_t input_ports;
+  std::vector<uint16_t> entries;
+  std::vector<list> lists_offsets;
+  std::vector<route_action> actions;
+};
+
+/*! \brief Routes midi messages with a rule set that can be replaced while
+ * the filter runs.
+ *
+ * Rule sets are compiled and published on the main loop with
+ * Router::publish, the process callback acquires the current table once per
+ * cycle with Router::acquire.
+ */
+class Router {
+public:
+  /*! \brief Compile the rules and make them visible to the process
+   * callback. Called from the main loop.
+   *
+   * \return The error of RouteTable::compile, the current rules stay in
+   * place then.
+   */
+  std::expected<void, error> publish(std::span<const route_rule> rules,
+                                     const uint8_t input_ports) {
+    auto table = RouteTable::compile(rules, input_ports);
+    if (!table.has_value()) {
+      return std::unexpected(table.error());
+    }
+    tables.publish(std::make_unique<RouteTable>(std::move(table.value())));
+    return {};
+  }
+
+  /*! \brief Destroy replaced tables, called from the main loop. */
+  std::size_t collect() { return tables.collect(); }
+
+  /*! \brief The current table or nullptr if no rules were published.
+   * Called from the process callback. */
+  const RouteTable *acquire() { return tables.acquire(); }
+
+private:
+  rt::Swappable<RouteTable> tables;
+};
+
+} // namespace pwcpp::midi
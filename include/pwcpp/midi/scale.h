@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace pwcpp::midi {
+
+/*! \brief Scale a value to a higher resolution.
+ *
+ * Implements the min-center-max algorithm of the midi 2.0 specification:
+ * minimum, center and maximum of the source range map to minimum, center and
+ * maximum of the destination range. Values above the center repeat their
+ * lower bits to fill the added resolution.
+ *
+ * \param value The value to scale.
+ * \param source_bits The resolution of the value.
+ * \param destination_bits The resolution to scale to, at most 32.
+ *
+ * \return The scaled value.
+ */
+constexpr uint32_t scale_up(const uint32_t value, const uint32_t source_bits,
+                            const uint32_t destination_bits) {
+  const uint32_t scale_bits = destination_bits - source_bits;
+  uint64_t shifted_value = static_cast<uint64_t>(value) << scale_bits;
+  const uint32_t source_center = 1u << (source_bits - 1);
+  if (value <= source_center) {
+    return static_cast<uint32_t>(shifted_value);
+  }
+
+  const uint32_t repeat_bits = source_bits - 1;
+  const uint64_t repeat_mask = (1ull << repeat_bits) - 1;
+  uint64_t repeat_value = value & repeat_mask;
+  if (scale_bits > repeat_bits) {
+    repeat_value <<= scale_bits - repeat_bits;
+  } else {
+    repeat_value >>= repeat_bits - scale_bits;
+  }
+
+  while (repeat_value != 0) {
+    shifted_value |= repeat_value;
+    repeat_value >>= repeat_bits;
+  }
+
+  return static_cast<uint32_t>(shifted_value);
+}
+
+/*! \brief Scale a value to a lower resolution by dropping the low bits. */
+constexpr uint32_t scale_down(const uint32_t value, const uint32_t source_bits,
+                              const uint32_t destination_bits) {
+  return value >> (source_bits - destination_bits);
+}
+
+namespace detail {
+template <typename T, uint32_t DESTINATION_BITS>
+constexpr std::array<T, 128> make_7_bit_scale_table() {
+  std::array<T, 128> table{};
+  for (uint32_t value = 0; value < table.size(); ++value) {
+    table[value] = static_cast<T>(scale_up(value, 7, DESTINATION_BITS));
+  }
+  return table;
+}
+} // namespace detail
+
+/*! \brief 7 bit values scaled to 16 bit, used for velocities. */
+inline constexpr std::array<uint16_t, 128> scale_7_to_16_table =
+    detail::make_7_bit_scale_table<uint16_t, 16>();
+
+/*! \brief 7 bit values scaled to 32 bit, used for controller values. */
+inline constexpr std::array<uint32_t, 128> scale_7_to_32_table =
+    detail::make_7_bit_scale_table<uint32_t, 32>();
+
+constexpr uint16_t scale_7_to_16(const uint8_t value) {
+  return scale_7_to_16_table[value & 0x7f];
+}
+
+constexpr uint32_t scale_7_to_32(const uint8_t value) {
+  return scale_7_to_32_table[value & 0x7f];
+}
+
+constexpr uint32_t scale_14_to_32(const uint16_t value) {
+  return scale_up(value & 0x3fff, 14, 32);
+}
+
+constexpr uint8_t scale_16_to_7(const uint16_t value) {
+  return static_cast<uint8_t>(value >> 9);
+}
+
+constexpr uint8_t scale_32_to_7(const uint32_t value) {
+  return static_cast<uint8_t>(value >> 25);
+}
+
+constexpr uint16_t scale_32_to_14(const uint32_t value) {
+  return static_cast<uint16_t>(value >> 18);
+}
+
+static_assert(scale_7_to_32(0) == 0);
+static_assert(scale_7_to_32(64) == 0x80000000);
+static_assert(scale_7_to_32(127) == 0xffffffff);
+static_assert(scale_7_to_16(127) == 0xffff);
+static_assert(scale_14_to_32(0x2000) == 0x80000000);
+static_assert(scale_14_to_32(0x3fff) == 0xffffffff);
+
+} // namespace pwcpp::midi
@@ -0,0 +1,369 @@
+#pragma once
+
+#include "pwcpp/buffer.h"
+#include "pwcpp/error.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <optional>
+#include <span>
+
+#include <spa/control/control.h>
+#include <spa/pod/iter.h>
+
+namespace pwcpp::midi {
+
+/*! \brief The number of 32 bit words of a UMP with the given first word. */
+constexpr std::size_t ump_message_words(const uint32_t header) {
+  constexpr std::array<uint8_t, 16> words{1, 1, 1, 2, 2, 4, 1, 1,
+                                          2, 2, 2, 3, 3, 4, 4, 4};
+  return words[header >> 28];
+}
+
+/*! \brief Where a system exclusive message came from. */
+enum class sysex_type : uint8_t {
+  /*! \brief Midi 1.0 bytes between 0xf0 and 0xf7. */
+  MIDI_1,
+  /*! \brief 7 bit system exclusive UMP (message type 3). */
+  SYSEX_7,
+  /*! \brief 8 bit system exclusive UMP (message type 5). */
+  SYSEX_8,
+};
+
+/*! \brief A complete system exclusive message.
+ *
+ * The data doesn't include the 0xf0 and 0xf7 framing bytes of midi 1.0. It
+ * points into the memory of the SysexAssembler.
+ */
+struct sysex_message {
+  /*! \brief The sample offset of the control that completed the message. */
+  uint32_t offset;
+  sysex_type type;
+  uint8_t group;
+  /*! \brief The stream id of 8 bit messages, 0 otherwise. */
+  uint8_t stream;
+  std::span<const uint8_t> data;
+};
+
+/*! \brief What happened to the system exclusive messages so far. */
+struct sysex_counters {
+  /*! \brief Messages that were completed. */
+  std::size_t completed = 0;
+  /*! \brief Messages dropped because they were larger than the maximum size.
+   */
+  std::size_t oversized = 0;
+  /*! \brief Messages dropped because all streams were in use. */
+  std::size_t no_stream = 0;
+  /*! \brief Messages dropped because they were interrupted by a new message
+   * or continued without a start. */
+  std::size_t interrupted = 0;
+};
+
+/*! \brief Reassembles system exclusive messages from their fragments.
+ *
+ * Fragments arrive as 7 bit (type 3) or 8 bit (type 5) UMP data messages or
+ * as midi 1.0 bytes and may span several controls and cycles. Every
+ * message in progress is assembled in one of `STREAMS` streams, identified
+ * by type, group and stream id while the message is in progress. Each stream
+ * has a ring of `SLOTS` preallocated slots of `MAX_SIZE` bytes and a new
+ * message starts in the next slot of the stream it is assigned to. The data
+ * of a completed message therefore stays valid until `SLOTS - 1` more
+ * messages were started in the same stream. Nothing is allocated.
+ *
+ * \tparam STREAMS The number of messages that can be assembled at the same
+ * time.
+ * \tparam MAX_SIZE The maximum size of a message, larger messages are
+ * dropped.
+ * \tparam SLOTS The number of slots per stream.
+ */
+template <std::size_t STREAMS = 4, std::size_t MAX_SIZE = 1024,
+          std::size_t SLOTS = 2>
+class SysexAssembler {
+public:
+  /*! \brief Add a 64 bit UMP 7 bit system exclusive message.
+   *
+   * \return The completed message, if this was the last fragment.
+   */
+  std::optional<sysex_message> push_ump_64(const uint32_t offset,
+                                           std::span<const uint32_t, 2> words) {
+    if ((words[0] >> 28) != 0x3) {
+      return std::nullopt;
+    }
+
+    const auto status = static_cast<uint8_t>(words[0] >> 20 & 0xf);
+    const auto size = std::min<std::size_t>(words[0] >> 16 & 0xf, 6);
+    const std::array<uint8_t, 6> bytes{
+        static_cast<uint8_t>(words[0] >> 8 & 0x7f),
+        static_cast<uint8_t>(words[0] & 0x7f),
+        static_cast<uint8_t>(words[1] >> 24 & 0x7f),
+        static_cast<uint8_t>(words[1] >> 16 & 0x7f),
+        static_cast<uint8_t>(words[1] >> 8 & 0x7f),
+        static_cast<uint8_t>(words[1] & 0x7f)};
+
+    return push(offset, sysex_type::SYSEX_7,
+                static_cast<uint8_t>(words[0] >> 24 & 0xf), 0, status,
+                std::span<const uint8_t>(bytes.data(), size));
+  }
+
+  /*! \brief Add a 128 bit UMP 8 bit system exclusive message.
+   *
+   * Mixed data set messages share the message type and are ignored.
+   *
+   * \return The completed message, if this was the last fragment.
+   */
+  std::optional<sysex_message>
+  push_ump_128(const uint32_t offset, std::span<const uint32_t, 4> words) {
+    const auto status = static_cast<uint8_t>(words[0] >> 20 & 0xf);
+    if ((words[0] >> 28) != 0x5 || status > 0x3) {
+      return std::nullopt;
+    }
+
+    // The byte count includes the stream id.
+    const std::size_t count = words[0] >> 16 & 0xf;
+    const auto size = count == 0 ? 0 : std::min<std::size_t>(count - 1, 13);
+    std::array<uint8_t, 13> bytes;
+    bytes[0] = static_cast<uint8_t>(words[0] & 0xff);
+    for (std::size_t i = 0; i < 12; ++i) {
+      bytes[i + 1] =
+          static_cast<uint8_t>(words[1 + i / 4] >> (24 - 8 * (i % 4)) & 0xff);
+    }
+
+    return push(offset, sysex_type::SYSEX_8,
+                static_cast<uint8_t>(words[0] >> 24 & 0xf),
+                static_cast<uint8_t>(words[0] >> 8 & 0xff), status,
+                std::span<const uint8_t>(bytes.data(), size));
+  }
+
+  /*! \brief Add midi 1.0 bytes.
+   *
+   * Bytes outside of a system exclusive message and real time messages
+   * inside of one are skipped. Any other status byte ends a message without
+   * completing it.
+   *
+   * \param emit Called with every completed message.
+   */
+  template <typename F>
+  void push_midi_1(const uint32_t offset, std::span<const uint8_t> bytes,
+                   F &&emit) {
+    std::size_t begin(0);
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+      const uint8_t byte = bytes[i];
+      if (byte < 0x80) {
+        continue;
+      }
+
+      // Flush the data in front of the status byte.
+      if (begin < i) {
+        push(offset, sysex_type::MIDI_1, 0, 0, continue_status,
+             bytes.subspan(begin, i - begin));
+      }
+      begin = i + 1;
+
+      if (byte >= 0xf8) {
+        continue;
+      }
+
+      if (byte == 0xf0) {
+        push(offset, sysex_type::MIDI_1, 0, 0, start_status, {});
+      } else if (byte == 0xf7) {
+        if (auto message = push(offset, sysex_type::MIDI_1, 0, 0, end_status,
+                                {})) {
+          emit(message.value());
+        }
+      } else if (auto *state = find(sysex_type::MIDI_1, 0, 0)) {
+        state->active = false;
+        counts.interrupted++;
+      }
+    }
+
+    if (begin < bytes.size()) {
+      push(offset, sysex_type::MIDI_1, 0, 0, continue_status,
+           bytes.subspan(begin));
+    }
+  }
+
+  /*! \brief Add the system exclusive messages of a buffer.
+   *
+   * Reads UMP and midi 1.0 controls, other messages are skipped.
+   *
+   * \param emit Called with every completed message.
+   *
+   * \return The number of completed messages.
+   */
+  template <typename F>
+  std::expected<std::size_t, error> parse(Buffer &buffer, F &&emit) {
+    auto pod = buffer.get_pod(0);
+    if (!pod.has_value()) {
+      return 0;
+    }
+
+    if (!spa_pod_is_sequence(pod.value())) {
+      return std::unexpected(error::midi_parsing_pod_not_a_sequence());
+    }
+
+    std::size_t completed(0);
+    auto counted_emit = [&](const sysex_message &message) {
+      completed++;
+      emit(message);
+    };
+
+    auto sequence = reinterpret_cast<struct spa_pod_sequence *>(pod.value());
+    struct spa_pod_control *pod_control;
+    SPA_POD_SEQUENCE_FOREACH(sequence, pod_control) {
+      const auto *body =
+          static_cast<const uint8_t *>(SPA_POD_BODY(&pod_control->value));
+      const uint32_t length = SPA_POD_BODY_SIZE(&pod_control->value);
+
+      if (pod_control->type == SPA_CONTROL_Midi) {
+        push_midi_1(pod_control->offset,
+                    std::span<const uint8_t>(body, length), counted_emit);
+      } else if (pod_control->type == SPA_CONTROL_UMP) {
+        std::array<uint32_t, 4> words;
+        for (std::size_t position = 0; position + 4 <= length;) {
+          std::memcpy(words.data(), body + position, 4);
+          const auto size = ump_message_words(words[0]) * 4;
+          if (position + size > length) {
+            break;
+          }
+
+          std::memcpy(words.data(), body + position, size);
+          std::optional<sysex_message> message;
+          if ((words[0] >> 28) == 0x3) {
+            message = push_ump_64(pod_control->offset,
+                                  std::span<const uint32_t, 2>(words.data(), 2));
+          } else if ((words[0] >> 28) == 0x5) {
+            message = push_ump_128(pod_control->offset, words);
+          }
+
+          if (message.has_value()) {
+            counted_emit(message.value());
+          }
+          position += size;
+        }
+      }
+    }
+
+    return completed;
+  }
+
+  /*! \brief The counters since construction or the last reset. */
+  [[nodiscard]] const sysex_counters &counters() const { return counts; }
+
+  /*! \brief Abort all messages in progress and reset the counters. */
+  void reset() {
+    for (auto &state : states) {
+      state.active = false;
+    }
+    counts = {};
+  }
+
+private:
+  static constexpr uint8_t complete_status = 0x0;
+  static constexpr uint8_t start_status = 0x1;
+  static constexpr uint8_t continue_status = 0x2;
+  static constexpr uint8_t end_status = 0x3;
+
+  struct stream_state {
+    bool active = false;
+    bool oversized = false;
+    sysex_type type = sysex_type::MIDI_1;
+    uint8_t group = 0;
+    uint8_t stream = 0;
+    std::size_t slot = 0;
+    std::size_t size = 0;
+  };
+
+  stream_state *find(const sysex_type type, const uint8_t group,
+                     const uint8_t stream) {
+    for (auto &state : states) {
+      if (state.active && state.type == type && state.group == group &&
+          state.stream == stream) {
+        return &state;
+      }
+    }
+    return nullptr;
+  }
+
+  stream_state *start(const sysex_type type, const uint8_t group,
+                      const uint8_t stream) {
+    for (auto &state : states) {
+      if (!state.active) {
+        state.active = true;
+        state.oversized = false;
+        state.type = type;
+        state.group = group;
+        state.stream = stream;
+        state.slot = (state.slot + 1) % SLOTS;
+        state.size = 0;
+        return &state;
+      }
+    }
+
+    counts.no_stream++;
+    return nullptr;
+  }
+
+  std::optional<sysex_message> push(const uint32_t offset,
+                                    const sysex_type type, const uint8_t group,
+                                    const uint8_t stream, const uint8_t status,
+                                    std::span<const uint8_t> bytes) {
+    auto *state = find(type, group, stream);
+    if (status == complete_status || status == start_status) {
+      if (state != nullptr) {
+        state->active = false;
+        counts.interrupted++;
+      }
+      state = start(type, group, stream);
+    } else if (state == nullptr) {
+      // A continuation without start, or one whose start was dropped.
+      if (status == end_status) {
+        counts.interrupted++;
+      }
+      return std::nullopt;
+    }
+
+    if (state == nullptr) {
+      return std::nullopt;
+    }
+
+    if (state->size + bytes.size() > MAX_SIZE) {
+      state->oversized = true;
+    } else if (!bytes.empty()) {
+      std::memcpy(slot_data(*state) + state->size, bytes.data(), bytes.size());
+      state->size += bytes.size();
+    }
+
+    if (status == start_status || status == continue_status) {
+      return std::nullopt;
+    }
+
+    state->active = false;
+    if (state->oversized) {
+      counts.oversized++;
+      return std::nullopt;
+    }
+
+    counts.completed++;
+    return sysex_message{
+        .offset = offset,
+        .type = type,
+        .group = group,
+        .stream = stream,
+        .data = std::span<const uint8_t>(slot_data(*state), state->size)};
+  }
+
+  uint8_t *slot_data(const stream_state &state) {
+    const auto index = static_cast<std::size_t>(&state - states.data());
+    return data[index][state.slot].data();
+  }
+
+  std::array<stream_state, STREAMS> states{};
+  std::array<std::array<std::array<uint8_t, MAX_SIZE>, SLOTS>, STREAMS> data;
+  sysex_counters counts{};
+};
+
+} // namespace pwcpp::midi
@@ -0,0 +1,565 @@
+#pragma once
+
+#include "pwcpp/buffer.h"
+#include "pwcpp/error.h"
+#include "pwcpp/midi/message.h"
+#include "pwcpp/midi/parse_midi.h"
+#include "pwcpp/midi/scale.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <optional>
+#include <span>
+
+#include <spa/control/control.h>
+
+namespace pwcpp::midi {
+
+/*! \brief A midi 1.0 channel voice message of up to three bytes. */
+struct midi_1_message {
+  std::array<uint8_t, 3> bytes;
+  uint8_t size;
+
+  bool operator==(const midi_1_message &) const = default;
+};
+
+/*! \brief The size of a midi 1.0 message including the status byte.
+ *
+ * \return The size or 0 for system exclusive and undefined status bytes.
+ */
+constexpr uint8_t midi_1_message_size(const uint8_t status) {
+  switch (status & 0xf0) {
+  case 0x80:
+  case 0x90:
+  case 0xa0:
+  case 0xb0:
+  case 0xe0:
+    return 3;
+  case 0xc0:
+  case 0xd0:
+    return 2;
+  case 0xf0:
+    break;
+  default:
+    return 0;
+  }
+
+  switch (status) {
+  case 0xf2:
+    return 3;
+  case 0xf1:
+  case 0xf3:
+    return 2;
+  case 0xf6:
+  case 0xf8:
+  case 0xfa:
+  case 0xfb:
+  case 0xfc:
+  case 0xfe:
+  case 0xff:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+/*! \brief Pack a midi 1.0 channel voice message into a 32 bit midi 1.0
+ * channel voice UMP (message type 2). */
+constexpr uint32_t midi_1_to_ump_32(const midi_1_message &message,
+                                    const uint8_t group = 0) {
+  return 0x20000000u | static_cast<uint32_t>(group & 0x0f) << 24 |
+         static_cast<uint32_t>(message.bytes[0]) << 16 |
+         static_cast<uint32_t>(message.size > 1 ? message.bytes[1] : 0) << 8 |
+         static_cast<uint32_t>(message.size > 2 ? message.bytes[2] : 0);
+}
+
+/*! \brief Unpack a 32 bit midi 1.0 channel voice UMP into midi 1.0 bytes. */
+constexpr midi_1_message ump_32_to_midi_1(const uint32_t word) {
+  const auto status = static_cast<uint8_t>(word >> 16);
+  return {.bytes = {status, static_cast<uint8_t>(word >> 8 & 0x7f),
+                    static_cast<uint8_t>(word & 0x7f)},
+          .size = midi_1_message_size(status)};
+}
+
+/*! \brief Options of the translation between midi 1.0 and midi 2.0. */
+struct translator_options {
+  /*! \brief Combine controllers 1 - 31 with their LSB controller 33 - 63 into
+   * one 14 bit value when translating to midi 2.0. */
+  bool assemble_14_bit_cc = true;
+  /*! \brief Send the LSB controller for controllers 1 - 31 when translating
+   * to midi 1.0. */
+  bool write_14_bit_cc = false;
+};
+
+/*! \brief The maximum number of midi 1.0 messages a midi 2.0 message is
+ * translated to, a registered controller becomes four control changes. */
+inline constexpr std::size_t max_translated_messages = 4;
+
+namespace detail {
+constexpr uint32_t ump_32_control_change(const uint32_t group_channel,
+                                         const uint8_t index,
+                                         const uint8_t value) {
+  return 0x20000000u | group_channel | 0xb00000u |
+         static_cast<uint32_t>(index) << 8 | value;
+}
+} // namespace detail
+
+/*! \brief Translate a 64 bit midi 2.0 channel voice UMP to 32 bit midi 1.0
+ * channel voice UMP in the same group.
+ *
+ * Values are scaled down to 7 or 14 bit. Registered and assignable
+ * controllers become the control change sequence selecting the parameter
+ * followed by data entry, a program change with a valid bank is preceded by
+ * the bank select controllers. A note on never gets a velocity of 0.
+ *
+ * \return The number of words written to `out`, 0 if the message has no midi
+ * 1.0 equivalent.
+ */
+constexpr std::size_t
+ump_64_to_ump_32(std::span<const uint32_t, 2> words,
+                 std::span<uint32_t, max_translated_messages> out,
+                 const translator_options &options = {}) {
+  if ((words[0] >> 28) != 0x4) {
+    return 0;
+  }
+
+  const uint32_t group_channel = words[0] & 0x0f0f0000u;
+  const auto status = static_cast<uint8_t>(words[0] >> 20 & 0xf);
+  const auto number = static_cast<uint8_t>(words[0] >> 8 & 0x7f);
+  const auto header = 0x20000000u | group_channel;
+
+  switch (status) {
+  case 0x8:
+    out[0] = header | 0x800000u | static_cast<uint32_t>(number) << 8 |
+             scale_16_to_7(static_cast<uint16_t>(words[1] >> 16));
+    return 1;
+  case 0x9: {
+    const auto velocity = scale_16_to_7(static_cast<uint16_t>(words[1] >> 16));
+    out[0] = header | 0x900000u | static_cast<uint32_t>(number) << 8 |
+             (velocity == 0 ? 1u : velocity);
+    return 1;
+  }
+  case 0xa:
+    out[0] = header | 0xa00000u | static_cast<uint32_t>(number) << 8 |
+             scale_32_to_7(words[1]);
+    return 1;
+  case 0xb:
+    out[0] = detail::ump_32_control_change(group_channel, number,
+                                           scale_32_to_7(words[1]));
+    if (options.write_14_bit_cc && number >= 1 && number < 32 && number != 6) {
+      out[1] = detail::ump_32_control_change(
+          group_channel, number + 32, scale_32_to_14(words[1]) & 0x7f);
+      return 2;
+    }
+    return 1;
+  case 0xc: {
+    std::size_t count(0);
+    if ((words[0] & 0x01) != 0) {
+      out[count++] = detail::ump_32_control_change(
+          group_channel, 0, static_cast<uint8_t>(words[1] >> 8 & 0x7f));
+      out[count++] = detail::ump_32_control_change(
+          group_channel, 32, static_cast<uint8_t>(words[1] & 0x7f));
+    }
+    out[count++] = header | 0xc00000u | (words[1] >> 16 & 0x7f00);
+    return count;
+  }
+  case 0xd:
+    out[0] = header | 0xd00000u | static_cast<uint32_t>(scale_32_to_7(words[1]))
+                                      << 8;
+    return 1;
+  case 0xe: {
+    const auto value = scale_32_to_14(words[1]);
+    out[0] = header | 0xe00000u | static_cast<uint32_t>(value & 0x7f) << 8 |
+             value >> 7;
+    return 1;
+  }
+  case 0x2:
+  case 0x3: {
+    const bool registered = status == 0x2;
+    const auto value = scale_32_to_14(words[1]);
+    out[0] = detail::ump_32_control_change(group_channel, registered ? 101 : 99,
+                                           number);
+    out[1] = detail::ump_32_control_change(
+        group_channel, registered ? 100 : 98,
+        static_cast<uint8_t>(words[0] & 0x7f));
+    out[2] = detail::ump_32_control_change(group_channel, 6,
+                                           static_cast<uint8_t>(value >> 7));
+    out[3] = detail::ump_32_control_change(group_channel, 38,
+                                           static_cast<uint8_t>(value & 0x7f));
+    return 4;
+  }
+  default:
+    return 0;
+  }
+}
+
+/*! \brief Translate a 64 bit midi 2.0 channel voice UMP to midi 1.0 bytes.
+ *
+ * \see ump_64_to_ump_32
+ */
+constexpr std::size_t
+ump_64_to_midi_1(std::span<const uint32_t, 2> words,
+                 std::span<midi_1_message, max_translated_messages> out,
+                 const translator_options &options = {}) {
+  std::array<uint32_t, max_translated_messages> translated{};
+  const auto count = ump_64_to_ump_32(words, translated, options);
+  for (std::size_t i = 0; i < count; ++i) {
+    out[i] = ump_32_to_midi_1(translated[i]);
+  }
+
+  return count;
+}
+
+/*! \brief Translates midi 1.0 messages to midi 2.0 messages.
+ *
+ * Translating to midi 2.0 needs state: registered and assignable controllers
+ * are sent as a sequence of control changes, 14 bit controllers as MSB and
+ * LSB and the bank of a program change as bank select controllers before the
+ * program change. The translator keeps this state for every group and
+ * channel and emits the midi 2.0 message once the midi 1.0 sequence provides
+ * it. Values are scaled up with the min-center-max algorithm of the midi 2.0
+ * specification.
+ *
+ * The translator doesn't allocate, it is meant to live as long as the filter
+ * and to be used inside the process callback.
+ */
+class Translator {
+public:
+  explicit Translator(translator_options options = {}) : options(options) {
+    reset();
+  }
+
+  /*! \brief Forget the controller state of all groups and channels. */
+  void reset() { states.fill(channel_state{}); }
+
+  /*! \brief Translate a 32 bit midi 1.0 channel voice UMP.
+   *
+   * \return The 64 bit midi 2.0 UMP or nothing if the message only changes
+   * the state of the translator or isn't a channel voice message.
+   */
+  std::optional<std::array<uint32_t, 2>> ump_32_to_ump_64(const uint32_t word) {
+    if ((word >> 28) != 0x2) {
+      return std::nullopt;
+    }
+
+    const uint32_t group_channel = word & 0x0f0f0000u;
+    const auto status = static_cast<uint8_t>(word >> 20 & 0xf);
+    const auto data_1 = static_cast<uint8_t>(word >> 8 & 0x7f);
+    const auto data_2 = static_cast<uint8_t>(word & 0x7f);
+    const uint32_t header = 0x40000000u | group_channel;
+    auto &state =
+        states[(group_channel >> 20 & 0xf0) | (group_channel >> 16 & 0x0f)];
+
+    switch (status) {
+    case 0x8:
+      return std::array<uint32_t, 2>{
+          header | 0x800000u | static_cast<uint32_t>(data_1) << 8,
+          static_cast<uint32_t>(scale_7_to_16(data_2)) << 16};
+    case 0x9:
+      if (data_2 == 0) {
+        return std::array<uint32_t, 2>{
+            header | 0x800000u | static_cast<uint32_t>(data_1) << 8,
+            static_cast<uint32_t>(scale_7_to_16(0x40)) << 16};
+      }
+      return std::array<uint32_t, 2>{
+          header | 0x900000u | static_cast<uint32_t>(data_1) << 8,
+          static_cast<uint32_t>(scale_7_to_16(data_2)) << 16};
+    case 0xa:
+      return std::array<uint32_t, 2>{
+          header | 0xa00000u | static_cast<uint32_t>(data_1) << 8,
+          scale_7_to_32(data_2)};
+    case 0xb:
+      return control_change_to_ump_64(state, header, data_1, data_2);
+    case 0xc: {
+      const bool bank_valid = state.bank_msb >= 0 || state.bank_lsb >= 0;
+      return std::array<uint32_t, 2>{
+          header | 0xc00000u | (bank_valid ? 1u : 0u),
+          static_cast<uint32_t>(data_1) << 24 |
+              static_cast<uint32_t>(bank_valid && state.bank_msb >= 0
+                                        ? state.bank_msb
+                                        : 0)
+                  << 8 |
+              static_cast<uint32_t>(
+                  bank_valid && state.bank_lsb >= 0 ? state.bank_lsb : 0)};
+    }
+    case 0xd:
+      return std::array<uint32_t, 2>{header | 0xd00000u, scale_7_to_32(data_1)};
+    case 0xe:
+      return std::array<uint32_t, 2>{
+          header | 0xe00000u,
+          scale_14_to_32(static_cast<uint16_t>(data_2 << 7 | data_1))};
+    default:
+      return std::nullopt;
+    }
+  }
+
+  /*! \brief Translate a midi 1.0 channel voice message.
+   *
+   * \see ump_32_to_ump_64
+   */
+  std::optional<std::array<uint32_t, 2>>
+  midi_1_to_ump_64(const midi_1_message &message, const uint8_t group = 0) {
+    if (message.size < 2 || (message.bytes[0] & 0xf0) == 0xf0) {
+      return std::nullopt;
+    }
+
+    return ump_32_to_ump_64(midi_1_to_ump_32(message, group));
+  }
+
+  /*! \brief Translate a midi 2.0 message to midi 1.0 bytes with the options
+   * of this translator.
+   *
+   * \see ump_64_to_ump_32
+   */
+  std::size_t
+  ump_64_to_midi_1(std::span<const uint32_t, 2> words,
+                   std::span<midi_1_message, max_translated_messages> out) const {
+    return midi::ump_64_to_midi_1(words, out, options);
+  }
+
+  /*! \brief Parse the midi messages of a buffer independent of their format.
+   *
+   * Reads 64 bit midi 2.0 UMP, 32 bit midi 1.0 UMP and midi 1.0 byte
+   * controls, including running status, and translates them to midi 2.0
+   * messages. Messages `parse_ump_64` doesn't decode are skipped.
+   *
+   * \param buffer The buffer to read the sequence from.
+   * \param messages Receives the messages with the sample offset of their
+   * control.
+   *
+   * \return The number of messages or an error if there are more than
+   * `MAX_N`.
+   */
+  template <std::size_t MAX_N>
+  std::expected<std::size_t, error>
+  parse(Buffer &buffer, std::array<timed_message, MAX_N> &messages) {
+    auto pod = buffer.get_pod(0);
+
+    if (!pod.has_value()) {
+      return 0;
+    }
+
+    if (!spa_pod_is_sequence(pod.value())) {
+      return std::unexpected(error::midi_parsing_pod_not_a_sequence());
+    }
+
+    auto sequence = reinterpret_cast<struct spa_pod_sequence *>(pod.value());
+
+    std::size_t index(0);
+    auto append = [&](const uint32_t offset,
+                      const std::array<uint32_t, 2> &words) -> bool {
+      auto message = parse_ump_64(words.data());
+      if (!message.has_value()) {
+        return true;
+      }
+
+      if (index >= MAX_N) {
+        return false;
+      }
+
+      messages[index++] = {.offset = offset, .message = message.value()};
+      return true;
+    };
+
+    struct spa_pod_control *pod_control;
+    SPA_POD_SEQUENCE_FOREACH(sequence, pod_control) {
+      const auto *body =
+          static_cast<const uint8_t *>(SPA_POD_BODY(&pod_control->value));
+      const uint32_t length = SPA_POD_BODY_SIZE(&pod_control->value);
+
+      bool appended = true;
+      if (pod_control->type == SPA_CONTROL_UMP) {
+        for (uint32_t position = 0; appended && position + 4 <= length;) {
+          std::array<uint32_t, 2> words{};
+          std::memcpy(words.data(), body + position, 4);
+          if ((words[0] >> 28) == 0x4 && position + 8 <= length) {
+            std::memcpy(&words[1], body + position + 4, 4);
+            appended = append(pod_control->offset, words);
+            position += 8;
+          } else if ((words[0] >> 28) == 0x2) {
+            if (auto translated = ump_32_to_ump_64(words[0])) {
+              appended = append(pod_control->offset, translated.value());
+            }
+            position += 4;
+          } else {
+            break;
+          }
+        }
+      } else if (pod_control->type == SPA_CONTROL_Midi) {
+        appended = parse_midi_1(
+            std::span<const uint8_t>(body, length), [&](const auto &words) {
+              return append(pod_control->offset, words);
+            });
+      }
+
+      if (!appended) {
+        return std::unexpected(error::midi_parsing_too_many_messages());
+      }
+    }
+
+    return index;
+  }
+
+private:
+  /*! \brief The controller state of one group and channel, -1 marks a value
+   * that hasn't been received. */
+  struct channel_state {
+    enum class parameter_type : uint8_t { NONE, REGISTERED, ASSIGNABLE };
+
+    parameter_type parameter = parameter_type::NONE;
+    uint8_t registered_msb = 0x7f;
+    uint8_t registered_lsb = 0x7f;
+    uint8_t assignable_msb = 0x7f;
+    uint8_t assignable_lsb = 0x7f;
+    int8_t data_entry_msb = -1;
+    int8_t bank_msb = -1;
+    int8_t bank_lsb = -1;
+    std::array<int8_t, 32> controller_msb{-1, -1, -1, -1, -1, -1, -1, -1,
+                                          -1, -1, -1, -1, -1, -1, -1, -1,
+                                          -1, -1, -1, -1, -1, -1, -1, -1,
+                                          -1, -1, -1, -1, -1, -1, -1, -1};
+  };
+
+  std::optional<std::array<uint32_t, 2>>
+  control_change_to_ump_64(channel_state &state, const uint32_t header,
+                           const uint8_t index, const uint8_t value) {
+    using parameter_type = channel_state::parameter_type;
+
+    switch (index) {
+    case 0:
+      state.bank_msb = static_cast<int8_t>(value);
+      return std::nullopt;
+    case 32:
+      state.bank_lsb = static_cast<int8_t>(value);
+      return std::nullopt;
+    case 101:
+      state.parameter = parameter_type::REGISTERED;
+      state.registered_msb = value;
+      state.data_entry_msb = -1;
+      return std::nullopt;
+    case 100:
+      state.parameter = parameter_type::REGISTERED;
+      state.registered_lsb = value;
+      state.data_entry_msb = -1;
+      return std::nullopt;
+    case 99:
+      state.parameter = parameter_type::ASSIGNABLE;
+      state.assignable_msb = value;
+      state.data_entry_msb = -1;
+      return std::nullopt;
+    case 98:
+      state.parameter = parameter_type::ASSIGNABLE;
+      state.assignable_lsb = value;
+      state.data_entry_msb = -1;
+      return std::nullopt;
+    case 6:
+    case 38: {
+      const bool registered = state.parameter == parameter_type::REGISTERED;
+      const uint8_t msb =
+          registered ? state.registered_msb : state.assignable_msb;
+      const uint8_t lsb =
+          registered ? state.registered_lsb : state.assignable_lsb;
+      // RPN 127/127 is the null function which deselects the parameter.
+      if (state.parameter == parameter_type::NONE ||
+          (registered && msb == 0x7f && lsb == 0x7f)) {
+        break;
+      }
+
+      if (index == 6) {
+        state.data_entry_msb = static_cast<int8_t>(value);
+      } else if (state.data_entry_msb < 0) {
+        return std::nullopt;
+      }
+
+      const auto data = static_cast<uint16_t>(
+          state.data_entry_msb << 7 | (index == 38 ? value : 0));
+      return std::array<uint32_t, 2>{header |
+                                         (registered ? 0x200000u : 0x300000u) |
+                                         static_cast<uint32_t>(msb) << 8 | lsb,
+                                     scale_14_to_32(data)};
+    }
+    default:
+      break;
+    }
+
+    if (options.assemble_14_bit_cc) {
+      if (index >= 1 && index < 32) {
+        state.controller_msb[index] = static_cast<int8_t>(value);
+      } else if (index >= 33 && index < 64 &&
+                 state.controller_msb[index - 32] >= 0) {
+        const auto data = static_cast<uint16_t>(
+            state.controller_msb[index - 32] << 7 | value);
+        return std::array<uint32_t, 2>{
+            header | 0xb00000u | static_cast<uint32_t>(index - 32) << 8,
+            scale_14_to_32(data)};
+      }
+    }
+
+    return std::array<uint32_t, 2>{
+        header | 0xb00000u | static_cast<uint32_t>(index) << 8,
+        scale_7_to_32(value)};
+  }
+
+  /*! \brief Split midi 1.0 bytes into messages and translate them.
+   *
+   * \return False if `emit` returned false.
+   */
+  template <typename F>
+  bool parse_midi_1(std::span<const uint8_t> bytes, F &&emit) {
+    uint8_t running_status(0);
+    std::size_t position(0);
+    while (position < bytes.size()) {
+      uint8_t status = bytes[position];
+      if (status < 0x80) {
+        if (running_status == 0) {
+          position++;
+          continue;
+        }
+        status = running_status;
+      } else {
+        position++;
+        if (status == 0xf0) {
+          while (position < bytes.size() && bytes[position++] != 0xf7) {
+          }
+          running_status = 0;
+          continue;
+        }
+        if (status < 0xf0) {
+          running_status = status;
+        } else if (status < 0xf8) {
+          running_status = 0;
+        }
+      }
+
+      const uint8_t size = midi_1_message_size(status);
+      if (size == 0) {
+        continue;
+      }
+
+      if (position + size - 1 > bytes.size()) {
+        break;
+      }
+
+      midi_1_message message{.bytes = {status, 0, 0}, .size = size};
+      for (uint8_t i = 1; i < size; ++i) {
+        message.bytes[i] = bytes[position++];
+      }
+
+      if (auto translated = midi_1_to_ump_64(message)) {
+        if (!emit(translated.value())) {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  translator_options options;
+  std::array<channel_state, 256> states;
+};
+
+} // namespace pwcpp::midi
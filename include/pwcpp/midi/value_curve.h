@@ -0,0 +1,196 @@
+#pragma once
+
+#include "pwcpp/midi/scale.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace pwcpp::midi {
+
+namespace detail {
+inline constexpr double ln_2 = 0.69314718055994530942;
+
+/*! \brief The exponential function, usable in constant expressions. */
+constexpr double constexpr_exp(const double x) {
+  // exp(x) = 2^k * exp(r) with |r| <= ln(2) / 2.
+  const auto k = static_cast<long long>(x / ln_2 + (x < 0 ? -0.5 : 0.5));
+  const double r = x - static_cast<double>(k) * ln_2;
+
+  double term = 1.0;
+  double sum = 1.0;
+  for (int n = 1; n < 24; ++n) {
+    term *= r / n;
+    sum += term;
+  }
+
+  double power = 1.0;
+  for (long long i = 0; i < (k < 0 ? -k : k); ++i) {
+    power *= 2.0;
+  }
+  return k < 0 ? sum / power : sum * power;
+}
+
+/*! \brief The natural logarithm of a positive value, usable in constant
+ * expressions. */
+constexpr double constexpr_log(double x) {
+  // log(x) = e * ln(2) + log(m) with m in [1, 2).
+  int e = 0;
+  while (x >= 2.0) {
+    x /= 2.0;
+    ++e;
+  }
+  while (x < 1.0) {
+    x *= 2.0;
+    --e;
+  }
+
+  // log(m) = 2 * atanh((m - 1) / (m + 1))
+  const double t = (x - 1.0) / (x + 1.0);
+  const double t_2 = t * t;
+  double term = t;
+  double sum = 0.0;
+  for (int n = 1; n < 60; n += 2) {
+    sum += term / n;
+    term *= t_2;
+  }
+  return 2.0 * sum + e * ln_2;
+}
+} // namespace detail
+
+/*! \brief Maps the input unchanged. */
+struct linear_curve {
+  constexpr double operator()(const double x) const { return x; }
+};
+
+/*! \brief Rises slowly first and fast at the end, `(e^(k x) - 1) / (e^k - 1)`.
+ */
+struct exponential_curve {
+  /*! \brief The steepness k, larger is steeper, must not be 0. */
+  double shape;
+
+  /*! \brief The curve that maps to `minimum * (maximum / minimum)^x`, for
+   * ranges like frequencies. Both values must be positive. */
+  static constexpr exponential_curve for_range(const double minimum,
+                                               const double maximum) {
+    return {detail::constexpr_log(maximum / minimum)};
+  }
+
+  constexpr double operator()(const double x) const {
+    return (detail::constexpr_exp(shape * x) - 1.0) /
+           (detail::constexpr_exp(shape) - 1.0);
+  }
+};
+
+/*! \brief Rises fast first and slowly at the end, `log(1 + k x) / log(1 + k)`.
+ */
+struct logarithmic_curve {
+  /*! \brief The steepness k, larger is steeper, must be positive. */
+  double shape;
+
+  constexpr double operator()(const double x) const {
+    return detail::constexpr_log(1.0 + shape * x) /
+           detail::constexpr_log(1.0 + shape);
+  }
+};
+
+/*! \brief A normalized point of a breakpoint_curve. */
+struct curve_point {
+  double x;
+  double y;
+};
+
+/*! \brief Linear segments between breakpoints with ascending x, from x = 0
+ * to x = 1. */
+template <std::size_t N> struct breakpoint_curve {
+  std::array<curve_point, N> points;
+
+  constexpr double operator()(const double x) const {
+    if (x <= points.front().x) {
+      return points.front().y;
+    }
+
+    for (std::size_t i = 1; i < N; ++i) {
+      if (x <= points[i].x) {
+        const auto &a = points[i - 1];
+        const auto &b = points[i];
+        return a.y + (b.y - a.y) * (x - a.x) / (b.x - a.x);
+      }
+    }
+
+    return points.back().y;
+  }
+};
+
+template <std::size_t N>
+breakpoint_curve(std::array<curve_point, N>) -> breakpoint_curve<N>;
+
+/*! \brief Maps midi values to a parameter range through a curve.
+ *
+ * The curve is evaluated when the ValueCurve is constructed, usually at
+ * compile time, and stored in lookup tables: one entry for each 7 bit value
+ * and `2^TABLE_BITS + 1` entries for higher resolutions, which are linearly
+ * interpolated. Mapping a value costs a table load and, for 14, 16 and 32
+ * bit values, a lerp.
+ *
+ * \tparam TABLE_BITS The resolution of the interpolated table.
+ */
+template <std::size_t TABLE_BITS = 8> class ValueCurve {
+public:
+  static_assert(TABLE_BITS > 0 && TABLE_BITS < 24);
+
+  /*! \brief Construct the tables.
+   *
+   * \param curve Maps the normalized input from 0 to 1 to the normalized
+   * output, usually from 0 to 1.
+   * \param minimum The parameter value of output 0.
+   * \param maximum The parameter value of output 1.
+   */
+  template <typename Curve>
+  constexpr ValueCurve(const Curve &curve, const double minimum,
+                       const double maximum) {
+    for (std::size_t i = 0; i < table_7.size(); ++i) {
+      table_7[i] = static_cast<float>(
+          minimum + (maximum - minimum) * curve(static_cast<double>(i) / 127.0));
+    }
+
+    for (std::size_t i = 0; i < table.size(); ++i) {
+      table[i] = static_cast<float>(
+          minimum + (maximum - minimum) *
+                        curve(static_cast<double>(i) / (table.size() - 1)));
+    }
+  }
+
+  /*! \brief Map a 7 bit midi 1.0 value. */
+  [[nodiscard]] constexpr float map_7_bit(const uint8_t value) const {
+    return table_7[value & 0x7f];
+  }
+
+  /*! \brief Map a 14 bit value, e.g. a pitch bend or 14 bit controller. */
+  [[nodiscard]] constexpr float map_14_bit(const uint16_t value) const {
+    return map_32_bit(scale_14_to_32(value));
+  }
+
+  /*! \brief Map a 16 bit value, e.g. a midi 2.0 velocity. */
+  [[nodiscard]] constexpr float map_16_bit(const uint16_t value) const {
+    return map_32_bit(scale_up(value, 16, 32));
+  }
+
+  /*! \brief Map a 32 bit value, e.g. a midi 2.0 controller value. */
+  [[nodiscard]] constexpr float map_32_bit(const uint32_t value) const {
+    constexpr uint32_t shift = 32 - TABLE_BITS;
+    constexpr float fraction_scale = 1.0f / static_cast<float>(1u << shift);
+    const uint32_t index = value >> shift;
+    const auto fraction =
+        static_cast<float>(value & ((1u << shift) - 1)) * fraction_scale;
+    const float a = table[index];
+    const float b = table[index + 1];
+    return a + (b - a) * fraction;
+  }
+
+private:
+  std::array<float, 128> table_7{};
+  std::array<float, (std::size_t(1) << TABLE_BITS) + 1> table{};
+};
+
+} // namespace pwcpp::midi
@@ -0,0 +1,292 @@
+#pragma once
+
+#include "pwcpp/midi/message.h"
+#include "pwcpp/midi/note_tracker.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <variant>
+
+namespace pwcpp::midi {
+
+/*! \brief Which voice a note on takes when all voices are in use. */
+enum class steal_policy {
+  /*! \brief Don't steal, the note is dropped. */
+  NONE,
+  /*! \brief The voice that started first. */
+  OLDEST,
+  /*! \brief The voice with the lowest velocity. */
+  QUIETEST,
+  /*! \brief The voice with the lowest note. */
+  LOWEST,
+  /*! \brief The voice with the highest note. */
+  HIGHEST,
+};
+
+/*! \brief A voice playing a note. */
+struct voice {
+  /*! \brief The index of the voice's DSP state, it doesn't change while the
+   * voice is active. */
+  uint16_t slot;
+  uint8_t channel;
+  uint8_t note;
+  uint16_t velocity;
+  /*! \brief False once the note was released, the voice keeps sounding
+   * until it is freed. */
+  bool gate;
+  /*! \brief The note was released while the sustain pedal was down. */
+  bool sustained;
+  /*! \brief Increases with every started voice, smaller is older. */
+  uint32_t age;
+};
+
+/*! \brief What happened to a voice. */
+struct voice_event {
+  enum class type : uint8_t {
+    /*! \brief A free voice started a note. */
+    START,
+    /*! \brief The note of an active voice was played again. */
+    RETRIGGER,
+    /*! \brief An active voice was taken for another note. */
+    STEAL,
+    /*! \brief The gate of a voice closed. */
+    RELEASE,
+  };
+
+  type event_type;
+  /*! \brief The slot of the voice. */
+  uint16_t slot;
+};
+
+/*! \brief Assigns notes to a fixed number of voices.
+ *
+ * The active voices are stored contiguously at the front of an array, so DSP
+ * loops iterate VoiceAllocator::active without checking for inactive voices.
+ * Freeing a voice moves the last active voice into its place, the slot of a
+ * voice identifies its DSP state independent of its position.
+ *
+ * A note off closes the gate of its voice, or marks it sustained while the
+ * sustain pedal is down. The voice stays active until the DSP frees it, e.g.
+ * when its release envelope ended. When all voices are in use, a note on
+ * steals a voice with a closed gate first and uses the steal policy among
+ * the voices with an open gate otherwise.
+ *
+ * \tparam MAX_VOICES The number of voices.
+ */
+template <std::size_t MAX_VOICES> class VoiceAllocator {
+public:
+  static_assert(MAX_VOICES <= 0xffff);
+
+  explicit VoiceAllocator(steal_policy policy = steal_policy::OLDEST)
+      : policy(policy) {
+    clear();
+  }
+
+  /*! \brief Apply a message.
+   *
+   * \param on_event Called with a voice_event for every voice that changed.
+   */
+  template <typename F>
+  void update(const midi::message &message, F &&on_event) {
+    std::visit(
+        [&](const auto &m) {
+          using T = std::decay_t<decltype(m)>;
+          if constexpr (std::is_same_v<T, note_on>) {
+            note_on_event(m, on_event);
+          } else if constexpr (std::is_same_v<T, note_off>) {
+            for (std::size_t i = 0; i < active_count; ++i) {
+              auto &v = voices[i];
+              if (v.gate && v.channel == (m.channel & 0x0f) &&
+                  v.note == (m.note & 0x7f)) {
+                if (pedal[v.channel]) {
+                  v.sustained = true;
+                } else {
+                  v.gate = false;
+                  on_event(voice_event{voice_event::type::RELEASE, v.slot});
+                }
+              }
+            }
+          } else if constexpr (std::is_same_v<T, control_change>) {
+            if (m.cc_number == sustain_pedal) {
+              pedal_event(m.channel & 0x0f, is_pedal_down(m.value), on_event);
+            }
+          }
+        },
+        message);
+  }
+
+  /*! \brief The active voices. */
+  [[nodiscard]] std::span<voice> active() {
+    return std::span<voice>(voices.data(), active_count);
+  }
+
+  /*! \brief The active voices. */
+  [[nodiscard]] std::span<const voice> active() const {
+    return std::span<const voice>(voices.data(), active_count);
+  }
+
+  /*! \brief Free the active voice at the given position.
+   *
+   * The last active voice takes its position, so iterate backwards when
+   * freeing voices in a loop.
+   */
+  void free(const std::size_t index) {
+    if (index >= active_count) {
+      return;
+    }
+
+    free_slots[free_count++] = voices[index].slot;
+    voices[index] = voices[--active_count];
+  }
+
+  /*! \brief Free all active voices for which the predicate returns true. */
+  template <typename P> void free_if(P &&predicate) {
+    for (std::size_t i = active_count; i > 0; --i) {
+      if (predicate(voices[i - 1])) {
+        free(i - 1);
+      }
+    }
+  }
+
+  /*! \brief Close the gates of all voices and release the pedals, for panic
+   * or bypass.
+   *
+   * \param on_event Called with the release event of every voice with an
+   * open gate.
+   */
+  template <typename F> void release_all(F &&on_event) {
+    pedal = {};
+    for (std::size_t i = 0; i < active_count; ++i) {
+      if (voices[i].gate) {
+        voices[i].gate = false;
+        voices[i].sustained = false;
+        on_event(voice_event{voice_event::type::RELEASE, voices[i].slot});
+      }
+    }
+  }
+
+  /*! \brief Free all voices and forget the pedals. */
+  void clear() {
+    active_count = 0;
+    free_count = MAX_VOICES;
+    // Hand out the lowest slots first.
+    for (std::size_t i = 0; i < MAX_VOICES; ++i) {
+      free_slots[i] = static_cast<uint16_t>(MAX_VOICES - 1 - i);
+    }
+    pedal = {};
+  }
+
+private:
+  template <typename F> void note_on_event(const note_on &m, F &&on_event) {
+    const auto channel = static_cast<uint8_t>(m.channel & 0x0f);
+    const auto note = static_cast<uint8_t>(m.note & 0x7f);
+
+    for (std::size_t i = 0; i < active_count; ++i) {
+      auto &v = voices[i];
+      if (v.channel == channel && v.note == note) {
+        v.velocity = m.velocity;
+        v.gate = true;
+        v.sustained = false;
+        v.age = next_age++;
+        on_event(voice_event{voice_event::type::RETRIGGER, v.slot});
+        return;
+      }
+    }
+
+    if (free_count > 0) {
+      voices[active_count++] = {free_slots[--free_count], channel, note,
+                                m.velocity, true, false, next_age++};
+      on_event(voice_event{voice_event::type::START,
+                           voices[active_count - 1].slot});
+      return;
+    }
+
+    const auto index = steal_candidate();
+    if (index >= active_count) {
+      return;
+    }
+
+    auto &v = voices[index];
+    v = {v.slot, channel, note, m.velocity, true, false, next_age++};
+    on_event(voice_event{voice_event::type::STEAL, v.slot});
+  }
+
+  template <typename F>
+  void pedal_event(const uint8_t channel, const bool down, F &&on_event) {
+    pedal[channel] = down;
+    if (down) {
+      return;
+    }
+
+    for (std::size_t i = 0; i < active_count; ++i) {
+      auto &v = voices[i];
+      if (v.channel == channel && v.sustained) {
+        v.sustained = false;
+        v.gate = false;
+        on_event(voice_event{voice_event::type::RELEASE, v.slot});
+      }
+    }
+  }
+
+  /*! \brief The position of the voice to steal or active_count if none. */
+  [[nodiscard]] std::size_t steal_candidate() const {
+    if (active_count == 0) {
+      return active_count;
+    }
+
+    // Released voices are the cheapest to steal, the oldest of them first.
+    std::size_t candidate = active_count;
+    for (std::size_t i = 0; i < active_count; ++i) {
+      if (!voices[i].gate &&
+          (candidate == active_count || voices[i].age < voices[candidate].age)) {
+        candidate = i;
+      }
+    }
+    if (candidate < active_count || policy == steal_policy::NONE) {
+      return candidate;
+    }
+
+    candidate = 0;
+    for (std::size_t i = 1; i < active_count; ++i) {
+      const auto &v = voices[i];
+      const auto &c = voices[candidate];
+      bool better = false;
+      switch (policy) {
+      case steal_policy::OLDEST:
+        better = v.age < c.age;
+        break;
+      case steal_policy::QUIETEST:
+        better = v.velocity < c.velocity ||
+                 (v.velocity == c.velocity && v.age < c.age);
+        break;
+      case steal_policy::LOWEST:
+        better = v.note < c.note || (v.note == c.note && v.age < c.age);
+        break;
+      case steal_policy::HIGHEST:
+        better = v.note > c.note || (v.note == c.note && v.age < c.age);
+        break;
+      case steal_policy::NONE:
+        break;
+      }
+
+      if (better) {
+        candidate = i;
+      }
+    }
+
+    return candidate;
+  }
+
+  steal_policy policy;
+  std::array<voice, MAX_VOICES> voices{};
+  std::size_t active_count = 0;
+  std::array<uint16_t, MAX_VOICES> free_slots{};
+  std::size_t free_count = 0;
+  std::array<bool, 16> pedal{};
+  uint32_t next_age = 0;
+};
+
+} // namespace pwcpp::midi
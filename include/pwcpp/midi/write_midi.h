@@ -0,0 +1,226 @@
+#pragma once
+
+#include "pwcpp/buffer.h"
+#include "pwcpp/error.h"
+#include "pwcpp/midi/message.h"
+#include "pwcpp/midi/translate.h"
+#include "pwcpp/spa/pod/sequence_writer.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <variant>
+
+#include <spa/control/control.h>
+
+namespace pwcpp::midi {
+
+/*! \brief The wire format written to an output port. */
+enum class midi_format {
+  /*! \brief 64 bit midi 2.0 channel voice UMP (`SPA_CONTROL_UMP`). */
+  UMP,
+  /*! \brief 32 bit midi 1.0 channel voice UMP (`SPA_CONTROL_UMP`). */
+  UMP_MIDI_1,
+  /*! \brief Midi 1.0 byte messages (`SPA_CONTROL_Midi`). */
+  MIDI_1,
+};
+
+/*! \brief Encode a message as 64 bit midi 2.0 channel voice UMP in group 0.
+ *
+ * The inverse of `parse_ump_64`.
+ */
+inline std::array<uint32_t, 2> encode_ump_64(const midi::message &message) {
+  return std::visit(
+      [](const auto &m) -> std::array<uint32_t, 2> {
+        using T = std::decay_t<decltype(m)>;
+        const uint32_t channel = static_cast<uint32_t>(m.channel & 0x0f) << 16;
+        if constexpr (std::is_same_v<T, control_change>) {
+          return {0x40b00000u | channel | (m.cc_number & 0x7fu) << 8, m.value};
+        } else if constexpr (std::is_same_v<T, note_off>) {
+          return {0x40800000u | channel | (m.note & 0x7fu) << 8,
+                  static_cast<uint32_t>(m.velocity) << 16};
+        } else if constexpr (std::is_same_v<T, note_on>) {
+          return {0x40900000u | channel | (m.note & 0x7fu) << 8,
+                  static_cast<uint32_t>(m.velocity) << 16};
+        } else if constexpr (std::is_same_v<T, poly_pressure>) {
+          return {0x40a00000u | channel | (m.note & 0x7fu) << 8, m.value};
+        } else if constexpr (std::is_same_v<T, channel_pressure>) {
+          return {0x40d00000u | channel, m.value};
+        } else if constexpr (std::is_same_v<T, pitch_bend>) {
+          return {0x40e00000u | channel, m.value};
+        } else if constexpr (std::is_same_v<T, program_change>) {
+          return {0x40c00000u | channel | (m.bank_valid ? 1u : 0u),
+                  (m.program & 0x7fu) << 24 | (m.bank_msb & 0x7fu) << 8 |
+                      (m.bank_lsb & 0x7fu)};
+        } else {
+          constexpr uint32_t status =
+              std::is_same_v<T, registered_controller> ? 0x40200000u
+                                                       : 0x40300000u;
+          return {status | channel | (m.bank & 0x7fu) << 8 | (m.index & 0x7fu),
+                  m.value};
+        }
+      },
+      message);
+}
+
+/*! \brief Encode a message as midi 1.0 bytes.
+ *
+ * The values of a message have midi 2.0 resolution and are scaled down,
+ * messages without a single midi 1.0 equivalent are encoded as several
+ * messages, see `ump_64_to_ump_32`.
+ *
+ * \return The number of messages written to `out`.
+ */
+inline std::size_t
+encode_midi_1(const midi::message &message,
+              std::span<midi_1_message, max_translated_messages> out,
+              const translator_options &options = {}) {
+  const auto words = encode_ump_64(message);
+  return ump_64_to_midi_1(words, out, options);
+}
+
+/*! \brief Writes midi messages into the buffer of an output port.
+ *
+ * Messages are encoded as UMP or midi 1.0 and written with their sample
+ * offset. Offsets have to be ascending, a message that does not fit into the
+ * buffer is reported as an overflow and not written.
+ */
+class MidiWriter {
+public:
+  /*! \brief Construct a writer for the given spa data.
+   *
+   * \param data The spa data of the output buffer.
+   * \param format The format to encode the messages in.
+   * \param options The options of the translation to midi 1.0.
+   */
+  explicit MidiWriter(const struct spa_data &data,
+                      midi_format format = midi_format::UMP,
+                      translator_options options = {})
+      : sequence_writer(data), format(format), options(options) {}
+
+  /*! \brief Write a message at the given sample offset.
+   *
+   * A message that is translated to several midi 1.0 messages is written
+   * completely or not at all.
+   */
+  std::expected<void, error> write(const uint32_t offset,
+                                   const midi::message &message) {
+    const auto words = encode_ump_64(message);
+    if (format == midi_format::UMP) {
+      return write_ump(offset, words);
+    }
+
+    std::array<uint32_t, max_translated_messages> translated;
+    const auto count = ump_64_to_ump_32(words, translated, options);
+    const uint32_t control_size = format == midi_format::UMP_MIDI_1 ? 4 : 3;
+    if (count * spa::pod::SequenceWriter::required_size(control_size) >
+        sequence_writer.remaining()) {
+      return std::unexpected(error::sequence_writing_buffer_overflow());
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+      std::expected<void, error> result;
+      if (format == midi_format::UMP_MIDI_1) {
+        result = write_ump(offset, std::span<const uint32_t>(&translated[i], 1));
+      } else {
+        const auto bytes = ump_32_to_midi_1(translated[i]);
+        result = write_midi_1(
+            offset, std::span<const uint8_t>(bytes.bytes.data(), bytes.size));
+      }
+
+      if (!result.has_value()) {
+        return result;
+      }
+    }
+
+    return {};
+  }
+
+  /*! \brief Write a message at its sample offset. */
+  std::expected<void, error> write(const timed_message &message) {
+    return write(message.offset, message.message);
+  }
+
+  /*! \brief Write a system common or real time message, e.g. a midi clock.
+   *
+   * UMP formats write a 32 bit system UMP in group 0, midi 1.0 writes the
+   * bytes unchanged.
+   *
+   * \param bytes The status byte followed by up to two data bytes.
+   */
+  std::expected<void, error> write_system(const uint32_t offset,
+                                          std::span<const uint8_t> bytes) {
+    if (format == midi_format::MIDI_1) {
+      return write_midi_1(offset, bytes);
+    }
+
+    uint32_t word = 0x10000000u;
+    for (std::size_t i = 0; i < bytes.size() && i < 3; ++i) {
+      word |= static_cast<uint32_t>(bytes[i]) << (16 - 8 * i);
+    }
+    return write_ump(offset, std::span<const uint32_t>(&word, 1));
+  }
+
+  /*! \brief Write raw UMP words as one control. */
+  std::expected<void, error> write_ump(const uint32_t offset,
+                                       std::span<const uint32_t> words) {
+    return sequence_writer.write(offset, SPA_CONTROL_UMP, words.data(),
+                                 static_cast<uint32_t>(words.size_bytes()));
+  }
+
+  /*! \brief Write raw midi 1.0 bytes as one control. */
+  std::expected<void, error> write_midi_1(const uint32_t offset,
+                                          std::span<const uint8_t> bytes) {
+    return sequence_writer.write(offset, SPA_CONTROL_Midi, bytes.data(),
+                                 static_cast<uint32_t>(bytes.size()));
+  }
+
+  /*! \brief The number of messages written so far. */
+  [[nodiscard]] std::size_t size() const { return sequence_writer.size(); }
+
+  /*! \brief Complete the sequence, see SequenceWriter::finish. */
+  void finish() { sequence_writer.finish(); }
+
+private:
+  spa::pod::SequenceWriter sequence_writer;
+  midi_format format;
+  translator_options options;
+};
+
+/*! \brief Write timed midi messages into a buffer of an output port.
+ *
+ * The counterpart of `parse_midi`. Writing stops at the first message that
+ * can't be written, the messages written up to that point are kept.
+ *
+ * \param buffer The output buffer.
+ * \param messages The timed messages in ascending offset order.
+ * \param format The format to encode the messages in.
+ *
+ * \return The number of written messages or the error that stopped writing.
+ */
+template <std::ranges::input_range R>
+std::expected<std::size_t, error>
+write_midi(Buffer &buffer, R &&messages,
+           midi_format format = midi_format::UMP) {
+  auto spa_data = buffer.get_spa_data(0);
+  if (!spa_data.has_value()) {
+    return 0;
+  }
+
+  MidiWriter writer(spa_data.value(), format);
+  for (const timed_message &message : messages) {
+    if (auto result = writer.write(message); !result.has_value()) {
+      writer.finish();
+      return std::unexpected(result.error());
+    }
+  }
+
+  writer.finish();
+  return writer.size();
+}
+
+} // namespace pwcpp::midi
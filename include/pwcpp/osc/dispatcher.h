@@ -0,0 +1,502 @@
+#pragma once
+
+#include "pwcpp/error.h"
+#include "pwcpp/osc/packet_view.h"
+
+#include <oscpp/error.hpp>
+#include <oscpp/server.hpp>
+#include <oscpp/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pwcpp::osc {
+
+namespace detail {
+using char_set = std::bitset<256>;
+
+/*! \brief A character of a pattern: a set of matching characters, repeated
+ * any number of times for `*`. */
+struct pattern_atom {
+  char_set characters;
+  bool repeat = false;
+};
+
+/*! \brief All characters but the separator. */
+inline char_set any_character() {
+  char_set characters;
+  characters.set();
+  characters.reset(0);
+  characters.reset('/');
+  return characters;
+}
+
+/*! \brief Expand the `{a,b}` alternatives of a pattern. */
+inline std::expected<std::vector<std::string>, error>
+expand_alternatives(std::string_view pattern) {
+  const auto open = pattern.find('{');
+  if (open == std::string_view::npos) {
+    if (pattern.find('}') != std::string_view::npos) {
+      return std::unexpected(error::osc_invalid_address_pattern());
+    }
+    return std::vector<std::string>{std::string(pattern)};
+  }
+
+  const auto close = pattern.find('}', open);
+  if (close == std::string_view::npos ||
+      pattern.substr(open + 1, close - open - 1).find('{') !=
+          std::string_view::npos) {
+    return std::unexpected(error::osc_invalid_address_pattern());
+  }
+
+  auto tails = expand_alternatives(pattern.substr(close + 1));
+  if (!tails.has_value()) {
+    return tails;
+  }
+
+  std::vector<std::string> result;
+  auto alternatives = pattern.substr(open + 1, close - open - 1);
+  while (true) {
+    const auto comma = alternatives.find(',');
+    const auto alternative = alternatives.substr(0, comma);
+    for (const auto &tail : tails.value()) {
+      result.push_back(std::string(pattern.substr(0, open)) +
+                       std::string(alternative) + tail);
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    alternatives = alternatives.substr(comma + 1);
+  }
+  return result;
+}
+
+/*! \brief Parse a pattern without alternatives into atoms. */
+inline std::expected<std::vector<pattern_atom>, error>
+parse_pattern(std::string_view pattern) {
+  if (pattern.empty() || pattern.front() != '/') {
+    return std::unexpected(error::osc_invalid_address_pattern());
+  }
+
+  std::vector<pattern_atom> atoms;
+  for (std::size_t i = 0; i < pattern.size(); ++i) {
+    const auto c = static_cast<uint8_t>(pattern[i]);
+    pattern_atom atom;
+    if (c == '*') {
+      atom = {any_character(), true};
+    } else if (c == '?') {
+      atom = {any_character(), false};
+    } else if (c == '[') {
+      const auto close = pattern.find(']', i + 1);
+      if (close == std::string_view::npos || close == i + 1) {
+        return std::unexpected(error::osc_invalid_address_pattern());
+      }
+
+      auto body = pattern.substr(i + 1, close - i - 1);
+      const bool negated = body.front() == '!';
+      if (negated) {
+        body.remove_prefix(1);
+      }
+
+      char_set characters;
+      for (std::size_t j = 0; j < body.size(); ++j) {
+        if (j + 2 < body.size() && body[j + 1] == '-') {
+          const auto first = static_cast<uint8_t>(body[j]);
+          const auto last = static_cast<uint8_t>(body[j + 2]);
+          for (unsigned k = first; k <= last; ++k) {
+            characters.set(k);
+          }
+          j += 2;
+        } else {
+          characters.set(static_cast<uint8_t>(body[j]));
+        }
+      }
+
+      atom.characters = (negated ? ~characters : characters) & any_character();
+      i = close;
+    } else if (c == ']') {
+      return std::unexpected(error::osc_invalid_address_pattern());
+    } else {
+      atom.characters.set(c);
+    }
+
+    // Consecutive stars match the same as one.
+    if (atom.repeat && !atoms.empty() && atoms.back().repeat) {
+      continue;
+    }
+    atoms.push_back(atom);
+  }
+  return atoms;
+}
+
+/*! \brief Check whether an argument with the given tag can be read as T. */
+template <typename T> constexpr bool accepts_tag(const char tag) {
+  if constexpr (std::is_same_v<T, int32_t> || std::is_same_v<T, float>) {
+    return tag == 'i' || tag == 'f';
+  } else if constexpr (std::is_same_v<T, const char *>) {
+    return tag == 's';
+  } else if constexpr (std::is_same_v<T, OSCPP::Blob>) {
+    return tag == 'b';
+  } else if constexpr (std::is_same_v<T, OSCPP::Server::ArgStream>) {
+    return tag == '[';
+  } else {
+    static_assert(!sizeof(T), "Unsupported OSC argument type.");
+    return false;
+  }
+}
+
+/*! \brief Read the next argument as T, a float read as int32_t is rounded
+ * to the nearest integer. */
+template <typename T> T next_argument(OSCPP::Server::ArgStream &args) {
+  if constexpr (std::is_same_v<T, int32_t>) {
+    if (args.tag() == 'f') {
+      const auto value = std::round(static_cast<double>(args.float32()));
+      return std::isnan(value) ? 0
+                               : static_cast<int32_t>(std::clamp(
+                                     value, -2147483648.0, 2147483647.0));
+    }
+  }
+  return args.next<T>();
+}
+} // namespace detail
+
+/*! \brief Dispatches OSC messages to handlers by address pattern.
+ *
+ * Handlers are registered for address patterns with the OSC wildcards `*`,
+ * `?`, `[abc]`, `[a-z]`, `[!a-z]` and `{foo,bar}`. Dispatcher::compile turns
+ * all patterns into one deterministic automaton over classes of equivalent
+ * characters, so dispatching a message costs one table lookup per character
+ * of its address, independent of the number of patterns. A message invokes
+ * every handler whose pattern matches its address.
+ *
+ * Handlers receive their arguments unpacked to the types they are
+ * registered with: `int32_t`, `float`, `const char *`, `OSCPP::Blob` or
+ * `OSCPP::Server::ArgStream` for arrays. Numbers convert between int and
+ * float, floats are rounded to the nearest int. Messages whose arguments
+ * don't match are not passed to the handler and are counted.
+ *
+ * Registering and compiling allocate and happen on the main loop, a compiled
+ * dispatcher is handed to the process callback, e.g. with rt::Swappable.
+ * Dispatching doesn't allocate.
+ */
+class Dispatcher {
+public:
+  /*! \brief The default limit of automaton states. */
+  static constexpr std::size_t default_max_states = 1 << 16;
+
+  /*! \brief Register a handler called with the unpacked arguments.
+   *
+   * \tparam Args The types of the leading arguments of the message, more
+   * arguments are ignored.
+   */
+  template <typename... Args, typename F>
+  std::expected<void, error> on(std::string_view pattern, F &&f) {
+    return add(pattern,
+               unpacking<Args...>(
+                   [f = std::forward<F>(f)](uint32_t, Args... args) mutable {
+                     f(args...);
+                   }));
+  }
+
+  /*! \brief Register a handler called with the sample offset of the message
+   * followed by the unpacked arguments. */
+  template <typename... Args, typename F>
+  std::expected<void, error> on_timed(std::string_view pattern, F &&f) {
+    return add(pattern, unpacking<Args...>(std::forward<F>(f)));
+  }
+
+  /*! \brief Compile the registered patterns, called after registering and
+   * before dispatching.
+   *
+   * \param max_states The maximum number of automaton states, patterns with
+   * many wildcards can create a number of states exponential in their count.
+   */
+  std::expected<void, error>
+  compile(const std::size_t max_states = default_max_states) {
+    // Built aside, so a failed compile keeps the previous automaton.
+    std::array<uint16_t, 256> classes{};
+    std::vector<uint8_t> class_representatives;
+    const auto count =
+        build_character_classes(classes, class_representatives);
+
+    std::map<std::vector<uint32_t>, uint32_t> ids;
+    std::vector<std::vector<uint32_t>> sets;
+    std::vector<uint32_t> next_transitions;
+    std::vector<uint32_t> next_accepts;
+    std::vector<accept_range> next_accept_ranges;
+
+    // State 0 rejects every address.
+    sets.emplace_back();
+    ids[{}] = 0;
+
+    std::vector<uint32_t> start_set;
+    for (uint32_t p = 0; p < patterns.size(); ++p) {
+      add_closure(start_set, p, 0);
+    }
+    normalize(start_set);
+    ids[start_set] = 1;
+    sets.push_back(start_set);
+
+    for (std::size_t state = 0; state < sets.size(); ++state) {
+      next_transitions.resize((state + 1) * count, 0);
+      for (std::size_t c = 0; c < count; ++c) {
+        std::vector<uint32_t> next;
+        for (const auto position : sets[state]) {
+          const auto [p, i] = split(position);
+          const auto &atoms = patterns[p].atoms;
+          if (i < atoms.size() &&
+              atoms[i].characters.test(class_representatives[c])) {
+            add_closure(next, p, atoms[i].repeat ? i : i + 1);
+          }
+        }
+        normalize(next);
+
+        auto [it, inserted] =
+            ids.try_emplace(next, static_cast<uint32_t>(sets.size()));
+        if (inserted) {
+          if (sets.size() == max_states) {
+            return std::unexpected(error::osc_patterns_too_complex());
+          }
+          sets.push_back(next);
+        }
+        next_transitions[state * count + c] = it->second;
+      }
+
+      const auto begin = static_cast<uint32_t>(next_accepts.size());
+      for (const auto position : sets[state]) {
+        const auto [p, i] = split(position);
+        if (i == patterns[p].atoms.size()) {
+          next_accepts.push_back(patterns[p].handler);
+        }
+      }
+      std::sort(next_accepts.begin() + begin, next_accepts.end());
+      next_accepts.erase(
+          std::unique(next_accepts.begin() + begin, next_accepts.end()),
+          next_accepts.end());
+      next_accept_ranges.push_back(
+          {begin, static_cast<uint32_t>(next_accepts.size())});
+    }
+
+    character_classes = classes;
+    representatives = std::move(class_representatives);
+    class_count = count;
+    transitions = std::move(next_transitions);
+    accepts = std::move(next_accepts);
+    accept_ranges = std::move(next_accept_ranges);
+    return {};
+  }
+
+  /*! \brief Dispatch a message to the handlers matching its address.
+   *
+   * \param offset The sample offset passed to timed handlers.
+   *
+   * \return The number of handlers that were called.
+   */
+  std::size_t dispatch(const OSCPP::Server::Message &message,
+                       const uint32_t offset = 0) const {
+    const auto state = match(message.address());
+    if (state == 0 || accept_ranges[state].begin == accept_ranges[state].end) {
+      unmatched_messages++;
+      return 0;
+    }
+
+    std::size_t called(0);
+    const auto &range = accept_ranges[state];
+    for (auto i = range.begin; i < range.end; ++i) {
+      if (handlers[accepts[i]](offset, message.args())) {
+        called++;
+      } else {
+        mismatched_messages++;
+      }
+    }
+    return called;
+  }
+
+  /*! \brief Dispatch a message of a PacketView. */
+  std::size_t dispatch(const timed_packet &packet) const {
+    try {
+      return dispatch(static_cast<OSCPP::Server::Message>(packet.packet),
+                      packet.offset);
+    } catch (const OSCPP::Error &) {
+      mismatched_messages++;
+      return 0;
+    }
+  }
+
+  /*! \brief Check whether an address matches a registered pattern. */
+  [[nodiscard]] bool matches(const char *address) const {
+    const auto state = match(address);
+    return state != 0 &&
+           accept_ranges[state].begin != accept_ranges[state].end;
+  }
+
+  /*! \brief The number of dispatched messages no pattern matched. */
+  [[nodiscard]] std::size_t unmatched() const { return unmatched_messages; }
+
+  /*! \brief The number of handler calls skipped because the arguments didn't
+   * match the handler or were malformed. */
+  [[nodiscard]] std::size_t mismatched() const { return mismatched_messages; }
+
+  /*! \brief The number of automaton states. */
+  [[nodiscard]] std::size_t states() const { return accept_ranges.size(); }
+
+private:
+  using handler =
+      std::function<bool(uint32_t offset, OSCPP::Server::ArgStream args)>;
+
+  struct compiled_pattern {
+    std::vector<detail::pattern_atom> atoms;
+    uint32_t handler;
+    uint32_t base;
+  };
+
+  struct accept_range {
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  template <typename... Args, typename F> static handler unpacking(F &&f) {
+    return [f = std::forward<F>(f)](const uint32_t offset,
+                                    OSCPP::Server::ArgStream args) mutable
+           -> bool {
+      if (args.size() < sizeof...(Args)) {
+        return false;
+      }
+
+      const char *tags = std::get<0>(args.state()).pos();
+      std::size_t index(0);
+      if (!(detail::accepts_tag<Args>(tags[index++]) && ...)) {
+        return false;
+      }
+
+      try {
+        // Braced initialization reads the arguments in order.
+        std::tuple<Args...> values{detail::next_argument<Args>(args)...};
+        std::apply([&](auto... unpacked) { f(offset, unpacked...); }, values);
+      } catch (const OSCPP::Error &) {
+        return false;
+      }
+      return true;
+    };
+  }
+
+  std::expected<void, error> add(std::string_view pattern, handler h) {
+    auto expanded = detail::expand_alternatives(pattern);
+    if (!expanded.has_value()) {
+      return std::unexpected(expanded.error());
+    }
+
+    std::vector<compiled_pattern> added;
+    for (const auto &alternative : expanded.value()) {
+      auto atoms = detail::parse_pattern(alternative);
+      if (!atoms.has_value()) {
+        return std::unexpected(atoms.error());
+      }
+      added.push_back({std::move(atoms.value()),
+                       static_cast<uint32_t>(handlers.size()), positions});
+      positions += static_cast<uint32_t>(added.back().atoms.size() + 1);
+    }
+
+    handlers.push_back(std::move(h));
+    for (auto &p : added) {
+      pattern_of_position.resize(p.base + p.atoms.size() + 1,
+                                 static_cast<uint32_t>(patterns.size()));
+      patterns.push_back(std::move(p));
+    }
+    return {};
+  }
+
+  /*! \brief Split bytes into classes that no pattern distinguishes.
+   *
+   * \return The number of classes.
+   */
+  std::size_t
+  build_character_classes(std::array<uint16_t, 256> &classes,
+                          std::vector<uint8_t> &class_representatives) const {
+    classes.fill(0);
+    std::size_t count(1);
+    for (const auto &p : patterns) {
+      for (const auto &atom : p.atoms) {
+        std::map<std::pair<uint16_t, bool>, uint16_t> refined;
+        for (std::size_t b = 0; b < 256; ++b) {
+          const auto key = std::make_pair(classes[b], atom.characters.test(b));
+          auto [it, inserted] = refined.try_emplace(
+              key, static_cast<uint16_t>(refined.size()));
+          classes[b] = it->second;
+        }
+        count = refined.size();
+      }
+    }
+
+    class_representatives.assign(count, 0);
+    for (std::size_t b = 256; b > 0; --b) {
+      class_representatives[classes[b - 1]] = static_cast<uint8_t>(b - 1);
+    }
+    return count;
+  }
+
+  void add_closure(std::vector<uint32_t> &set, const uint32_t p,
+                   std::size_t i) const {
+    const auto &atoms = patterns[p].atoms;
+    set.push_back(patterns[p].base + static_cast<uint32_t>(i));
+    while (i < atoms.size() && atoms[i].repeat) {
+      set.push_back(patterns[p].base + static_cast<uint32_t>(++i));
+    }
+  }
+
+  static void normalize(std::vector<uint32_t> &set) {
+    std::sort(set.begin(), set.end());
+    set.erase(std::unique(set.begin(), set.end()), set.end());
+  }
+
+  [[nodiscard]] std::pair<uint32_t, std::size_t>
+  split(const uint32_t position) const {
+    const auto p = pattern_of_position[position];
+    return {p, position - patterns[p].base};
+  }
+
+  [[nodiscard]] uint32_t match(const char *address) const {
+    if (accept_ranges.empty() || address == nullptr) {
+      return 0;
+    }
+
+    uint32_t state = 1;
+    for (; *address != '\0' && state != 0; ++address) {
+      state = transitions[state * class_count +
+                          character_classes[static_cast<uint8_t>(*address)]];
+    }
+    return state;
+  }
+
+  std::vector<handler> handlers;
+  std::vector<compiled_pattern> patterns;
+  std::vector<uint32_t> pattern_of_position;
+  uint32_t positions = 0;
+
+  std::array<uint16_t, 256> character_classes{};
+  std::vector<uint8_t> representatives;
+  std::size_t class_count = 1;
+  std::vector<uint32_t> transitions;
+  std::vector<uint32_t> accepts;
+  std::vector<accept_range> accept_ranges;
+
+  // Counted by the dispatching thread, dispatching a compiled dispatcher
+  // doesn't change it otherwise.
+  mutable std::size_t unmatched_messages = 0;
+  mutable std::size_t mismatched_messages = 0;
+};
+
+} // namespace pwcpp::osc
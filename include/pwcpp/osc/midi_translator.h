@@ -0,0 +1,386 @@
+#pragma once
+
+#include "pwcpp/error.h"
+#include "pwcpp/midi/message.h"
+#include "pwcpp/midi/router.h"
+#include "pwcpp/midi/write_midi.h"
+#include "pwcpp/osc/dispatcher.h"
+#include "pwcpp/osc/packet_view.h"
+#include "pwcpp/osc/write_osc.h"
+#include "pwcpp/rt/swappable.h"
+
+#include <oscpp/server.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace pwcpp::osc {
+
+/*! \brief Translates one kind of midi message to an OSC address and back.
+ *
+ * The midi value, e.g. the controller value or the velocity, is sent as a
+ * float argument scaled to `[minimum, maximum]`. A mapping without a number
+ * covers all controllers or notes of the channel and sends the number as an
+ * int32 argument before the value, OSC messages with a number outside of 0
+ * to 127 are dropped.
+ */
+struct midi_osc_mapping {
+  /*! \brief The kind of message, registered and assignable controllers are
+   * not supported. */
+  midi::message_kind kind;
+  /*! \brief The midi channel, 0 to 15. */
+  uint8_t channel = 0;
+  /*! \brief The controller or note, ignored for channel pressure, pitch bend
+   * and program change. */
+  std::optional<uint8_t> number;
+  /*! \brief The OSC address. */
+  std::string address;
+  /*! \brief The OSC value of the lowest midi value. */
+  float minimum = 0.0f;
+  /*! \brief The OSC value of the highest midi value. */
+  float maximum = 1.0f;
+};
+
+/*! \brief Translates between midi messages and OSC messages inside a
+ * filter.
+ *
+ * MidiOscTranslator::set_mappings compiles the mappings on the main loop:
+ * midi messages are looked up in a flat table indexed by kind, channel and
+ * number, OSC addresses in an osc::Dispatcher. Both are handed to the
+ * process callback with rt::Swappable, so a filter can convert its midi
+ * input to an OSC output port and its OSC input to a midi output port in the
+ * same cycle, without another node in the graph. Translated messages keep
+ * the sample offset of their source.
+ *
+ * Values are scaled between the full midi resolution and the float range of
+ * the mapping, values outside the range are clamped.
+ */
+class MidiOscTranslator {
+public:
+  MidiOscTranslator() = default;
+  MidiOscTranslator(const MidiOscTranslator &) = delete;
+  MidiOscTranslator &operator=(const MidiOscTranslator &) = delete;
+
+  /*! \brief Replace the mappings. Called from the main loop.
+   *
+   * If several mappings match a midi message, a mapping with a number takes
+   * precedence over one without, otherwise the first one is used. Incoming
+   * OSC messages are translated by every mapping of their address.
+   */
+  std::expected<void, error>
+  set_mappings(const std::vector<midi_osc_mapping> &mappings) {
+    // The table entries hold the index of a mapping plus one.
+    if (mappings.size() > std::numeric_limits<uint16_t>::max()) {
+      return std::unexpected(error::configuration());
+    }
+
+    auto next = std::make_unique<table>();
+    next->entries.assign(kinds * 16 * 128, 0);
+    next->mappings.reserve(mappings.size());
+
+    for (const auto &mapping : mappings) {
+      const auto kind = static_cast<std::size_t>(mapping.kind);
+      if (kind >= kinds || mapping.channel > 15 ||
+          (mapping.number.has_value() && mapping.number.value() > 127) ||
+          mapping.maximum == mapping.minimum) {
+        return std::unexpected(error::configuration());
+      }
+
+      const auto index = next->mappings.size();
+      next->mappings.push_back(mapping);
+
+      std::expected<void, error> added;
+      if (has_number(mapping.kind) && !mapping.number.has_value()) {
+        added = next->dispatcher.on_timed<int32_t, float>(
+            mapping.address,
+            [this, index](const uint32_t offset, const int32_t number,
+                          const float value) {
+              receive(offset, index, number, value);
+            });
+      } else {
+        added = next->dispatcher.on_timed<float>(
+            mapping.address,
+            [this, index](const uint32_t offset, const float value) {
+              receive(offset, index, std::nullopt, value);
+            });
+      }
+      if (!added.has_value()) {
+        return std::unexpected(added.error());
+      }
+    }
+
+    if (auto compiled = next->dispatcher.compile(); !compiled.has_value()) {
+      return std::unexpected(compiled.error());
+    }
+
+    // Mappings with a number first, so they win over the ones without.
+    for (const bool numbered : {true, false}) {
+      for (std::size_t i = 0; i < next->mappings.size(); ++i) {
+        const auto &mapping = next->mappings[i];
+        const bool specific =
+            !has_number(mapping.kind) || mapping.number.has_value();
+        if (specific != numbered) {
+          continue;
+        }
+
+        const auto base =
+            entry_index(static_cast<std::size_t>(mapping.kind), mapping.channel, 0);
+        const std::size_t first = has_number(mapping.kind)
+                                      ? mapping.number.value_or(0)
+                                      : 0;
+        const std::size_t last = specific ? first : 127;
+        for (auto number = first; number <= last; ++number) {
+          auto &entry = next->entries[base + number];
+          if (entry == 0) {
+            entry = static_cast<uint16_t>(i + 1);
+          }
+        }
+      }
+    }
+
+    tables.publish(std::move(next));
+    return {};
+  }
+
+  /*! \brief Translate midi messages to OSC messages.
+   *
+   * Called from the process callback. Doesn't allocate or block.
+   *
+   * \param messages midi::timed_message values, or the
+   * `std::optional<midi::message>` values of midi::parse_midi, which are
+   * written at offset 0.
+   * \param writer The writer of the OSC output port.
+   *
+   * \return The number of written OSC messages.
+   */
+  template <std::ranges::input_range R>
+  std::size_t midi_to_osc(R &&messages, OscWriter &writer) {
+    const auto *current = tables.acquire();
+    if (current == nullptr) {
+      return 0;
+    }
+
+    std::size_t sent(0);
+    for (const auto &element : messages) {
+      uint32_t offset(0);
+      const midi::message *message = nullptr;
+      using T = std::decay_t<decltype(element)>;
+      if constexpr (std::is_same_v<T, midi::timed_message>) {
+        offset = element.offset;
+        message = &element.message;
+      } else if constexpr (std::is_same_v<T, std::optional<midi::message>>) {
+        if (!element.has_value()) {
+          continue;
+        }
+        message = &element.value();
+      } else {
+        static_assert(!sizeof(T), "Unsupported midi message type.");
+      }
+
+      const auto kind = message->index();
+      if (kind >= kinds) {
+        continue;
+      }
+      const auto [channel, number, value] = decompose(*message);
+      const auto entry = current->entries[entry_index(kind, channel, number)];
+      if (entry == 0) {
+        continue;
+      }
+
+      const auto &mapping = current->mappings[entry - 1];
+      const float scaled = static_cast<float>(
+          mapping.minimum + (mapping.maximum - mapping.minimum) * value);
+      std::expected<void, error> result;
+      if (has_number(mapping.kind) && !mapping.number.has_value()) {
+        result = writer.write_message(offset, mapping.address.c_str(),
+                                      static_cast<int32_t>(number), scaled);
+      } else {
+        result = writer.write_message(offset, mapping.address.c_str(), scaled);
+      }
+      if (result.has_value()) {
+        sent++;
+      }
+    }
+    return sent;
+  }
+
+  /*! \brief Translate OSC messages to midi messages.
+   *
+   * Called from the process callback. Doesn't allocate or block.
+   *
+   * \param packets timed_packet values, e.g. a PacketView, or the
+   * `std::optional<OSCPP::Server::Packet>` values of parse_osc, which are
+   * written at offset 0. Bundles of parse_osc are skipped, PacketView
+   * flattens them.
+   * \param writer The writer of the midi output port.
+   *
+   * \return The number of written midi messages.
+   */
+  template <std::ranges::input_range R>
+  std::size_t osc_to_midi(R &&packets, midi::MidiWriter &writer) {
+    const auto *current = tables.acquire();
+    if (current == nullptr) {
+      return 0;
+    }
+
+    active = current;
+    midi_writer = &writer;
+    written = 0;
+    for (const auto &element : packets) {
+      using T = std::decay_t<decltype(element)>;
+      if constexpr (std::is_same_v<T, timed_packet>) {
+        current->dispatcher.dispatch(element);
+      } else if constexpr (std::is_same_v<T,
+                                          std::optional<OSCPP::Server::Packet>>) {
+        if (element.has_value() && element->isMessage()) {
+          current->dispatcher.dispatch(
+              timed_packet{0, immediately, element.value()});
+        }
+      } else {
+        static_assert(!sizeof(T), "Unsupported OSC packet type.");
+      }
+    }
+    midi_writer = nullptr;
+    active = nullptr;
+    return written;
+  }
+
+  /*! \brief Destroy tables the process callback no longer uses. Called from
+   * the main loop. */
+  void collect() { tables.collect(); }
+
+private:
+  static constexpr std::size_t kinds =
+      static_cast<std::size_t>(midi::message_kind::PROGRAM_CHANGE) + 1;
+
+  struct table {
+    std::vector<uint16_t> entries;
+    std::vector<midi_osc_mapping> mappings;
+    Dispatcher dispatcher;
+  };
+
+  struct components {
+    uint8_t channel;
+    uint8_t number;
+    /*! \brief The value normalized to `[0, 1]`. */
+    double value;
+  };
+
+  static constexpr bool has_number(const midi::message_kind kind) {
+    return kind == midi::message_kind::CONTROL_CHANGE ||
+           kind == midi::message_kind::NOTE_OFF ||
+           kind == midi::message_kind::NOTE_ON ||
+           kind == midi::message_kind::POLY_PRESSURE;
+  }
+
+  static constexpr std::size_t entry_index(const std::size_t kind,
+                                           const uint8_t channel,
+                                           const uint8_t number) {
+    return (kind * 16 + (channel & 0x0f)) * 128 + (number & 0x7f);
+  }
+
+  static components decompose(const midi::message &message) {
+    return std::visit(
+        [](const auto &m) -> components {
+          using T = std::decay_t<decltype(m)>;
+          if constexpr (std::is_same_v<T, midi::control_change>) {
+            return {m.channel, m.cc_number, m.value / 4294967295.0};
+          } else if constexpr (std::is_same_v<T, midi::note_on> ||
+                               std::is_same_v<T, midi::note_off>) {
+            return {m.channel, m.note, m.velocity / 65535.0};
+          } else if constexpr (std::is_same_v<T, midi::poly_pressure>) {
+            return {m.channel, m.note, m.value / 4294967295.0};
+          } else if constexpr (std::is_same_v<T, midi::channel_pressure> ||
+                               std::is_same_v<T, midi::pitch_bend>) {
+            return {m.channel, 0, m.value / 4294967295.0};
+          } else if constexpr (std::is_same_v<T, midi::program_change>) {
+            return {m.channel, 0, m.program / 127.0};
+          } else {
+            return {0, 0, 0.0};
+          }
+        },
+        message);
+  }
+
+  /*! \brief Write the midi message of an OSC message, called by the
+   * dispatcher.
+   *
+   * \param number The number argument of a mapping without a number,
+   * messages with a number outside of 0 to 127 are dropped.
+   */
+  void receive(const uint32_t offset, const std::size_t index,
+               const std::optional<int32_t> number, const float value) {
+    if (active == nullptr || midi_writer == nullptr) {
+      return;
+    }
+
+    const auto &mapping = active->mappings[index];
+    uint8_t n(0);
+    if (number.has_value()) {
+      if (number.value() < 0 || number.value() > 127) {
+        return;
+      }
+      n = static_cast<uint8_t>(number.value());
+    } else if (has_number(mapping.kind)) {
+      n = mapping.number.value_or(0);
+    }
+    const double normalized = std::clamp(
+        (static_cast<double>(value) - mapping.minimum) /
+            (static_cast<double>(mapping.maximum) - mapping.minimum),
+        0.0, 1.0);
+    const auto full = static_cast<uint32_t>(std::lround(normalized * 4294967295.0));
+    const auto velocity = static_cast<uint16_t>(std::lround(normalized * 65535.0));
+    const auto channel = mapping.channel;
+
+    midi::message message;
+    switch (mapping.kind) {
+    case midi::message_kind::CONTROL_CHANGE:
+      message = midi::control_change{channel, n, full};
+      break;
+    case midi::message_kind::NOTE_OFF:
+      message = midi::note_off{channel, n, velocity};
+      break;
+    case midi::message_kind::NOTE_ON:
+      message = midi::note_on{channel, n, velocity};
+      break;
+    case midi::message_kind::POLY_PRESSURE:
+      message = midi::poly_pressure{channel, n, full};
+      break;
+    case midi::message_kind::CHANNEL_PRESSURE:
+      message = midi::channel_pressure{channel, full};
+      break;
+    case midi::message_kind::PITCH_BEND:
+      message = midi::pitch_bend{channel, full};
+      break;
+    case midi::message_kind::PROGRAM_CHANGE:
+      message = midi::program_change{
+          channel, static_cast<uint8_t>(std::lround(normalized * 127.0)), false,
+          0, 0};
+      break;
+    default:
+      return;
+    }
+
+    if (midi_writer->write(offset, message).has_value()) {
+      written++;
+    }
+  }
+
+  rt::Swappable<table> tables;
+  const table *active = nullptr;
+  midi::MidiWriter *midi_writer = nullptr;
+  std::size_t written = 0;
+};
+
+} // namespace pwcpp::osc
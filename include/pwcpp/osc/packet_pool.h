@@ -0,0 +1,227 @@
+#pragma once
+
+#include "pwcpp/osc/write_osc.h"
+
+#include <oscpp/client.hpp>
+#include <oscpp/error.hpp>
+#include <oscpp/util.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+namespace pwcpp::osc {
+
+template <std::size_t SLOTS, std::size_t SLOT_SIZE> class PacketPool;
+
+/*! \brief A packet built in a buffer of a PacketPool, the buffer returns to
+ * the pool when the packet is destroyed or released. */
+template <std::size_t SLOTS, std::size_t SLOT_SIZE> class PooledPacket {
+public:
+  PooledPacket(const PooledPacket &) = delete;
+  PooledPacket &operator=(const PooledPacket &) = delete;
+
+  PooledPacket(PooledPacket &&other) noexcept
+      : pool(std::exchange(other.pool, nullptr)), slot(other.slot),
+        packet_size(other.packet_size) {}
+
+  PooledPacket &operator=(PooledPacket &&other) noexcept {
+    if (this != &other) {
+      release();
+      pool = std::exchange(other.pool, nullptr);
+      slot = other.slot;
+      packet_size = other.packet_size;
+    }
+    return *this;
+  }
+
+  ~PooledPacket() { release(); }
+
+  /*! \brief The encoded packet, e.g. for OscWriter::write_packet. */
+  [[nodiscard]] const void *data() const { return pool->buffer(slot); }
+
+  /*! \brief The size of the encoded packet. */
+  [[nodiscard]] std::size_t size() const { return packet_size; }
+
+  /*! \brief Return the buffer to the pool early. */
+  void release() {
+    if (pool != nullptr) {
+      pool->release(slot);
+      pool = nullptr;
+    }
+  }
+
+private:
+  friend class PacketPool<SLOTS, SLOT_SIZE>;
+
+  PooledPacket(PacketPool<SLOTS, SLOT_SIZE> *pool, const uint32_t slot)
+      : pool(pool), slot(slot) {}
+
+  PacketPool<SLOTS, SLOT_SIZE> *pool;
+  uint32_t slot;
+  std::size_t packet_size = 0;
+};
+
+/*! \brief A pool of fixed-size buffers to build OSC packets in.
+ *
+ * All buffers are allocated with the pool, taking and returning them never
+ * allocates, blocks or takes a lock, so the process callback can build
+ * outgoing packets without `DynamicPacket`'s malloc and without a
+ * `StaticPacket` sized for the largest packet on its stack. Free buffers are
+ * kept on a lock-free stack whose head carries a version tag against ABA,
+ * so packets may be built and destroyed on different threads, e.g. built
+ * in the process callback and destroyed by the main loop after sending.
+ *
+ * \tparam SLOTS The number of buffers.
+ * \tparam SLOT_SIZE The size of a buffer in bytes.
+ */
+template <std::size_t SLOTS, std::size_t SLOT_SIZE> class PacketPool {
+public:
+  static_assert(SLOTS > 0 && SLOTS < 0xffffffff);
+  static_assert(SLOT_SIZE % 8 == 0,
+                "Buffers have to keep the alignment of OSC packets.");
+
+  using packet_type = PooledPacket<SLOTS, SLOT_SIZE>;
+
+  /*! \brief The size of a buffer. */
+  static constexpr std::size_t slot_size = SLOT_SIZE;
+
+  PacketPool() {
+    for (uint32_t i = 0; i < SLOTS; ++i) {
+      next[i].store(i + 1 < SLOTS ? i + 1 : empty, std::memory_order_relaxed);
+    }
+    head.store(0, std::memory_order_relaxed);
+  }
+
+  PacketPool(const PacketPool &) = delete;
+  PacketPool &operator=(const PacketPool &) = delete;
+
+  /*! \brief Build a packet in a free buffer.
+   *
+   * \param size The size of the packet if known, e.g. from the
+   * `OSCPP::Size` helpers. A larger packet takes no buffer.
+   * \param build Called with an `OSCPP::Client::Packet` over the buffer. If
+   * it runs out of space the oscpp exception is caught and nothing is
+   * returned.
+   *
+   * \return The packet or nothing if it doesn't fit or all buffers are in
+   * use.
+   */
+  template <typename F>
+  std::optional<packet_type> build(const std::size_t size, F &&build) {
+    if (size > SLOT_SIZE) {
+      return std::nullopt;
+    }
+
+    auto slot = acquire();
+    if (!slot.has_value()) {
+      return std::nullopt;
+    }
+
+    packet_type pooled(this, slot.value());
+    OSCPP::Client::Packet packet(buffers[slot.value()].data(), SLOT_SIZE);
+    try {
+      build(packet);
+    } catch (const OSCPP::Error &) {
+      return std::nullopt;
+    } catch (const std::logic_error &) {
+      return std::nullopt;
+    }
+
+    pooled.packet_size = packet.size();
+    return pooled;
+  }
+
+  /*! \brief Build a packet in a free buffer, see PacketPool::build. */
+  template <typename F> std::optional<packet_type> build(F &&build) {
+    return this->build(SLOT_SIZE, std::forward<F>(build));
+  }
+
+  /*! \brief Build a message with the given arguments.
+   *
+   * The size is computed with the `OSCPP::Size` helpers first, so a message
+   * that doesn't fit takes no buffer.
+   *
+   * \param address The address of the message.
+   * \param arguments Arguments of type `int32_t`, `float`, `const char *` or
+   * `OSCPP::Blob`.
+   */
+  template <typename... Args>
+  std::optional<packet_type> message(const char *address,
+                                     const Args &...arguments) {
+    const std::size_t size =
+        OSCPP::Size::message(address, sizeof...(Args)) +
+        (std::size_t(0) + ... + detail::argument_size(arguments));
+    return build(size, [&](OSCPP::Client::Packet &packet) {
+      packet.openMessage(address, sizeof...(Args));
+      (detail::put_argument(packet, arguments), ...);
+      packet.closeMessage();
+    });
+  }
+
+  /*! \brief The number of buffers in use, read from any thread. */
+  [[nodiscard]] std::size_t used() const {
+    return in_use.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] static constexpr std::size_t capacity() { return SLOTS; }
+
+private:
+  friend class PooledPacket<SLOTS, SLOT_SIZE>;
+
+  static constexpr uint32_t empty = 0xffffffff;
+  static constexpr uint64_t tag_increment = uint64_t(1) << 32;
+  static constexpr uint64_t slot_mask = 0xffffffff;
+
+  std::optional<uint32_t> acquire() {
+    auto current = head.load(std::memory_order_acquire);
+    while (true) {
+      const auto slot = static_cast<uint32_t>(current & slot_mask);
+      if (slot == empty) {
+        return std::nullopt;
+      }
+
+      // A stale next is harmless, the tag makes the exchange fail.
+      const uint64_t replacement = ((current & ~slot_mask) + tag_increment) |
+                                   next[slot].load(std::memory_order_relaxed);
+      if (head.compare_exchange_weak(current, replacement,
+                                     std::memory_order_acquire,
+                                     std::memory_order_acquire)) {
+        in_use.fetch_add(1, std::memory_order_relaxed);
+        return slot;
+      }
+    }
+  }
+
+  void release(const uint32_t slot) {
+    auto current = head.load(std::memory_order_relaxed);
+    while (true) {
+      next[slot].store(static_cast<uint32_t>(current & slot_mask),
+                       std::memory_order_relaxed);
+      const uint64_t replacement =
+          ((current & ~slot_mask) + tag_increment) | slot;
+      if (head.compare_exchange_weak(current, replacement,
+                                     std::memory_order_release,
+                                     std::memory_order_relaxed)) {
+        in_use.fetch_sub(1, std::memory_order_relaxed);
+        return;
+      }
+    }
+  }
+
+  const void *buffer(const uint32_t slot) const {
+    return buffers[slot].data();
+  }
+
+  // The version tag in the upper and the first free slot in the lower half.
+  alignas(64) std::atomic<uint64_t> head;
+  std::atomic<std::size_t> in_use = 0;
+  std::array<std::atomic<uint32_t>, SLOTS> next;
+  alignas(8) std::array<std::array<uint8_t, SLOT_SIZE>, SLOTS> buffers{};
+};
+
+} // namespace pwcpp::osc
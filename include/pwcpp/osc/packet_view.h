@@ -0,0 +1,248 @@
+#pragma once
+
+#include "pwcpp/buffer.h"
+#include "pwcpp/error.h"
+#include "pwcpp/osc/parse_osc.h"
+
+#include <oscpp/server.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <iterator>
+#include <ranges>
+
+#include <spa/control/control.h>
+#include <spa/pod/iter.h>
+
+namespace pwcpp::osc {
+
+/*! \brief The OSC timetag that means "immediately". */
+inline constexpr uint64_t immediately = 1;
+
+/*! \brief An OSC message of a sequence. */
+struct timed_packet {
+  /*! \brief The sample offset of the control the message was found in. */
+  uint32_t offset = 0;
+  /*! \brief The timetag of the innermost enclosing bundle, `immediately` for
+   * messages outside of bundles. */
+  uint64_t time = immediately;
+  /*! \brief A view of the message in the buffer's memory. */
+  OSCPP::Server::Packet packet;
+};
+
+/*! \brief A lazy range over the OSC messages of a control sequence.
+ *
+ * The range yields a timed_packet for every message, in sequence order.
+ * Bundles are flattened without recursion: the elements of the open bundles
+ * are tracked on a fixed stack, so a burst of any size is visited without
+ * copies, allocations or capacity limits. The packets point into the
+ * sequence and are valid as long as the Buffer it was read from.
+ *
+ * Element sizes are checked before a packet is created, so iterating never
+ * throws. Controls that are not OSC, malformed packets and bundles nested
+ * deeper than `MAX_DEPTH` are skipped and reported to the diagnostics.
+ *
+ * \tparam MAX_DEPTH The maximum nesting depth of bundles.
+ */
+template <std::size_t MAX_DEPTH = 8>
+class PacketView : public std::ranges::view_interface<PacketView<MAX_DEPTH>> {
+public:
+  class iterator {
+  public:
+    using value_type = timed_packet;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+
+    iterator(const struct spa_pod_sequence *sequence,
+             ParseDiagnostics *diagnostics)
+        : sequence(sequence), diagnostics(diagnostics) {
+      if (sequence == nullptr) {
+        done = true;
+        return;
+      }
+      control = spa_pod_control_first(&sequence->body);
+      done = false;
+      advance();
+    }
+
+    const timed_packet &operator*() const { return current; }
+    const timed_packet *operator->() const { return &current; }
+
+    iterator &operator++() {
+      advance();
+      return *this;
+    }
+
+    void operator++(int) { advance(); }
+
+    bool operator==(std::default_sentinel_t) const { return done; }
+
+  private:
+    struct bundle {
+      const uint8_t *position;
+      const uint8_t *end;
+      uint64_t time;
+    };
+
+    void advance() {
+      while (true) {
+        if (depth > 0) {
+          auto &top = stack[depth - 1];
+          const auto remaining = static_cast<std::size_t>(top.end - top.position);
+          if (remaining == 0) {
+            --depth;
+            continue;
+          }
+
+          const uint32_t size = remaining >= 4 ? load_32(top.position) : 0;
+          if (size == 0 || size % 4 != 0 || size > remaining - 4) {
+            report(parse_event::MALFORMED_PACKET, remaining);
+            --depth;
+            continue;
+          }
+
+          const auto *element = top.position + 4;
+          top.position = element + size;
+          if (visit(element, size, top.time)) {
+            return;
+          }
+          continue;
+        }
+
+        if (!spa_pod_control_is_inside(&sequence->body,
+                                       SPA_POD_BODY_SIZE(sequence), control)) {
+          done = true;
+          return;
+        }
+
+        const auto *pod_control = control;
+        control = spa_pod_control_next(control);
+        offset = pod_control->offset;
+        if (pod_control->type != SPA_CONTROL_OSC) {
+          report(parse_event::NOT_AN_OSC_CONTROL, pod_control->value.size);
+          continue;
+        }
+
+        const void *data = nullptr;
+        uint32_t length(0);
+        if (spa_pod_get_bytes(&pod_control->value, &data, &length) < 0) {
+          report(parse_event::MALFORMED_PACKET, pod_control->value.size);
+          continue;
+        }
+
+        if (visit(static_cast<const uint8_t *>(data), length, immediately)) {
+          return;
+        }
+      }
+    }
+
+    /*! \brief Yield a message or open a bundle.
+     *
+     * \return True if a message is ready.
+     */
+    bool visit(const uint8_t *data, const uint32_t size, const uint64_t time) {
+      if (!is_osc_packet(data, size)) {
+        report(parse_event::MALFORMED_PACKET, size);
+        return false;
+      }
+
+      if (data[0] == '/') {
+        current = {offset, time, OSCPP::Server::Packet(data, size)};
+        if (diagnostics != nullptr) {
+          diagnostics->packet();
+        }
+        return true;
+      }
+
+      if (depth == MAX_DEPTH) {
+        report(parse_event::BUNDLE_TOO_DEEP, size);
+        return false;
+      }
+
+      const uint64_t bundle_time =
+          static_cast<uint64_t>(load_32(data + 8)) << 32 | load_32(data + 12);
+      stack[depth++] = {data + 16, data + size, bundle_time};
+      return false;
+    }
+
+    void report(const parse_event event, const std::size_t size) const {
+      if (diagnostics != nullptr) {
+        diagnostics->report(event, offset, static_cast<uint32_t>(size));
+      }
+    }
+
+    static uint32_t load_32(const uint8_t *data) {
+      return static_cast<uint32_t>(data[0]) << 24 |
+             static_cast<uint32_t>(data[1]) << 16 |
+             static_cast<uint32_t>(data[2]) << 8 | data[3];
+    }
+
+    const struct spa_pod_sequence *sequence = nullptr;
+    ParseDiagnostics *diagnostics = nullptr;
+    const struct spa_pod_control *control = nullptr;
+    uint32_t offset = 0;
+    std::array<bundle, MAX_DEPTH> stack{};
+    std::size_t depth = 0;
+    timed_packet current;
+    bool done = true;
+  };
+
+  PacketView() = default;
+
+  /*! \brief Construct a view of a sequence.
+   *
+   * \param sequence The sequence, may be null for an empty view.
+   * \param diagnostics Receives the parse events, may be null.
+   */
+  explicit PacketView(const struct spa_pod_sequence *sequence,
+                      ParseDiagnostics *diagnostics = nullptr)
+      : sequence(sequence), diagnostics(diagnostics) {}
+
+  [[nodiscard]] iterator begin() const {
+    return iterator(sequence, diagnostics);
+  }
+
+  [[nodiscard]] std::default_sentinel_t end() const { return {}; }
+
+private:
+  const struct spa_pod_sequence *sequence = nullptr;
+  ParseDiagnostics *diagnostics = nullptr;
+};
+
+static_assert(std::ranges::input_range<PacketView<>>);
+
+/*! \brief View the OSC messages of a buffer, see PacketView.
+ *
+ * \param buffer The buffer, it has to outlive the view.
+ * \param diagnostics Receives the parse events, may be null.
+ *
+ * \return The view, empty if the buffer holds no pod.
+ */
+template <std::size_t MAX_DEPTH = 8>
+std::expected<PacketView<MAX_DEPTH>, error>
+packets(Buffer &buffer, ParseDiagnostics *diagnostics = nullptr) {
+  auto pod = buffer.get_pod(0);
+  if (!pod.has_value()) {
+    if (diagnostics != nullptr) {
+      diagnostics->report(parse_event::POD_EMPTY);
+    }
+    return PacketView<MAX_DEPTH>();
+  }
+
+  if (!spa_pod_is_sequence(pod.value())) {
+    if (diagnostics != nullptr) {
+      diagnostics->report(parse_event::POD_NOT_A_SEQUENCE, 0,
+                          pod.value()->size);
+    }
+    return std::unexpected(error::midi_parsing_pod_not_a_sequence());
+  }
+
+  return PacketView<MAX_DEPTH>(
+      reinterpret_cast<const struct spa_pod_sequence *>(pod.value()),
+      diagnostics);
+}
+
+} // namespace pwcpp::osc
@@ -2,28 +2,192 @@
 
 #include "pwcpp/buffer.h"
 #include "pwcpp/error.h"
+#include "pwcpp/rt/spsc_queue.h"
 
 #include <oscpp/server.hpp>
 
 #include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <expected>
 #include <optional>
+#include <utility>
 
 namespace pwcpp::osc {
+
+/*! \brief Something unexpected found while parsing. */
+enum class parse_event : uint8_t {
+  /*! \brief The buffer holds no pod. */
+  POD_EMPTY,
+  /*! \brief The pod is not a sequence. */
+  POD_NOT_A_SEQUENCE,
+  /*! \brief A control of the sequence is not OSC and was skipped. */
+  NOT_AN_OSC_CONTROL,
+  /*! \brief An OSC control is not a valid packet and was skipped. */
+  MALFORMED_PACKET,
+  /*! \brief The sequence holds more packets than fit into the result. */
+  TOO_MANY_PACKETS,
+  /*! \brief A bundle is nested deeper than supported and was skipped. */
+  BUNDLE_TOO_DEEP,
+};
+
+/*! \brief A logged parse event. */
+struct parse_diagnostic {
+  parse_event event = parse_event::POD_EMPTY;
+  /*! \brief The sample offset of the control, 0 for events of the pod. */
+  uint32_t offset = 0;
+  /*! \brief The size of the control's body. */
+  uint32_t size = 0;
+};
+
+/*! \brief Totals of the parse events. */
+struct parse_counters {
+  std::size_t packets = 0;
+  std::size_t empty_pods = 0;
+  std::size_t invalid_pods = 0;
+  std::size_t skipped_controls = 0;
+  std::size_t malformed_packets = 0;
+  std::size_t dropped_packets = 0;
+  /*! \brief Events not logged because the log was full. */
+  std::size_t dropped_log_entries = 0;
+};
+
+/*! \brief Collects what happens while parsing OSC in the process callback.
+ *
+ * Every event increases a counter and, if logging is enabled, is queued in a
+ * lock-free log. The main loop reads the counters and drains the log, e.g.
+ * from a timer, and prints or forwards the entries. Reporting never blocks,
+ * allocates or performs I/O; events that don't fit into the log are only
+ * counted.
+ */
+class ParseDiagnostics {
+public:
+  /*! \brief The maximum number of log entries between two drains. */
+  static constexpr std::size_t log_capacity = 64;
+
+  /*! \brief Construct the diagnostics.
+   *
+   * \param log Queue every event in addition to counting it.
+   */
+  explicit ParseDiagnostics(const bool log = true) : log_enabled(log) {}
+
+  /*! \brief Count a parsed packet, called from the process callback. */
+  void packet() { increment(packets); }
+
+  /*! \brief Report an event, called from the process callback. */
+  void report(const parse_event event, const uint32_t offset = 0,
+              const uint32_t size = 0) {
+    switch (event) {
+    case parse_event::POD_EMPTY:
+      increment(empty_pods);
+      break;
+    case parse_event::POD_NOT_A_SEQUENCE:
+      increment(invalid_pods);
+      break;
+    case parse_event::NOT_AN_OSC_CONTROL:
+      increment(skipped_controls);
+      break;
+    case parse_event::MALFORMED_PACKET:
+      increment(malformed_packets);
+      break;
+    case parse_event::TOO_MANY_PACKETS:
+    case parse_event::BUNDLE_TOO_DEEP:
+      increment(dropped_packets);
+      break;
+    }
+
+    if (log_enabled && !log.try_push({event, offset, size})) {
+      increment(dropped_log_entries);
+    }
+  }
+
+  /*! \brief The totals since construction, read from any thread. */
+  [[nodiscard]] parse_counters counters() const {
+    return {packets.load(std::memory_order_relaxed),
+            empty_pods.load(std::memory_order_relaxed),
+            invalid_pods.load(std::memory_order_relaxed),
+            skipped_controls.load(std::memory_order_relaxed),
+            malformed_packets.load(std::memory_order_relaxed),
+            dropped_packets.load(std::memory_order_relaxed),
+            dropped_log_entries.load(std::memory_order_relaxed)};
+  }
+
+  /*! \brief Take the logged events, called from the main loop.
+   *
+   * \param f Called with every parse_diagnostic in the order of the events.
+   *
+   * \return The number of drained events.
+   */
+  template <typename F> std::size_t drain(F &&f) {
+    return log.drain(std::forward<F>(f));
+  }
+
+private:
+  static void increment(std::atomic<std::size_t> &counter) {
+    // Only the process callback writes, so no read-modify-write is needed.
+    counter.store(counter.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+  }
+
+  bool log_enabled;
+  std::atomic<std::size_t> packets = 0;
+  std::atomic<std::size_t> empty_pods = 0;
+  std::atomic<std::size_t> invalid_pods = 0;
+  std::atomic<std::size_t> skipped_controls = 0;
+  std::atomic<std::size_t> malformed_packets = 0;
+  std::atomic<std::size_t> dropped_packets = 0;
+  std::atomic<std::size_t> dropped_log_entries = 0;
+  rt::SpscQueue<parse_diagnostic, log_capacity> log;
+};
+
+/*! \brief Check the framing of an OSC packet without parsing it.
+ *
+ * A packet is a multiple of 4 bytes long and starts with an address or the
+ * `#bundle` tag.
+ */
+inline bool is_osc_packet(const uint8_t *data, const uint32_t size) {
+  if (data == nullptr || size < 4 || size % 4 != 0) {
+    return false;
+  }
+
+  if (data[0] == '/') {
+    return true;
+  }
+
+  return size >= 16 && std::memcmp(data, "#bundle", 8) == 0;
+}
+
+/*! \brief Parse the OSC packets of a buffer.
+ *
+ * Parsing is silent and bounded by the size of the sequence: controls that
+ * are not OSC or not valid packets are skipped and, like all other
+ * unexpected input, reported to the diagnostics.
+ *
+ * \param buffer The buffer to parse.
+ * \param diagnostics Receives the parse events, may be null.
+ */
 template <std::size_t MAX_N>
 std::expected<std::array<std::optional<OSCPP::Server::Packet>, MAX_N>, error>
-parse_osc(Buffer &buffer) {
+parse_osc(Buffer &buffer, ParseDiagnostics *diagnostics = nullptr) {
+  auto report = [diagnostics](const parse_event event, const uint32_t offset,
+                              const uint32_t size) {
+    if (diagnostics != nullptr) {
+      diagnostics->report(event, offset, size);
+    }
+  };
+
   auto pod = buffer.get_pod(0);
 
   if (!pod.has_value()) {
-    std::cout << "pod is empty" << std::endl;
+    report(parse_event::POD_EMPTY, 0, 0);
     return std::expected<std::array<std::optional<OSCPP::Server::Packet>, MAX_N>
                          , error>();
   }
 
   if (!spa_pod_is_sequence(pod.value())) {
-    std::cout << "pod is not a sequence" << std::endl;
+    report(parse_event::POD_NOT_A_SEQUENCE, 0, pod.value()->size);
     return std::unexpected(error::midi_parsing_pod_not_a_sequence());
   }
 
@@ -33,22 +197,32 @@ parse_osc(Buffer &buffer) {
   struct spa_pod_control *pod_control;
   size_t index(0);
   SPA_POD_SEQUENCE_FOREACH(sequence, pod_control) {
-    std::cout << "index: " << index << std::endl;
     if (index >= MAX_N) {
-      std::cout << "too many messages" << std::endl;
+      report(parse_event::TOO_MANY_PACKETS, pod_control->offset,
+             pod_control->value.size);
       return std::unexpected(error::midi_parsing_too_many_messages());
     }
 
     if (pod_control->type != SPA_CONTROL_OSC) {
-      std::cout << "not an osc message" << std::endl;
+      report(parse_event::NOT_AN_OSC_CONTROL, pod_control->offset,
+             pod_control->value.size);
       continue;
     }
 
     uint8_t *data = nullptr;
-    uint32_t length;
-    spa_pod_get_bytes(&pod_control->value, (const void**)&data, &length);
-    std::cout << "data: " << data << " length: " << length << std::endl;
-    result_messages[index] = OSCPP::Server::Packet(data, length);
+    uint32_t length(0);
+    if (spa_pod_get_bytes(&pod_control->value, (const void**)&data, &length) <
+            0 ||
+        !is_osc_packet(data, length)) {
+      report(parse_event::MALFORMED_PACKET, pod_control->offset,
+             pod_control->value.size);
+      continue;
+    }
+
+    if (diagnostics != nullptr) {
+      diagnostics->packet();
+    }
+    result_messages[index++] = OSCPP::Server::Packet(data, length);
   }
 
   return result_messages;
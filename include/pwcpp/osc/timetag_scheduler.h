@@ -0,0 +1,276 @@
+#pragma once
+
+#include "pwcpp/osc/packet_view.h"
+
+#include <oscpp/server.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#include <spa/node/io.h>
+
+namespace pwcpp::osc {
+
+/*! \brief Seconds between the NTP epoch (1900) and the unix epoch (1970). */
+inline constexpr uint64_t ntp_unix_offset = 2208988800ull;
+
+/*! \brief Convert an OSC timetag to nanoseconds since the unix epoch. */
+constexpr int64_t ntp_to_unix_nsec(const uint64_t timetag) {
+  const auto seconds = static_cast<int64_t>(timetag >> 32) -
+                       static_cast<int64_t>(ntp_unix_offset);
+  const auto fraction =
+      ((timetag & 0xffffffffull) * 1000000000ull + 0x80000000ull) >> 32;
+  return seconds * 1000000000ll + static_cast<int64_t>(fraction);
+}
+
+/*! \brief Convert nanoseconds since the unix epoch to an OSC timetag. */
+constexpr uint64_t unix_nsec_to_ntp(const int64_t nsec) {
+  const auto seconds =
+      static_cast<uint64_t>(nsec / 1000000000ll) + ntp_unix_offset;
+  const auto remainder = static_cast<uint64_t>(nsec % 1000000000ll);
+  return (seconds << 32) + (((remainder << 32) + 500000000ull) / 1000000000ull);
+}
+
+/*! \brief Counters of the timetag scheduler. */
+struct scheduler_counters {
+  /*! \brief Messages queued. */
+  std::size_t scheduled = 0;
+  /*! \brief Messages released in a cycle. */
+  std::size_t released = 0;
+  /*! \brief Messages whose time had passed, released at offset 0. */
+  std::size_t late = 0;
+  /*! \brief Messages that arrived before the cycle of their time and were
+   * held back. */
+  std::size_t early = 0;
+  /*! \brief Messages dropped because the queue was full or they were larger
+   * than a slot. */
+  std::size_t dropped = 0;
+};
+
+/*! \brief Releases OSC messages at the sample offset of their bundle's
+ * timetag.
+ *
+ * Every cycle, TimetagScheduler::update takes the cycle's time window from
+ * `spa_io_position::clock`, TimetagScheduler::schedule queues the messages
+ * of the input ports and TimetagScheduler::release hands out the messages
+ * that are due in the cycle, each at the sample offset of its timetag.
+ * Messages without a timetag are released at the offset they arrived at.
+ *
+ * Timetags are NTP wall clock times while the graph runs on the monotonic
+ * clock. The main loop measures the difference with
+ * TimetagScheduler::measure_clock_offset and stores it with
+ * TimetagScheduler::set_clock_offset, e.g. from a timer.
+ *
+ * Messages are copied into preallocated slots and ordered in a fixed-size
+ * min-heap, so nothing is allocated in the process callback.
+ *
+ * \tparam CAPACITY The maximum number of queued messages.
+ * \tparam MAX_PACKET_SIZE The maximum size of a message in bytes.
+ */
+template <std::size_t CAPACITY = 128, std::size_t MAX_PACKET_SIZE = 256>
+class TimetagScheduler {
+public:
+  static_assert(CAPACITY > 0 && CAPACITY <= 0xffff);
+  static_assert(MAX_PACKET_SIZE % 8 == 0 && MAX_PACKET_SIZE <= 0xffff,
+                "Slots have to keep the alignment of OSC packets.");
+
+  TimetagScheduler() {
+    for (std::size_t i = 0; i < CAPACITY; ++i) {
+      free_slots[i] = static_cast<uint16_t>(CAPACITY - 1 - i);
+    }
+  }
+
+  /*! \brief The realtime clock minus the monotonic clock in nanoseconds.
+   * Called from the main loop. */
+  static int64_t measure_clock_offset() {
+    timespec realtime{};
+    timespec monotonic{};
+    clock_gettime(CLOCK_MONOTONIC, &monotonic);
+    clock_gettime(CLOCK_REALTIME, &realtime);
+    return (static_cast<int64_t>(realtime.tv_sec) -
+            static_cast<int64_t>(monotonic.tv_sec)) *
+               1000000000ll +
+           (realtime.tv_nsec - monotonic.tv_nsec);
+  }
+
+  /*! \brief Set the offset used to convert timetags to graph time, see
+   * TimetagScheduler::measure_clock_offset. */
+  void set_clock_offset(const int64_t realtime_minus_monotonic) {
+    clock_offset.store(realtime_minus_monotonic, std::memory_order_relaxed);
+  }
+
+  /*! \brief Start a cycle, called at the start of the process callback.
+   *
+   * \param position The position passed to the process callback. Without a
+   * position nothing is scheduled or released in the cycle.
+   */
+  void update(const spa_io_position *position) {
+    valid = false;
+    if (position == nullptr || position->clock.duration == 0) {
+      return;
+    }
+
+    const auto &clock = position->clock;
+    cycle_start = static_cast<int64_t>(clock.nsec);
+    samples = clock.duration;
+    if (clock.next_nsec > clock.nsec) {
+      cycle_length = static_cast<int64_t>(clock.next_nsec - clock.nsec);
+    } else if (clock.rate.denom != 0) {
+      cycle_length = static_cast<int64_t>(clock.duration * 1000000000ull *
+                                          clock.rate.num / clock.rate.denom);
+    } else {
+      return;
+    }
+    valid = cycle_length > 0;
+  }
+
+  /*! \brief Queue a message of the current cycle.
+   *
+   * \return False if the message was dropped.
+   */
+  bool schedule(const timed_packet &packet) {
+    if (!valid) {
+      return false;
+    }
+
+    int64_t due;
+    if (packet.time == immediately) {
+      due = cycle_start + static_cast<int64_t>(packet.offset) * cycle_length /
+                              static_cast<int64_t>(samples);
+    } else {
+      due = ntp_to_unix_nsec(packet.time) -
+            clock_offset.load(std::memory_order_relaxed);
+    }
+
+    const auto size = packet.packet.size();
+    if (size > MAX_PACKET_SIZE || free_count == 0) {
+      counters.dropped++;
+      return false;
+    }
+
+    const auto slot = free_slots[--free_count];
+    std::memcpy(storage[slot].data(), packet.packet.data(), size);
+    push({due, next_sequence++, slot, static_cast<uint16_t>(size)});
+    counters.scheduled++;
+    if (due >= cycle_start + cycle_length) {
+      counters.early++;
+    }
+    return true;
+  }
+
+  /*! \brief Release the messages due in the current cycle.
+   *
+   * \param f Called with the sample offset and the message in time order.
+   * The packet points into the scheduler and is only valid during the call.
+   */
+  template <typename F> void release(F &&f) {
+    if (!valid) {
+      return;
+    }
+
+    const int64_t cycle_end = cycle_start + cycle_length;
+    while (heap_size > 0 && heap[0].due < cycle_end) {
+      const auto entry = pop();
+      uint32_t offset(0);
+      if (entry.due < cycle_start) {
+        counters.late++;
+      } else {
+        // Round to the nearest sample, the last sample takes the rest.
+        const auto sample = ((entry.due - cycle_start) *
+                                 static_cast<int64_t>(samples) +
+                             cycle_length / 2) /
+                            cycle_length;
+        offset = static_cast<uint32_t>(
+            std::min(sample, static_cast<int64_t>(samples) - 1));
+      }
+
+      counters.released++;
+      f(offset, OSCPP::Server::Packet(storage[entry.slot].data(), entry.size));
+      free_slots[free_count++] = entry.slot;
+    }
+  }
+
+  /*! \brief Drop all queued messages. */
+  void clear() {
+    while (heap_size > 0) {
+      free_slots[free_count++] = pop().slot;
+    }
+  }
+
+  /*! \brief The number of queued messages. */
+  [[nodiscard]] std::size_t size() const { return heap_size; }
+
+  /*! \brief The totals since construction. */
+  [[nodiscard]] const scheduler_counters &statistics() const {
+    return counters;
+  }
+
+private:
+  struct entry {
+    int64_t due;
+    uint64_t sequence;
+    uint16_t slot;
+    uint16_t size;
+  };
+
+  static bool before(const entry &a, const entry &b) {
+    return a.due < b.due || (a.due == b.due && a.sequence < b.sequence);
+  }
+
+  void push(const entry &e) {
+    auto i = heap_size++;
+    while (i > 0) {
+      const auto parent = (i - 1) / 2;
+      if (!before(e, heap[parent])) {
+        break;
+      }
+      heap[i] = heap[parent];
+      i = parent;
+    }
+    heap[i] = e;
+  }
+
+  entry pop() {
+    const auto top = heap[0];
+    const auto last = heap[--heap_size];
+    std::size_t i = 0;
+    while (true) {
+      auto child = 2 * i + 1;
+      if (child >= heap_size) {
+        break;
+      }
+      if (child + 1 < heap_size && before(heap[child + 1], heap[child])) {
+        ++child;
+      }
+      if (!before(heap[child], last)) {
+        break;
+      }
+      heap[i] = heap[child];
+      i = child;
+    }
+    heap[i] = last;
+    return top;
+  }
+
+  std::atomic<int64_t> clock_offset = 0;
+  bool valid = false;
+  int64_t cycle_start = 0;
+  int64_t cycle_length = 0;
+  uint64_t samples = 0;
+  uint64_t next_sequence = 0;
+  scheduler_counters counters;
+
+  std::array<entry, CAPACITY> heap{};
+  std::size_t heap_size = 0;
+  std::array<uint16_t, CAPACITY> free_slots{};
+  std::size_t free_count = CAPACITY;
+  alignas(8) std::array<std::array<uint8_t, MAX_PACKET_SIZE>, CAPACITY>
+      storage{};
+};
+
+} // namespace pwcpp::osc
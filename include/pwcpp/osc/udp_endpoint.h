@@ -0,0 +1,498 @@
+#pragma once
+
+#include "pwcpp/error.h"
+#include "pwcpp/osc/parse_osc.h"
+#include "pwcpp/osc/write_osc.h"
+#include "pwcpp/rt/spsc_queue.h"
+
+#include <oscpp/client.hpp>
+#include <oscpp/error.hpp>
+#include <oscpp/server.hpp>
+#include <oscpp/util.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <stdexcept>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <pipewire/loop.h>
+#include <spa/utils/defs.h>
+
+namespace pwcpp::osc {
+
+/*! \brief Totals of a UdpEndpoint. */
+struct udp_counters {
+  /*! \brief Datagrams received and queued for the process callback. */
+  std::size_t received = 0;
+  /*! \brief Datagrams sent. */
+  std::size_t sent = 0;
+  /*! \brief Datagrams dropped because they were truncated or not OSC. */
+  std::size_t malformed = 0;
+  /*! \brief Datagrams dropped because the process callback didn't return
+   * the receive buffers in time. */
+  std::size_t receive_overruns = 0;
+  /*! \brief Packets the process callback could not queue, because all send
+   * buffers were in use or the packet was too large. */
+  std::size_t send_overruns = 0;
+  /*! \brief Queued packets that could not be sent, e.g. without a
+   * destination. */
+  std::size_t send_errors = 0;
+};
+
+/*! \brief Receives and sends OSC packets over UDP for the process callback.
+ *
+ * The socket is served by the main loop: UdpEndpoint::attach registers it
+ * with `pw_loop_add_io`, e.g. on `pw_main_loop_get_loop(app->loop)`. Every
+ * wakeup reads all pending datagrams with `recvmmsg` in batches, straight
+ * into a preallocated pool of packet buffers, and queues the buffers for the
+ * process callback on a lock-free queue. The process callback visits them
+ * with UdpEndpoint::for_each_packet, which hands each buffer back on a
+ * second queue.
+ *
+ * Output takes the reverse path: the process callback builds packets into
+ * buffers of a second pool with UdpEndpoint::send_message or
+ * UdpEndpoint::send and signals the main loop, which sends them with
+ * `sendmmsg` from UdpEndpoint::flush. Neither side blocks, allocates or
+ * performs I/O on the other's behalf, a full pool drops datagrams and counts
+ * them.
+ *
+ * Without a loop, UdpEndpoint::receive and UdpEndpoint::flush can be called
+ * directly, e.g. from a timer or a test.
+ *
+ * \tparam PACKETS The number of buffers of each direction, a power of two.
+ * \tparam MAX_PACKET_SIZE The maximum size of a datagram in bytes.
+ */
+template <std::size_t PACKETS = 64, std::size_t MAX_PACKET_SIZE = 1536>
+class UdpEndpoint {
+public:
+  static_assert(PACKETS > 0 && PACKETS <= 0x8000 &&
+                    (PACKETS & (PACKETS - 1)) == 0,
+                "The number of packets has to be a power of two.");
+  static_assert(MAX_PACKET_SIZE % 8 == 0,
+                "Buffers have to keep the alignment of OSC packets.");
+
+  /*! \brief The maximum number of datagrams per system call. */
+  static constexpr std::size_t batch_size = std::min<std::size_t>(PACKETS, 16);
+
+  UdpEndpoint() {
+    for (std::size_t i = 0; i < PACKETS; ++i) {
+      receive_free[i] = static_cast<uint16_t>(i);
+      send_free[i] = static_cast<uint16_t>(i);
+    }
+  }
+
+  UdpEndpoint(const UdpEndpoint &) = delete;
+  UdpEndpoint &operator=(const UdpEndpoint &) = delete;
+
+  ~UdpEndpoint() {
+    detach();
+    if (socket_fd >= 0) {
+      close(socket_fd);
+    }
+  }
+
+  /*! \brief Open the socket and bind it to a local IPv4 address.
+   *
+   * \param address The address, e.g. "127.0.0.1" or "0.0.0.0".
+   * \param port The port, 0 to let the system choose, see
+   * UdpEndpoint::local_port.
+   */
+  std::expected<void, error> bind(const char *address, const uint16_t port) {
+    auto socket_address = make_address(address, port);
+    if (!socket_address.has_value()) {
+      return std::unexpected(socket_address.error());
+    }
+
+    if (socket_fd < 0) {
+      socket_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if (socket_fd < 0) {
+        return std::unexpected(error::osc_socket("socket", errno));
+      }
+    }
+
+    if (::bind(socket_fd,
+               reinterpret_cast<const sockaddr *>(&socket_address.value()),
+               sizeof(sockaddr_in)) < 0) {
+      return std::unexpected(error::osc_socket("bind", errno));
+    }
+    return {};
+  }
+
+  /*! \brief Set the IPv4 address that UdpEndpoint::flush sends to. */
+  std::expected<void, error> set_destination(const char *address,
+                                             const uint16_t port) {
+    auto socket_address = make_address(address, port);
+    if (!socket_address.has_value()) {
+      return std::unexpected(socket_address.error());
+    }
+    destination = socket_address.value();
+    has_destination = true;
+    return {};
+  }
+
+  /*! \brief The port the socket is bound to, 0 if it isn't. */
+  [[nodiscard]] uint16_t local_port() const {
+    sockaddr_in socket_address{};
+    socklen_t length = sizeof(socket_address);
+    if (socket_fd < 0 ||
+        getsockname(socket_fd, reinterpret_cast<sockaddr *>(&socket_address),
+                    &length) < 0) {
+      return 0;
+    }
+    return ntohs(socket_address.sin_port);
+  }
+
+  /*! \brief The file descriptor of the socket, -1 before UdpEndpoint::bind. */
+  [[nodiscard]] int fd() const { return socket_fd; }
+
+  /*! \brief Serve the socket from a loop, called from the main loop after
+   * UdpEndpoint::bind.
+   *
+   * Incoming datagrams are read when the socket becomes readable, queued
+   * output is sent when the process callback signals it.
+   */
+  void attach(struct pw_loop *main_loop) {
+    detach();
+    loop = main_loop;
+    io_source = pw_loop_add_io(
+        loop, socket_fd, SPA_IO_IN, false,
+        [](void *data, int, uint32_t) {
+          static_cast<UdpEndpoint *>(data)->receive();
+        },
+        this);
+    event_source = pw_loop_add_event(
+        loop,
+        [](void *data, uint64_t) { static_cast<UdpEndpoint *>(data)->flush(); },
+        this);
+    event_source_ready.store(event_source != nullptr,
+                             std::memory_order_release);
+  }
+
+  /*! \brief Remove the sources added by UdpEndpoint::attach, called from
+   * the main loop while the filter is not processing. */
+  void detach() {
+    if (loop == nullptr) {
+      return;
+    }
+    event_source_ready.store(false, std::memory_order_release);
+    if (io_source != nullptr) {
+      pw_loop_destroy_source(loop, io_source);
+    }
+    if (event_source != nullptr) {
+      pw_loop_destroy_source(loop, event_source);
+    }
+    io_source = nullptr;
+    event_source = nullptr;
+    loop = nullptr;
+  }
+
+  /*! \brief Read all pending datagrams, called from the main loop.
+   *
+   * \return The number of datagrams queued for the process callback.
+   */
+  std::size_t receive() {
+    if (socket_fd < 0) {
+      return 0;
+    }
+
+    receive_returned.drain(
+        [this](const uint16_t slot) { receive_free[receive_free_count++] = slot; });
+
+    std::size_t queued(0);
+    while (true) {
+      if (receive_free_count == 0) {
+        // Discard a datagram, a level-triggered source would spin otherwise.
+        std::array<uint8_t, 1> discard{};
+        if (recv(socket_fd, discard.data(), discard.size(), MSG_DONTWAIT) < 0) {
+          break;
+        }
+        increment(receive_overruns);
+        continue;
+      }
+
+      const auto count = std::min(batch_size, receive_free_count);
+      for (std::size_t i = 0; i < count; ++i) {
+        const auto slot = receive_free[receive_free_count - 1 - i];
+        vectors[i] = {receive_pool[slot].data.data(), MAX_PACKET_SIZE};
+        headers[i] = {};
+        headers[i].msg_hdr.msg_iov = &vectors[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+      }
+
+      const int result = recvmmsg(socket_fd, headers.data(),
+                                  static_cast<unsigned int>(count),
+                                  MSG_DONTWAIT, nullptr);
+      if (result <= 0) {
+        break;
+      }
+
+      // Entry i was read into the buffer of free slot `top - 1 - i`, the
+      // buffers of malformed datagrams are only returned after the batch.
+      const auto top = receive_free_count;
+      std::array<uint16_t, batch_size> rejected{};
+      std::size_t rejected_count(0);
+      for (int i = 0; i < result; ++i) {
+        const auto slot = receive_free[top - 1 - static_cast<std::size_t>(i)];
+        auto &packet = receive_pool[slot];
+        packet.size = headers[i].msg_len;
+        if ((headers[i].msg_hdr.msg_flags & MSG_TRUNC) != 0 ||
+            !is_osc_packet(packet.data.data(), packet.size)) {
+          increment(malformed);
+          rejected[rejected_count++] = slot;
+          continue;
+        }
+        // The queue holds every buffer of the pool, so this can't fail.
+        receive_ready.try_push(slot);
+        increment(received);
+        ++queued;
+      }
+      receive_free_count = top - static_cast<std::size_t>(result);
+      for (std::size_t i = 0; i < rejected_count; ++i) {
+        receive_free[receive_free_count++] = rejected[i];
+      }
+
+      if (static_cast<std::size_t>(result) < count) {
+        break;
+      }
+    }
+    return queued;
+  }
+
+  /*! \brief Visit the received packets, called from the process callback.
+   *
+   * \param f Called with every `OSCPP::Server::Packet` in arrival order. The
+   * packet is only valid during the call.
+   *
+   * \return The number of visited packets.
+   */
+  template <typename F> std::size_t for_each_packet(F &&f) {
+    return receive_ready.drain([this, &f](const uint16_t slot) {
+      const auto &packet = receive_pool[slot];
+      f(OSCPP::Server::Packet(packet.data.data(), packet.size));
+      receive_returned.try_push(slot);
+    });
+  }
+
+  /*! \brief Queue a message with the given arguments, called from the
+   * process callback.
+   *
+   * \param address The address of the message.
+   * \param arguments Arguments of type `int32_t`, `float`, `const char *` or
+   * `OSCPP::Blob`.
+   */
+  template <typename... Args>
+  std::expected<void, error> send_message(const char *address,
+                                          const Args &...arguments) {
+    const std::size_t size =
+        OSCPP::Size::message(address, sizeof...(Args)) +
+        (std::size_t(0) + ... + detail::argument_size(arguments));
+    if (size > MAX_PACKET_SIZE) {
+      increment(send_overruns);
+      return std::unexpected(error::sequence_writing_buffer_overflow());
+    }
+
+    return send([&](OSCPP::Client::Packet &packet) {
+      packet.openMessage(address, sizeof...(Args));
+      (detail::put_argument(packet, arguments), ...);
+      packet.closeMessage();
+    });
+  }
+
+  /*! \brief Build a packet in place and queue it, called from the process
+   * callback.
+   *
+   * \param build Called with an `OSCPP::Client::Packet` over a free buffer.
+   * If it runs out of space the oscpp exception is caught and reported as an
+   * overflow.
+   */
+  template <typename F> std::expected<void, error> send(F &&build) {
+    auto slot = acquire_send_buffer();
+    if (!slot.has_value()) {
+      return std::unexpected(slot.error());
+    }
+
+    auto &buffer = send_pool[slot.value()];
+    OSCPP::Client::Packet packet(buffer.data.data(), MAX_PACKET_SIZE);
+    try {
+      build(packet);
+    } catch (const OSCPP::Error &) {
+      increment(send_overruns);
+      return std::unexpected(error::sequence_writing_buffer_overflow());
+    } catch (const std::logic_error &) {
+      return std::unexpected(error::configuration());
+    }
+
+    if (packet.size() == 0) {
+      return {};
+    }
+    queue_send_buffer(slot.value(), packet.size());
+    return {};
+  }
+
+  /*! \brief Queue an encoded packet, called from the process callback. */
+  std::expected<void, error> send_packet(const void *data,
+                                         const std::size_t size) {
+    if (size > MAX_PACKET_SIZE) {
+      increment(send_overruns);
+      return std::unexpected(error::sequence_writing_buffer_overflow());
+    }
+
+    auto slot = acquire_send_buffer();
+    if (!slot.has_value()) {
+      return std::unexpected(slot.error());
+    }
+    std::memcpy(send_pool[slot.value()].data.data(), data, size);
+    queue_send_buffer(slot.value(), size);
+    return {};
+  }
+
+  /*! \brief Send the queued packets, called from the main loop.
+   *
+   * \return The number of sent datagrams.
+   */
+  std::size_t flush() {
+    std::size_t sent_count(0);
+    std::array<uint16_t, batch_size> slots{};
+    while (true) {
+      std::size_t count(0);
+      while (count < batch_size) {
+        const auto slot = send_ready.try_pop();
+        if (!slot.has_value()) {
+          break;
+        }
+        slots[count++] = slot.value();
+      }
+      if (count == 0) {
+        break;
+      }
+
+      int result = -1;
+      if (socket_fd >= 0 && has_destination) {
+        for (std::size_t i = 0; i < count; ++i) {
+          auto &packet = send_pool[slots[i]];
+          vectors[i] = {packet.data.data(), packet.size};
+          headers[i] = {};
+          headers[i].msg_hdr.msg_name = &destination;
+          headers[i].msg_hdr.msg_namelen = sizeof(destination);
+          headers[i].msg_hdr.msg_iov = &vectors[i];
+          headers[i].msg_hdr.msg_iovlen = 1;
+        }
+        result = sendmmsg(socket_fd, headers.data(),
+                          static_cast<unsigned int>(count), MSG_DONTWAIT);
+      }
+
+      const auto sent_now =
+          static_cast<std::size_t>(std::max(result, 0));
+      for (std::size_t i = 0; i < count; ++i) {
+        increment(i < sent_now ? sent : send_errors);
+        send_returned.try_push(slots[i]);
+      }
+      sent_count += sent_now;
+    }
+    return sent_count;
+  }
+
+  /*! \brief The totals since construction, read from any thread. */
+  [[nodiscard]] udp_counters statistics() const {
+    return {received.load(std::memory_order_relaxed),
+            sent.load(std::memory_order_relaxed),
+            malformed.load(std::memory_order_relaxed),
+            receive_overruns.load(std::memory_order_relaxed),
+            send_overruns.load(std::memory_order_relaxed),
+            send_errors.load(std::memory_order_relaxed)};
+  }
+
+private:
+  struct packet_buffer {
+    alignas(8) std::array<uint8_t, MAX_PACKET_SIZE> data{};
+    uint32_t size = 0;
+  };
+
+  /*! \brief Take a free send buffer without removing it from the free
+   * list, see UdpEndpoint::queue_send_buffer. */
+  std::expected<uint16_t, error> acquire_send_buffer() {
+    send_returned.drain(
+        [this](const uint16_t slot) { send_free[send_free_count++] = slot; });
+    if (send_free_count == 0) {
+      increment(send_overruns);
+      return std::unexpected(error::osc_send_queue_full());
+    }
+    return send_free[send_free_count - 1];
+  }
+
+  /*! \brief Hand the buffer of UdpEndpoint::acquire_send_buffer to the main
+   * loop. */
+  void queue_send_buffer(const uint16_t slot, const std::size_t size) {
+    send_pool[slot].size = static_cast<uint32_t>(size);
+    --send_free_count;
+    // The queue holds every buffer of the pool, so this can't fail.
+    send_ready.try_push(slot);
+    if (event_source_ready.load(std::memory_order_acquire)) {
+      pw_loop_signal_event(loop, event_source);
+    }
+  }
+
+  static std::expected<sockaddr_in, error> make_address(const char *address,
+                                                        const uint16_t port) {
+    sockaddr_in socket_address{};
+    socket_address.sin_family = AF_INET;
+    socket_address.sin_port = htons(port);
+    if (inet_pton(AF_INET, address, &socket_address.sin_addr) != 1) {
+      return std::unexpected(error::osc_socket("address parsing", EINVAL));
+    }
+    return socket_address;
+  }
+
+  static void increment(std::atomic<std::size_t> &counter) {
+    // Every counter has a single writer, so no read-modify-write is needed.
+    counter.store(counter.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+  }
+
+  int socket_fd = -1;
+  sockaddr_in destination{};
+  bool has_destination = false;
+
+  struct pw_loop *loop = nullptr;
+  struct spa_source *io_source = nullptr;
+  struct spa_source *event_source = nullptr;
+  std::atomic<bool> event_source_ready = false;
+
+  std::atomic<std::size_t> received = 0;
+  std::atomic<std::size_t> sent = 0;
+  std::atomic<std::size_t> malformed = 0;
+  std::atomic<std::size_t> receive_overruns = 0;
+  std::atomic<std::size_t> send_overruns = 0;
+  std::atomic<std::size_t> send_errors = 0;
+
+  // Main loop side of the system calls.
+  std::array<mmsghdr, batch_size> headers{};
+  std::array<iovec, batch_size> vectors{};
+
+  // Receive buffers, owned by the main loop while in receive_free.
+  std::array<packet_buffer, PACKETS> receive_pool{};
+  std::array<uint16_t, PACKETS> receive_free{};
+  std::size_t receive_free_count = PACKETS;
+  rt::SpscQueue<uint16_t, PACKETS> receive_ready;
+  rt::SpscQueue<uint16_t, PACKETS> receive_returned;
+
+  // Send buffers, owned by the process callback while in send_free.
+  std::array<packet_buffer, PACKETS> send_pool{};
+  std::array<uint16_t, PACKETS> send_free{};
+  std::size_t send_free_count = PACKETS;
+  rt::SpscQueue<uint16_t, PACKETS> send_ready;
+  rt::SpscQueue<uint16_t, PACKETS> send_returned;
+};
+
+} // namespace pwcpp::osc
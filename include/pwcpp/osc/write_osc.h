@@ -1,9 +1,215 @@
 #pragma once
 
 #include "pwcpp/buffer.h"
+#include "pwcpp/error.h"
+#include "pwcpp/osc/packet_view.h"
+#include "pwcpp/spa/pod/sequence_writer.h"
+
+#include <oscpp/client.hpp>
+#include <oscpp/error.hpp>
+#include <oscpp/types.hpp>
+#include <oscpp/util.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <ranges>
+#include <stdexcept>
+#include <type_traits>
+
+#include <spa/control/control.h>
 
 namespace pwcpp::osc {
 
-void write_osc(std::ranges::range auto &&buffers) {}
+namespace detail {
+/*! \brief The encoded size of a message argument. */
+template <typename T> std::size_t argument_size(const T &argument) {
+  if constexpr (std::is_same_v<T, int32_t>) {
+    return OSCPP::Size::int32();
+  } else if constexpr (std::is_same_v<T, float>) {
+    return OSCPP::Size::float32();
+  } else if constexpr (std::is_convertible_v<T, const char *>) {
+    return OSCPP::Size::string(std::strlen(argument));
+  } else if constexpr (std::is_same_v<T, OSCPP::Blob>) {
+    return OSCPP::Size::blob(argument.size());
+  } else {
+    static_assert(!sizeof(T), "Unsupported OSC argument type.");
+    return 0;
+  }
+}
+
+/*! \brief Put a message argument into a packet. */
+template <typename T>
+void put_argument(OSCPP::Client::Packet &packet, const T &argument) {
+  if constexpr (std::is_convertible_v<T, const char *>) {
+    packet.string(argument);
+  } else {
+    packet.put<T>(argument);
+  }
+}
+} // namespace detail
+
+/*! \brief Writes OSC packets into the buffer of an output port.
+ *
+ * Packets are built directly in the mapped memory of the buffer as
+ * `SPA_CONTROL_OSC` controls, without an intermediate packet buffer.
+ * Offsets have to be ascending, a packet that does not fit into the buffer
+ * is reported as an overflow and not written.
+ */
+class OscWriter {
+public:
+  /*! \brief Construct a writer for the given spa data.
+   *
+   * \param data The spa data of the output buffer.
+   */
+  explicit OscWriter(const struct spa_data &data) : sequence_writer(data) {}
+
+  /*! \brief Write a message with the given arguments.
+   *
+   * The size of the message is computed up front, so a message that doesn't
+   * fit is rejected without building it.
+   *
+   * \param offset The sample offset of the message.
+   * \param address The address of the message.
+   * \param arguments Arguments of type `int32_t`, `float`, `const char *` or
+   * `OSCPP::Blob`.
+   */
+  template <typename... Args>
+  std::expected<void, error> write_message(const uint32_t offset,
+                                           const char *address,
+                                           const Args &...arguments) {
+    const std::size_t size =
+        OSCPP::Size::message(address, sizeof...(Args)) +
+        (std::size_t(0) + ... + detail::argument_size(arguments));
+    const auto space = sequence_writer.reserve();
+    if (size > space.size()) {
+      return std::unexpected(error::sequence_writing_buffer_overflow());
+    }
+
+    OSCPP::Client::Packet packet(space.data(), space.size());
+    packet.openMessage(address, sizeof...(Args));
+    (detail::put_argument(packet, arguments), ...);
+    packet.closeMessage();
+    return sequence_writer.commit(offset, SPA_CONTROL_OSC,
+                                  static_cast<uint32_t>(packet.size()));
+  }
+
+  /*! \brief Build a packet in place, e.g. a bundle.
+   *
+   * \param offset The sample offset of the packet.
+   * \param build Called with an `OSCPP::Client::Packet` over the free space
+   * of the buffer. If it runs out of space the oscpp exception is caught and
+   * reported as an overflow, use OscWriter::fits with the `OSCPP::Size`
+   * helpers to check up front.
+   */
+  template <typename F>
+  std::expected<void, error> write(const uint32_t offset, F &&build) {
+    const auto space = sequence_writer.reserve();
+    if (space.empty()) {
+      return std::unexpected(error::sequence_writing_buffer_overflow());
+    }
+
+    OSCPP::Client::Packet packet(space.data(), space.size());
+    try {
+      build(packet);
+    } catch (const OSCPP::Error &) {
+      return std::unexpected(error::sequence_writing_buffer_overflow());
+    } catch (const std::logic_error &) {
+      return std::unexpected(error::configuration());
+    }
+
+    if (packet.size() == 0) {
+      return {};
+    }
+    return sequence_writer.commit(offset, SPA_CONTROL_OSC,
+                                  static_cast<uint32_t>(packet.size()));
+  }
+
+  /*! \brief Write an encoded packet, e.g. one received on an input port. */
+  std::expected<void, error> write_packet(const uint32_t offset,
+                                          const void *data,
+                                          const std::size_t size) {
+    return sequence_writer.write(offset, SPA_CONTROL_OSC, data,
+                                 static_cast<uint32_t>(size));
+  }
+
+  /*! \brief Write an encoded message with a timetag, wrapped in a bundle
+   * of its own unless the timetag is osc::immediately.
+   */
+  std::expected<void, error> write_packet(const uint32_t offset,
+                                          const uint64_t time,
+                                          const void *data,
+                                          const std::size_t size) {
+    if (time == immediately) {
+      return write_packet(offset, data, size);
+    }
+
+    const auto space = sequence_writer.reserve();
+    if (OSCPP::Size::bundle(1) + size > space.size()) {
+      return std::unexpected(error::sequence_writing_buffer_overflow());
+    }
+
+    OSCPP::Client::Packet packet(space.data(), space.size());
+    packet.openBundle(time).closeBundle();
+    const uint32_t element_size =
+        OSCPP::convert32<OSCPP::NetworkByteOrder>(static_cast<uint32_t>(size));
+    std::memcpy(space.data() + packet.size(), &element_size, 4);
+    std::memcpy(space.data() + packet.size() + 4, data, size);
+    return sequence_writer.commit(
+        offset, SPA_CONTROL_OSC,
+        static_cast<uint32_t>(OSCPP::Size::bundle(1) + size));
+  }
+
+  /*! \brief Check whether a packet of the given size fits. */
+  [[nodiscard]] bool fits(const std::size_t size) const {
+    return size <= sequence_writer.reserve().size();
+  }
+
+  /*! \brief The number of packets written so far. */
+  [[nodiscard]] std::size_t size() const { return sequence_writer.size(); }
+
+  /*! \brief Complete the sequence, see SequenceWriter::finish. */
+  void finish() { sequence_writer.finish(); }
+
+private:
+  spa::pod::SequenceWriter sequence_writer;
+};
+
+/*! \brief Write OSC messages into a buffer of an output port, e.g. to
+ * forward the messages of a PacketView.
+ *
+ * A message with a timetag is wrapped in a bundle of its own, so the
+ * timetag of its enclosing bundle is kept.
+ *
+ * Writing stops at the first message that can't be written, the messages
+ * written up to that point are kept.
+ *
+ * \param buffer The output buffer.
+ * \param packets timed_packet values in ascending offset order.
+ *
+ * \return The number of written messages or the error that stopped writing.
+ */
+template <std::ranges::input_range R>
+std::expected<std::size_t, error> write_osc(Buffer &buffer, R &&packets) {
+  auto spa_data = buffer.get_spa_data(0);
+  if (!spa_data.has_value()) {
+    return 0;
+  }
+
+  OscWriter writer(spa_data.value());
+  for (const timed_packet &packet : packets) {
+    if (auto result =
+            writer.write_packet(packet.offset, packet.time,
+                                packet.packet.data(), packet.packet.size());
+        !result.has_value()) {
+      writer.finish();
+      return std::unexpected(result.error());
+    }
+  }
+
+  writer.finish();
+  return writer.size();
+}
 
 } // namespace pwcpp::osc
@@ -0,0 +1,402 @@
+#pragma once
+
+#include "pwcpp/error.h"
+#include "pwcpp/midi/message.h"
+#include "pwcpp/property/parameter_change.h"
+#include "pwcpp/property/parameters_property.h"
+#include "pwcpp/rt/swappable.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace pwcpp::property {
+
+/*! \brief A parameter that midi controllers can be bound to. */
+struct binding_slot {
+  /*! \brief The name of the parameter in the ParametersProperty. */
+  std::string parameter;
+  /*! \brief The parameter value of controller value 0. */
+  double minimum = 0.0;
+  /*! \brief The parameter value of the maximum controller value. */
+  double maximum = 1.0;
+};
+
+/*! \brief A controller bound to a slot. */
+struct midi_binding {
+  uint8_t port;
+  uint8_t channel;
+  uint8_t cc_number;
+  std::size_t slot;
+
+  bool operator==(const midi_binding &) const = default;
+};
+
+/*! \brief Binds midi controllers to parameters.
+ *
+ * Every (port, channel, controller) combination has an entry in a flat table
+ * that holds the slot it is bound to, so a control change is dispatched in
+ * constant time in the process callback. The table is rebuilt on the main
+ * loop whenever the bindings change and handed to the process callback with
+ * rt::Swappable.
+ *
+ * The process callback stores the latest value of every slot in an atomic
+ * and marks it dirty. MidiBindings::sync copies the dirty values into the
+ * ParametersProperty on the main loop, e.g. from a timer, and completes midi
+ * learn. Bindings are persisted as a string parameter, so they are part of
+ * the Props pod like every other parameter.
+ *
+ * \tparam MAX_SLOTS The maximum number of slots.
+ */
+template <std::size_t MAX_SLOTS = 64> class MidiBindings {
+public:
+  static_assert(MAX_SLOTS < 0xff, "Slots are stored as 8 bit indices.");
+
+  /*! \brief The parameter the bindings are persisted in by default. */
+  static constexpr std::string_view default_parameter = "midi.bindings";
+
+  /*! \brief Create the bindings.
+   *
+   * \param slots The parameters controllers can be bound to, at most
+   * `MAX_SLOTS`.
+   * \param ports The number of midi input ports.
+   * \param bindings_parameter The name of the string parameter the bindings
+   * are persisted in, it has to be added to the parameters.
+   *
+   * \return The bindings, or a configuration error if there are more slots
+   * than `MAX_SLOTS`.
+   */
+  static std::expected<std::unique_ptr<MidiBindings>, error>
+  create(std::vector<binding_slot> slots, const uint8_t ports,
+         std::string bindings_parameter = std::string(default_parameter)) {
+    if (slots.size() > MAX_SLOTS) {
+      return std::unexpected(error::configuration());
+    }
+    return std::unique_ptr<MidiBindings>(new MidiBindings(
+        std::move(slots), ports, std::move(bindings_parameter)));
+  }
+
+  MidiBindings(const MidiBindings &) = delete;
+  MidiBindings &operator=(const MidiBindings &) = delete;
+
+  /*! \brief Bind a controller to a slot, replacing its previous binding.
+   * Called from the main loop. */
+  std::expected<void, error> bind(const midi_binding &binding) {
+    if (binding.slot >= slots.size() || binding.port >= ports) {
+      return std::unexpected(error::configuration());
+    }
+
+    std::erase_if(bindings, [&binding](const midi_binding &b) {
+      return b.port == binding.port && b.channel == binding.channel &&
+             b.cc_number == binding.cc_number;
+    });
+    bindings.push_back(binding);
+    publish();
+    return {};
+  }
+
+  /*! \brief Remove all bindings of a slot. Called from the main loop. */
+  void unbind(const std::size_t slot) {
+    std::erase_if(bindings,
+                  [slot](const midi_binding &b) { return b.slot == slot; });
+    publish();
+  }
+
+  /*! \brief The current bindings. */
+  [[nodiscard]] std::span<const midi_binding> current() const {
+    return bindings;
+  }
+
+  /*! \brief Bind the next controller the process callback receives to the
+   * slot. Called from the main loop, completed by MidiBindings::sync. */
+  void learn(const std::size_t slot) {
+    learn_slot.store(slot < slots.size() ? static_cast<int>(slot) : -1);
+  }
+
+  /*! \brief Check whether learning is in progress. */
+  [[nodiscard]] bool learning() const { return learn_slot.load() >= 0; }
+
+  /*! \brief Dispatch the control changes of an input port.
+   *
+   * Called from the process callback. Doesn't allocate or block.
+   *
+   * \param port The index of the input port.
+   * \param messages The messages of the port.
+   * \param on_change Called with a parameter_change for every bound
+   * controller, in message order.
+   */
+  template <typename F>
+  void process(const uint8_t port, std::span<const midi::timed_message> messages,
+               F &&on_change) {
+    const auto *table = tables.acquire();
+    for (const auto &message : messages) {
+      const auto *cc = std::get_if<midi::control_change>(&message.message);
+      if (cc == nullptr) {
+        continue;
+      }
+
+      const auto channel = static_cast<uint8_t>(cc->channel & 0x0f);
+      const auto cc_number = static_cast<uint8_t>(cc->cc_number & 0x7f);
+      if (const int slot = learn_slot.load(std::memory_order_relaxed);
+          slot >= 0 && port < ports) {
+        learned.store(learned_flag | static_cast<uint64_t>(slot) << 24 |
+                          static_cast<uint64_t>(port) << 16 |
+                          static_cast<uint64_t>(channel) << 8 | cc_number,
+                      std::memory_order_release);
+        learn_slot.store(-1, std::memory_order_relaxed);
+      }
+
+      if (table == nullptr || port >= table->ports) {
+        continue;
+      }
+
+      const auto entry = table->entries[(port * 16 + channel) * 128 + cc_number];
+      if (entry == 0) {
+        continue;
+      }
+
+      const std::size_t slot = entry - 1;
+      const auto &range = table->ranges[slot];
+      const double value =
+          range.minimum + (range.maximum - range.minimum) *
+                              (static_cast<double>(cc->value) / 4294967295.0);
+
+      values[slot].store(value, std::memory_order_relaxed);
+      dirty[slot / 64].fetch_or(uint64_t(1) << (slot % 64),
+                                std::memory_order_release);
+      on_change(parameter_change{message.offset, slot, value});
+    }
+  }
+
+  /*! \brief The latest value of a slot set by a controller. */
+  [[nodiscard]] double value(const std::size_t slot) const {
+    return values[slot].load(std::memory_order_relaxed);
+  }
+
+  /*! \brief Bring the parameters up to date, called from the main loop.
+   *
+   * Writes the values of the slots changed since the last call into the
+   * parameters, completes midi learn and persists changed bindings.
+   *
+   * \return True if a parameter changed and the Props pod should be
+   * updated, or the first error of updating a parameter. The other
+   * parameters are updated regardless.
+   */
+  std::expected<bool, error> sync(ParametersProperty &parameters) {
+    bool changed = false;
+    std::optional<error> failure;
+
+    if (const auto captured = learned.exchange(0, std::memory_order_acquire);
+        captured & learned_flag) {
+      const midi_binding binding{static_cast<uint8_t>(captured >> 16 & 0xff),
+                                 static_cast<uint8_t>(captured >> 8 & 0xff),
+                                 static_cast<uint8_t>(captured & 0xff),
+                                 static_cast<std::size_t>(captured >> 24 & 0xff)};
+      changed |= bind(binding).has_value();
+    }
+
+    for (std::size_t word = 0; word < dirty.size(); ++word) {
+      auto bits = dirty[word].exchange(0, std::memory_order_acquire);
+      while (bits != 0) {
+        const std::size_t slot = word * 64 + std::countr_zero(bits);
+        bits &= bits - 1;
+        if (slot >= slots.size()) {
+          continue;
+        }
+        if (auto result = update(parameters, slot); result.has_value()) {
+          changed = true;
+        } else if (!failure.has_value()) {
+          failure = result.error();
+        }
+      }
+    }
+
+    if (persisted != serialize()) {
+      persisted = serialize();
+      if (auto result = parameters.update(bindings_parameter, persisted);
+          result.has_value()) {
+        changed = true;
+      } else if (!failure.has_value()) {
+        failure = result.error();
+      }
+    }
+
+    if (failure.has_value()) {
+      return std::unexpected(*failure);
+    }
+    return changed;
+  }
+
+  /*! \brief Restore the bindings persisted in the parameters, e.g. after the
+   * parameters were updated from a Props pod. Called from the main loop. */
+  void restore(const ParametersProperty &parameters) {
+    for (const auto &[name, value] : parameters.parameters()) {
+      if (name != bindings_parameter) {
+        continue;
+      }
+
+      if (const auto *text = std::get_if<std::string>(&value);
+          text != nullptr && *text != persisted) {
+        bindings = deserialize(*text);
+        persisted = *text;
+        publish();
+      }
+    }
+  }
+
+  /*! \brief The bindings as text, `port:channel:controller:parameter`
+   * separated by `;`. */
+  [[nodiscard]] std::string serialize() const {
+    std::string text;
+    for (const auto &binding : bindings) {
+      if (!text.empty()) {
+        text += ';';
+      }
+      text += std::to_string(binding.port) + ':' +
+              std::to_string(binding.channel) + ':' +
+              std::to_string(binding.cc_number) + ':' +
+              slots[binding.slot].parameter;
+    }
+    return text;
+  }
+
+  /*! \brief Parse bindings serialized with MidiBindings::serialize, entries
+   * that don't match a slot or port are skipped. */
+  [[nodiscard]] std::vector<midi_binding>
+  deserialize(std::string_view text) const {
+    std::vector<midi_binding> result;
+    while (!text.empty()) {
+      const auto end = text.find(';');
+      auto entry = text.substr(0, end);
+      text = end == std::string_view::npos ? std::string_view{}
+                                           : text.substr(end + 1);
+
+      std::array<unsigned, 3> numbers{};
+      bool valid = true;
+      for (auto &number : numbers) {
+        const auto separator = entry.find(':');
+        const auto field = entry.substr(0, separator);
+        auto [pointer, error_code] =
+            std::from_chars(field.data(), field.data() + field.size(), number);
+        if (separator == std::string_view::npos || error_code != std::errc() ||
+            pointer != field.data() + field.size()) {
+          valid = false;
+          break;
+        }
+        entry = entry.substr(separator + 1);
+      }
+
+      if (!valid || numbers[0] >= ports || numbers[1] > 15 || numbers[2] > 127) {
+        continue;
+      }
+
+      for (std::size_t slot = 0; slot < slots.size(); ++slot) {
+        if (slots[slot].parameter == entry) {
+          result.push_back({static_cast<uint8_t>(numbers[0]),
+                            static_cast<uint8_t>(numbers[1]),
+                            static_cast<uint8_t>(numbers[2]), slot});
+          break;
+        }
+      }
+    }
+    return result;
+  }
+
+  /*! \brief Destroy binding tables the process callback no longer uses.
+   * Called from the main loop. */
+  void collect() { tables.collect(); }
+
+private:
+  MidiBindings(std::vector<binding_slot> slots, const uint8_t ports,
+               std::string bindings_parameter)
+      : slots(std::move(slots)), ports(ports),
+        bindings_parameter(std::move(bindings_parameter)) {
+    publish();
+  }
+
+  static constexpr uint64_t learned_flag = uint64_t(1) << 40;
+
+  struct range {
+    double minimum;
+    double maximum;
+  };
+
+  struct table {
+    uint8_t ports;
+    std::vector<uint8_t> entries;
+    std::array<range, MAX_SLOTS> ranges;
+  };
+
+  void publish() {
+    auto next = std::make_unique<table>();
+    next->ports = ports;
+    next->entries.assign(static_cast<std::size_t>(ports) * 16 * 128, 0);
+    for (std::size_t slot = 0; slot < slots.size(); ++slot) {
+      next->ranges[slot] = {slots[slot].minimum, slots[slot].maximum};
+    }
+    for (const auto &binding : bindings) {
+      next->entries[(binding.port * 16 + (binding.channel & 0x0f)) * 128 +
+                    (binding.cc_number & 0x7f)] =
+          static_cast<uint8_t>(binding.slot + 1);
+    }
+    tables.publish(std::move(next));
+  }
+
+  /*! \brief Write the value of a slot into its parameter, converted to the
+   * type the parameter currently holds. */
+  std::expected<void, error> update(ParametersProperty &parameters,
+                                    const std::size_t slot) {
+    auto name = slots[slot].parameter;
+    const auto value = values[slot].load(std::memory_order_relaxed);
+    for (const auto &[key, current] : parameters.parameters()) {
+      if (key != name) {
+        continue;
+      }
+
+      if (std::holds_alternative<int>(current)) {
+        auto converted = static_cast<int>(std::round(value));
+        return parameters.update(name, converted);
+      } else if (std::holds_alternative<long>(current)) {
+        auto converted = std::lround(value);
+        return parameters.update(name, converted);
+      } else if (std::holds_alternative<float>(current)) {
+        auto converted = static_cast<float>(value);
+        return parameters.update(name, converted);
+      } else if (std::holds_alternative<double>(current)) {
+        auto converted = value;
+        return parameters.update(name, converted);
+      } else if (std::holds_alternative<bool>(current)) {
+        auto converted = value >= 0.5;
+        return parameters.update(name, converted);
+      }
+      return std::unexpected(error::configuration());
+    }
+    return std::unexpected(error::parameter_not_found(name));
+  }
+
+  std::vector<binding_slot> slots;
+  uint8_t ports;
+  std::string bindings_parameter;
+  std::vector<midi_binding> bindings;
+  std::string persisted;
+  rt::Swappable<table> tables;
+  std::atomic<int> learn_slot = -1;
+  std::atomic<uint64_t> learned = 0;
+  std::array<std::atomic<double>, MAX_SLOTS> values{};
+  std::array<std::atomic<uint64_t>, (MAX_SLOTS + 63) / 64> dirty{};
+};
+
+} // namespace pwcpp::property
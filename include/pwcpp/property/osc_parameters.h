@@ -0,0 +1,328 @@
+#pragma once
+
+#include "pwcpp/error.h"
+#include "pwcpp/osc/dispatcher.h"
+#include "pwcpp/osc/packet_view.h"
+#include "pwcpp/property/parameter_change.h"
+#include "pwcpp/property/parameters_property.h"
+#include "pwcpp/rt/swappable.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace pwcpp::property {
+
+/*! \brief Maps OSC addresses onto parameters.
+ *
+ * Every numeric parameter of a ParametersProperty gets a slot addressed as
+ * `<prefix>/<name>`, e.g. `/filter/gain` for the parameter `gain` and the
+ * prefix `/filter`. A message to that address with an int or float argument
+ * sets the parameter, converted to the parameter's type: int, long and bool
+ * parameters read the argument as an int32, so large ints stay exact and
+ * floats are rounded, bools are true for values other than 0.
+ *
+ * The addresses are compiled into an osc::Dispatcher on the main loop and
+ * handed to the process callback with rt::Swappable. OscParameters::process
+ * dispatches the messages of a cycle and reports every change at the sample
+ * offset of its message, so it takes effect sample accurately without a
+ * Props round trip through the daemon. Like MidiBindings, the latest value
+ * of every slot is stored in an atomic, OscParameters::sync copies changed
+ * values into the ParametersProperty on the main loop.
+ *
+ * \tparam MAX_SLOTS The maximum number of slots.
+ */
+template <std::size_t MAX_SLOTS = 64> class OscParameters {
+public:
+  /*! \brief Create the mapping. Called from the main loop.
+   *
+   * \param prefix The address prefix, see OscParameters::set_prefix. With an
+   * invalid prefix nothing is mapped until a valid one is set.
+   * \param parameters The parameters, parameters that are added later are
+   * not mapped.
+   *
+   * \return The mapping, or a configuration error if there are more
+   * addressable numeric parameters than `MAX_SLOTS`.
+   */
+  static std::expected<std::unique_ptr<OscParameters>, error>
+  create(std::string prefix, const ParametersProperty &parameters) {
+    const auto mapped = std::ranges::count_if(
+        parameters.parameters(), [](const auto &parameter) {
+          const auto &[name, value] = parameter;
+          return is_addressable(name) && type_of(value).has_value();
+        });
+    if (static_cast<std::size_t>(mapped) > MAX_SLOTS) {
+      return std::unexpected(error::configuration());
+    }
+    return std::unique_ptr<OscParameters>(
+        new OscParameters(std::move(prefix), parameters));
+  }
+
+  OscParameters(const OscParameters &) = delete;
+  OscParameters &operator=(const OscParameters &) = delete;
+
+  /*! \brief Change the address prefix, e.g. `/filter/<name>`. Called from
+   * the main loop.
+   *
+   * \param prefix The prefix, it starts with `/` and may be followed by
+   * address parts separated by `/`. An empty prefix maps the parameters to
+   * `/<name>`.
+   */
+  std::expected<void, error> set_prefix(std::string prefix) {
+    while (!prefix.empty() && prefix.back() == '/') {
+      prefix.pop_back();
+    }
+    if (!prefix.empty() && prefix.front() != '/') {
+      return std::unexpected(error::osc_invalid_address_pattern());
+    }
+    for (const auto part : std::views::split(std::string_view(prefix), '/') |
+                               std::views::drop(1)) {
+      if (!is_addressable(std::string_view(part.begin(), part.end()))) {
+        return std::unexpected(error::osc_invalid_address_pattern());
+      }
+    }
+
+    auto dispatcher = std::make_unique<osc::Dispatcher>();
+    for (std::size_t slot = 0; slot < slots.size(); ++slot) {
+      const auto address = prefix + '/' + slots[slot].name;
+      std::expected<void, error> added;
+      if (slots[slot].type == value_type::FLOAT ||
+          slots[slot].type == value_type::DOUBLE) {
+        added = dispatcher->on_timed<float>(
+            address, [this, slot](const uint32_t offset, const float value) {
+              apply(offset, slot, value);
+            });
+      } else {
+        // Integers beyond the float precision stay exact.
+        added = dispatcher->on_timed<int32_t>(
+            address, [this, slot](const uint32_t offset, const int32_t value) {
+              apply(offset, slot, value);
+            });
+      }
+      if (!added.has_value()) {
+        return std::unexpected(added.error());
+      }
+    }
+    if (auto compiled = dispatcher->compile(); !compiled.has_value()) {
+      return std::unexpected(compiled.error());
+    }
+
+    address_prefix = std::move(prefix);
+    dispatchers.publish(std::move(dispatcher));
+    return {};
+  }
+
+  /*! \brief The current address prefix. */
+  [[nodiscard]] const std::string &prefix() const { return address_prefix; }
+
+  /*! \brief The number of mapped parameters. */
+  [[nodiscard]] std::size_t size() const { return slots.size(); }
+
+  /*! \brief The slot of a parameter, if it is mapped. */
+  [[nodiscard]] std::optional<std::size_t> slot(std::string_view name) const {
+    for (std::size_t i = 0; i < slots.size(); ++i) {
+      if (slots[i].name == name) {
+        return i;
+      }
+    }
+    return std::nullopt;
+  }
+
+  /*! \brief The address of a slot. */
+  [[nodiscard]] std::string address(const std::size_t slot) const {
+    return address_prefix + '/' + slots[slot].name;
+  }
+
+  /*! \brief Apply the messages of a cycle.
+   *
+   * Called from the process callback. Doesn't allocate or block.
+   *
+   * \param packets osc::timed_packet values, e.g. a osc::PacketView.
+   * \param on_change Called with a parameter_change for every message to a
+   * mapped address, in message order.
+   *
+   * \return The number of changes.
+   */
+  template <std::ranges::input_range R, typename F>
+  std::size_t process(R &&packets, F &&on_change) {
+    const auto *dispatcher = dispatchers.acquire();
+    if (dispatcher == nullptr) {
+      return 0;
+    }
+
+    sink_context = &on_change;
+    sink = [](void *context, const parameter_change &change) {
+      (*static_cast<std::remove_reference_t<F> *>(context))(change);
+    };
+    changes = 0;
+    for (const osc::timed_packet &packet : packets) {
+      dispatcher->dispatch(packet);
+    }
+    sink = nullptr;
+    return changes;
+  }
+
+  /*! \brief The latest value of a slot. */
+  [[nodiscard]] double value(const std::size_t slot) const {
+    return values[slot].load(std::memory_order_relaxed);
+  }
+
+  /*! \brief Bring the parameters up to date, called from the main loop.
+   *
+   * \return True if a parameter changed and the Props pod should be
+   * updated.
+   */
+  bool sync(ParametersProperty &parameters) {
+    bool changed = false;
+    for (std::size_t word = 0; word < dirty.size(); ++word) {
+      auto bits = dirty[word].exchange(0, std::memory_order_acquire);
+      while (bits != 0) {
+        const std::size_t slot = word * 64 + std::countr_zero(bits);
+        bits &= bits - 1;
+        if (slot < slots.size()) {
+          changed |= update(parameters, slot).has_value();
+        }
+      }
+    }
+    return changed;
+  }
+
+  /*! \brief Destroy dispatchers the process callback no longer uses.
+   * Called from the main loop. */
+  void collect() { dispatchers.collect(); }
+
+private:
+  OscParameters(std::string prefix, const ParametersProperty &parameters) {
+    for (const auto &[name, value] : parameters.parameters()) {
+      if (!is_addressable(name)) {
+        continue;
+      }
+
+      if (const auto type = type_of(value); type.has_value()) {
+        values[slots.size()].store(as_double(value), std::memory_order_relaxed);
+        slots.push_back({name, type.value()});
+      }
+    }
+    set_prefix(std::move(prefix));
+  }
+
+  enum class value_type : uint8_t { INT, LONG, FLOAT, DOUBLE, BOOL };
+
+  struct mapped_parameter {
+    std::string name;
+    value_type type;
+  };
+
+  /*! \brief Check whether a name can be an address part, OSC reserves the
+   * pattern characters. */
+  static bool is_addressable(std::string_view name) {
+    return !name.empty() &&
+           name.find_first_of(" #*,/?[]{}") == std::string_view::npos;
+  }
+
+  static std::optional<value_type> type_of(const property_value_type &value) {
+    if (std::holds_alternative<int>(value)) {
+      return value_type::INT;
+    } else if (std::holds_alternative<long>(value)) {
+      return value_type::LONG;
+    } else if (std::holds_alternative<float>(value)) {
+      return value_type::FLOAT;
+    } else if (std::holds_alternative<double>(value)) {
+      return value_type::DOUBLE;
+    } else if (std::holds_alternative<bool>(value)) {
+      return value_type::BOOL;
+    }
+    return std::nullopt;
+  }
+
+  static double as_double(const property_value_type &value) {
+    return std::visit(
+        [](const auto &v) -> double {
+          using T = std::decay_t<decltype(v)>;
+          if constexpr (std::is_arithmetic_v<T>) {
+            return static_cast<double>(v);
+          } else {
+            return 0.0;
+          }
+        },
+        value);
+  }
+
+  void apply(const uint32_t offset, const std::size_t slot, const double value) {
+    double converted = value;
+    switch (slots[slot].type) {
+    case value_type::INT:
+    case value_type::LONG:
+      converted = std::round(converted);
+      break;
+    case value_type::BOOL:
+      converted = converted != 0.0 ? 1.0 : 0.0;
+      break;
+    case value_type::FLOAT:
+    case value_type::DOUBLE:
+      break;
+    }
+
+    values[slot].store(converted, std::memory_order_relaxed);
+    dirty[slot / 64].fetch_or(uint64_t(1) << (slot % 64),
+                              std::memory_order_release);
+    changes++;
+    if (sink != nullptr) {
+      sink(sink_context, parameter_change{offset, slot, converted});
+    }
+  }
+
+  std::expected<void, error> update(ParametersProperty &parameters,
+                                    const std::size_t slot) {
+    const auto value = values[slot].load(std::memory_order_relaxed);
+    const auto &name = slots[slot].name;
+    switch (slots[slot].type) {
+    case value_type::INT: {
+      auto converted = static_cast<int>(value);
+      return parameters.update(name, converted);
+    }
+    case value_type::LONG: {
+      auto converted = static_cast<long>(value);
+      return parameters.update(name, converted);
+    }
+    case value_type::FLOAT: {
+      auto converted = static_cast<float>(value);
+      return parameters.update(name, converted);
+    }
+    case value_type::DOUBLE: {
+      auto converted = value;
+      return parameters.update(name, converted);
+    }
+    case value_type::BOOL: {
+      auto converted = value != 0.0;
+      return parameters.update(name, converted);
+    }
+    }
+    return std::unexpected(error::configuration());
+  }
+
+  std::vector<mapped_parameter> slots;
+  std::string address_prefix;
+  rt::Swappable<osc::Dispatcher> dispatchers;
+  void *sink_context = nullptr;
+  void (*sink)(void *, const parameter_change &) = nullptr;
+  std::size_t changes = 0;
+  std::array<std::atomic<double>, MAX_SLOTS> values{};
+  std::array<std::atomic<uint64_t>, (MAX_SLOTS + 63) / 64> dirty{};
+};
+
+} // namespace pwcpp::property
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pwcpp::property {
+
+/*! \brief A parameter changed by a controller, at the sample offset of the
+ * controller's message. */
+struct parameter_change {
+  uint32_t offset;
+  std::size_t slot;
+  double value;
+};
+
+} // namespace pwcpp::property
@@ -2,6 +2,9 @@
 
 #include "pwcpp/property/property.h"
 
+#include <algorithm>
+#include <memory>
+#include <span>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+namespace pwcpp::rt {
+
+/*! \brief A bounded lock-free queue between one producer and one consumer.
+ *
+ * Used to pass values between the process callback and the main loop in
+ * either direction. Pushing and popping never block, allocate or free, a
+ * push into a full queue fails and the value is left to the caller.
+ *
+ * \tparam T The type of the values, copied into a fixed array.
+ * \tparam CAPACITY The maximum number of queued values, a power of two.
+ */
+template <typename T, std::size_t CAPACITY> class SpscQueue {
+public:
+  static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0,
+                "The capacity has to be a power of two.");
+
+  SpscQueue() = default;
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  /*! \brief Queue a value, called by the producer.
+   *
+   * \return False if the queue is full.
+   */
+  bool try_push(const T &value) {
+    const auto t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == CAPACITY) {
+      return false;
+    }
+
+    items[t & (CAPACITY - 1)] = value;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  /*! \brief Take the oldest value, called by the consumer. */
+  std::optional<T> try_pop() {
+    const auto h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) {
+      return std::nullopt;
+    }
+
+    std::optional<T> value(items[h & (CAPACITY - 1)]);
+    head.store(h + 1, std::memory_order_release);
+    return value;
+  }
+
+  /*! \brief Take all queued values, called by the consumer.
+   *
+   * \param f Called with every value in queue order.
+   *
+   * \return The number of values taken.
+   */
+  template <typename F> std::size_t drain(F &&f) {
+    const auto h = head.load(std::memory_order_relaxed);
+    const auto t = tail.load(std::memory_order_acquire);
+    for (auto i = h; i != t; ++i) {
+      f(items[i & (CAPACITY - 1)]);
+    }
+    head.store(t, std::memory_order_release);
+    return t - h;
+  }
+
+  /*! \brief The number of queued values, exact only for the consumer and
+   * the producer themselves. */
+  [[nodiscard]] std::size_t size() const {
+    return tail.load(std::memory_order_acquire) -
+           head.load(std::memory_order_acquire);
+  }
+
+  [[nodiscard]] bool empty() const { return size() == 0; }
+
+  [[nodiscard]] static constexpr std::size_t capacity() { return CAPACITY; }
+
+private:
+  // Producer and consumer indices on separate cache lines.
+  alignas(64) std::atomic<std::size_t> head = 0;
+  alignas(64) std::atomic<std::size_t> tail = 0;
+  std::array<T, CAPACITY> items{};
+};
+
+} // namespace pwcpp::rt
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace pwcpp::rt {
+
+/*! \brief An object that is replaced from the main loop while the process
+ * callback reads it.
+ *
+ * The main loop publishes new versions with Swappable::publish, the process
+ * callback picks up the latest version with Swappable::acquire at the start
+ * of a cycle. Acquiring never blocks, allocates or frees. Replaced versions
+ * are kept until Swappable::collect finds that the process callback no
+ * longer uses them, so they are always destroyed on the main loop.
+ *
+ * Only one thread may acquire and only one thread may publish and collect.
+ */
+template <typename T> class Swappable {
+public:
+  Swappable() = default;
+  Swappable(const Swappable &) = delete;
+  Swappable &operator=(const Swappable &) = delete;
+
+  ~Swappable() {
+    delete current.load();
+    for (auto *retired_version : retired) {
+      delete retired_version;
+    }
+  }
+
+  /*! \brief Make a new version visible to the process callback.
+   *
+   * Called from the main loop. Also collects the versions that are no longer
+   * used.
+   */
+  void publish(std::unique_ptr<T> version) {
+    auto *previous = current.exchange(version.release());
+    if (previous != nullptr) {
+      retired.push_back(previous);
+    }
+    collect();
+  }
+
+  /*! \brief Destroy the replaced versions the process callback no longer
+   * uses.
+   *
+   * Called from the main loop.
+   *
+   * \return The number of versions that are still in use.
+   */
+  std::size_t collect() {
+    const auto *used = in_use.load();
+    std::erase_if(retired, [used](T *version) {
+      if (version == used) {
+        return false;
+      }
+      delete version;
+      return true;
+    });
+    return retired.size();
+  }
+
+  /*! \brief The latest published version or nullptr if none was published.
+   *
+   * Called from the process callback. The version stays valid until the
+   * next call of acquire or release.
+   */
+  const T *acquire() {
+    T *version = current.load();
+    // Announce the version before using it, then check that it wasn't
+    // retired in between, otherwise collect might have missed it.
+    for (;;) {
+      in_use.store(version);
+      T *latest = current.load();
+      if (latest == version) {
+        return version;
+      }
+      version = latest;
+    }
+  }
+
+  /*! \brief Stop using the acquired version.
+   *
+   * Called from the process callback, allows collect to destroy the version
+   * if it was replaced.
+   */
+  void release() { in_use.store(nullptr); }
+
+private:
+  std::atomic<T *> current = nullptr;
+  std::atomic<T *> in_use = nullptr;
+  std::vector<T *> retired;
+};
+
+} // namespace pwcpp::rt
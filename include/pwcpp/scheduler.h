@@ -0,0 +1,400 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include <spa/node/io.h>
+
+namespace pwcpp {
+
+/*! \brief Schedules events at sample positions of the graph, across cycles.
+ *
+ * Arpeggiators, delays or retriggers schedule events in graph sample time,
+ * the `clock.position` of `spa_io_position`, and EventScheduler::release
+ * hands out the events due in the current cycle sorted by sample offset,
+ * ready to be written to an output sequence. Events with the same time keep
+ * the order they were scheduled in.
+ *
+ * The events are kept in a hierarchical timing wheel: the first level has a
+ * slot per sample for 1024 samples, every further level has 64 slots of 64
+ * times the span of a slot of the level below. An event is put into the
+ * lowest level whose span around the current time contains it, and moves
+ * down a level whenever the current time enters its slot. Scheduling and
+ * releasing an event is O(1), empty slots of the first level are skipped
+ * with a bitmap. Events are stored in `CAPACITY` preallocated nodes, so
+ * nothing is allocated and events beyond the capacity are dropped.
+ *
+ * All methods are called from the process callback.
+ *
+ * \tparam T The type of the events, e.g. midi::message.
+ * \tparam CAPACITY The maximum number of scheduled events.
+ * \tparam LEVELS The number of levels, which sets EventScheduler::horizon.
+ */
+template <typename T, std::size_t CAPACITY = 256, std::size_t LEVELS = 4>
+class EventScheduler {
+public:
+  static_assert(CAPACITY > 0 && CAPACITY < 0xffffffff);
+  static_assert(LEVELS >= 2 && LEVELS <= 9);
+
+  /*! \brief The number of slots of the first level, a slot per sample. */
+  static constexpr uint32_t first_level_slots = 1024;
+
+  /*! \brief The number of slots of every further level. */
+  static constexpr uint32_t level_slots = 64;
+
+  /*! \brief Events can be scheduled at least this many samples ahead,
+   * about 92 minutes at 48 kHz with four levels. */
+  static constexpr uint64_t horizon = uint64_t(level_slots - 1)
+                                      << (10 + 6 * (LEVELS - 2));
+
+  EventScheduler() { clear(); }
+
+  EventScheduler(const EventScheduler &) = delete;
+  EventScheduler &operator=(const EventScheduler &) = delete;
+
+  /*! \brief Start a cycle, called at the start of the process callback.
+   *
+   * \param position The position passed to the process callback. Without a
+   * position nothing is released in the cycle.
+   */
+  void update(const spa_io_position *position) {
+    if (position == nullptr || position->clock.duration == 0) {
+      valid = false;
+      return;
+    }
+    update(position->clock.position,
+           static_cast<uint32_t>(position->clock.duration));
+  }
+
+  /*! \brief Start a cycle.
+   *
+   * If the cycle doesn't start where the last one ended, e.g. after an xrun,
+   * the events due before the cycle are released at offset 0. If the time
+   * went backwards, e.g. after the driver changed, all events keep their
+   * distance to the current time.
+   *
+   * \param start The graph time of the first sample of the cycle.
+   * \param samples The number of samples of the cycle.
+   */
+  void update(const uint64_t start, const uint32_t samples) {
+    if (start != now) {
+      relocate(start);
+    }
+    cycle_start = start;
+    cycle_samples = samples;
+    valid = true;
+  }
+
+  /*! \brief Schedule an event.
+   *
+   * Events due before the end of the last release, including events
+   * scheduled from the callback of EventScheduler::release, are released at
+   * offset 0 of the next release.
+   *
+   * \param time The graph time of the event.
+   *
+   * \return False if the scheduler is full or the time is beyond
+   * EventScheduler::horizon.
+   */
+  bool schedule(const uint64_t time, const T &event) {
+    const uint64_t earliest = releasing ? cycle_start + cycle_samples : now;
+    const uint64_t due = std::max(time, earliest);
+    if ((due >> shift(LEVELS - 1)) - (now >> shift(LEVELS - 1)) >
+            level_slots ||
+        free_head == none) {
+      dropped_events++;
+      return false;
+    }
+
+    if (time < earliest) {
+      late_events++;
+    }
+
+    const auto node = free_head;
+    free_head = nodes[node].next;
+    nodes[node].time = due;
+    nodes[node].event = event;
+    place(node);
+    pending++;
+    return true;
+  }
+
+  /*! \brief Schedule an event relative to a sample of the current cycle,
+   * e.g. the offset of the midi message that triggers it.
+   *
+   * \param offset The sample offset in the current cycle.
+   * \param delay The number of samples after the offset.
+   */
+  bool schedule_after(const uint32_t offset, const uint64_t delay,
+                      const T &event) {
+    return schedule(cycle_start + offset + delay, event);
+  }
+
+  /*! \brief Release the events due in the current cycle.
+   *
+   * \param f Called with the sample offset and the event, sorted by
+   * offset.
+   *
+   * \return The number of released events.
+   */
+  template <typename F> std::size_t release(F &&f) {
+    if (!valid) {
+      return 0;
+    }
+
+    const uint64_t end = cycle_start + cycle_samples;
+    std::size_t released(0);
+    releasing = true;
+    while (now < end) {
+      if (pending == 0) {
+        now = end;
+        break;
+      }
+
+      const uint64_t block_end = (now | (first_level_slots - 1)) + 1;
+      const uint64_t segment_end = std::min(end, block_end);
+      if (first_level_count > 0) {
+        released += release_slots(now, segment_end, f);
+      }
+      now = segment_end;
+      if (now == block_end) {
+        cascade();
+      }
+    }
+    releasing = false;
+    return released;
+  }
+
+  /*! \brief Drop all scheduled events. */
+  void clear() {
+    for (auto &slot : first_level) {
+      slot = {};
+    }
+    for (auto &level : upper_levels) {
+      for (auto &slot : level) {
+        slot = {};
+      }
+    }
+    occupied.fill(0);
+    for (uint32_t i = 0; i < CAPACITY; ++i) {
+      nodes[i].next = i + 1 < CAPACITY ? i + 1 : none;
+    }
+    free_head = 0;
+    pending = 0;
+    first_level_count = 0;
+  }
+
+  /*! \brief The number of scheduled events. */
+  [[nodiscard]] std::size_t size() const { return pending; }
+
+  [[nodiscard]] bool empty() const { return pending == 0; }
+
+  [[nodiscard]] static constexpr std::size_t capacity() { return CAPACITY; }
+
+  /*! \brief The graph time of the first sample of the current cycle. */
+  [[nodiscard]] uint64_t start() const { return cycle_start; }
+
+  /*! \brief The number of events dropped because the scheduler was full or
+   * they were beyond the horizon. */
+  [[nodiscard]] std::size_t dropped() const { return dropped_events; }
+
+  /*! \brief The number of events scheduled or found too late for their
+   * time. */
+  [[nodiscard]] std::size_t late() const { return late_events; }
+
+private:
+  static constexpr uint32_t none = 0xffffffff;
+
+  struct node {
+    uint64_t time = 0;
+    uint32_t next = none;
+    T event{};
+  };
+
+  struct slot_list {
+    uint32_t head = none;
+    uint32_t tail = none;
+  };
+
+  /*! \brief The number of samples of a slot of a level, as a shift. */
+  static constexpr unsigned shift(const std::size_t level) {
+    return level == 0 ? 0 : 10 + 6 * static_cast<unsigned>(level - 1);
+  }
+
+  static void append(slot_list &slot, node *storage, const uint32_t index) {
+    storage[index].next = none;
+    if (slot.tail == none) {
+      slot.head = index;
+    } else {
+      storage[slot.tail].next = index;
+    }
+    slot.tail = index;
+  }
+
+  /*! \brief Put a node into the lowest level whose span around the current
+   * time contains it. */
+  void place(const uint32_t index) {
+    const uint64_t time = nodes[index].time;
+    const uint64_t difference = time ^ now;
+    if (difference < first_level_slots) {
+      const auto slot = static_cast<uint32_t>(time & (first_level_slots - 1));
+      append(first_level[slot], nodes.data(), index);
+      occupied[slot / 64] |= uint64_t(1) << (slot % 64);
+      first_level_count++;
+      return;
+    }
+
+    std::size_t level(1);
+    while (level + 1 < LEVELS &&
+           (difference >> (shift(level) + 6)) != 0) {
+      level++;
+    }
+    append(upper_levels[level - 1][(time >> shift(level)) & (level_slots - 1)],
+           nodes.data(), index);
+  }
+
+  /*! \brief Move the slots the current time just entered to the levels
+   * below, from the highest level down. */
+  void cascade() {
+    std::size_t top(1);
+    while (top + 1 < LEVELS &&
+           (now & ((uint64_t(1) << shift(top + 1)) - 1)) == 0) {
+      top++;
+    }
+
+    for (std::size_t level = top; level >= 1; --level) {
+      auto &slot =
+          upper_levels[level - 1][(now >> shift(level)) & (level_slots - 1)];
+      auto index = slot.head;
+      slot = {};
+      while (index != none) {
+        const auto next = nodes[index].next;
+        place(index);
+        index = next;
+      }
+    }
+  }
+
+  template <typename F>
+  std::size_t release_slots(const uint64_t from, const uint64_t to, F &f) {
+    const auto first = static_cast<uint32_t>(from & (first_level_slots - 1));
+    const auto last = static_cast<uint32_t>((to - 1) & (first_level_slots - 1));
+    std::size_t released(0);
+
+    for (auto word = first / 64; word <= last / 64; ++word) {
+      uint64_t bits = occupied[word];
+      if (word == first / 64) {
+        bits &= ~uint64_t(0) << (first % 64);
+      }
+      if (word == last / 64 && last % 64 != 63) {
+        bits &= (uint64_t(1) << (last % 64 + 1)) - 1;
+      }
+
+      while (bits != 0) {
+        const auto bit = static_cast<uint32_t>(std::countr_zero(bits));
+        bits &= bits - 1;
+        const auto slot = word * 64 + bit;
+        occupied[word] &= ~(uint64_t(1) << bit);
+        auto index = first_level[slot].head;
+        first_level[slot] = {};
+
+        while (index != none) {
+          auto &entry = nodes[index];
+          const auto next = entry.next;
+          uint32_t offset(0);
+          if (entry.time < cycle_start) {
+            late_events++;
+          } else {
+            offset = static_cast<uint32_t>(entry.time - cycle_start);
+          }
+          f(offset, static_cast<const T &>(entry.event));
+
+          entry.next = free_head;
+          free_head = index;
+          pending--;
+          first_level_count--;
+          released++;
+          index = next;
+        }
+      }
+    }
+    return released;
+  }
+
+  /*! \brief Move the current time to `start` outside of a release.
+   *
+   * Events due before `start` move to `start` if the time went forward,
+   * all events keep their distance to the current time if it went
+   * backwards.
+   */
+  void relocate(const uint64_t start) {
+    if (pending == 0) {
+      now = start;
+      return;
+    }
+
+    // Collect the nodes in time order: the first level in slot order, the
+    // levels above from the slot after the current one.
+    slot_list all;
+    for (auto &slot : first_level) {
+      for (auto index = slot.head; index != none;) {
+        const auto next = nodes[index].next;
+        append(all, nodes.data(), index);
+        index = next;
+      }
+      slot = {};
+    }
+    for (std::size_t level = 1; level < LEVELS; ++level) {
+      const auto current = (now >> shift(level)) & (level_slots - 1);
+      for (uint32_t i = 1; i <= level_slots; ++i) {
+        auto &slot = upper_levels[level - 1][(current + i) & (level_slots - 1)];
+        for (auto index = slot.head; index != none;) {
+          const auto next = nodes[index].next;
+          append(all, nodes.data(), index);
+          index = next;
+        }
+        slot = {};
+      }
+    }
+    occupied.fill(0);
+    first_level_count = 0;
+
+    const uint64_t previous = now;
+    now = start;
+    for (auto index = all.head; index != none;) {
+      const auto next = nodes[index].next;
+      auto &time = nodes[index].time;
+      if (start < previous) {
+        time = start + (time - previous);
+      } else if (time < start) {
+        time = start;
+        late_events++;
+      }
+      place(index);
+      index = next;
+    }
+  }
+
+  std::array<node, CAPACITY> nodes;
+  std::array<slot_list, first_level_slots> first_level;
+  std::array<std::array<slot_list, level_slots>, LEVELS - 1> upper_levels;
+  std::array<uint64_t, first_level_slots / 64> occupied{};
+
+  uint32_t free_head = none;
+  std::size_t pending = 0;
+  std::size_t first_level_count = 0;
+
+  uint64_t now = 0;
+  uint64_t cycle_start = 0;
+  uint32_t cycle_samples = 0;
+  bool valid = false;
+  bool releasing = false;
+
+  std::size_t dropped_events = 0;
+  std::size_t late_events = 0;
+};
+
+} // namespace pwcpp
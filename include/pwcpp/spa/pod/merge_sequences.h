@@ -0,0 +1,193 @@
+#pragma once
+
+#include "pwcpp/buffer.h"
+#include "pwcpp/error.h"
+#include "pwcpp/spa/pod/sequence_writer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <span>
+
+#include <spa/pod/iter.h>
+#include <spa/pod/pod.h>
+
+namespace pwcpp::spa::pod {
+
+/*! \brief A control of one of the merged sequences. */
+struct merged_control {
+  /*! \brief The sample offset of the control. */
+  uint32_t offset;
+  /*! \brief The input the control's sequence was added with, usually the
+   * index of its port. */
+  std::size_t input;
+  /*! \brief The control inside the sequence. */
+  const struct spa_pod_control *control;
+};
+
+/*! \brief Merges up to `MAX_K` sequences by control offset.
+ *
+ * The merger keeps a cursor per sequence in a binary heap ordered by the
+ * offset of the next control, so every control costs O(log k). The order is
+ * stable: controls with the same offset keep their order within a sequence
+ * and are ordered by the input of their sequence otherwise. The merger
+ * doesn't allocate and the sequences have to stay valid until merging is
+ * done.
+ */
+template <std::size_t MAX_K> class SequenceMerger {
+public:
+  /*! \brief Add a sequence to merge.
+   *
+   * \param sequence The sequence, empty sequences are ignored.
+   * \param input Identifies the sequence in the merged controls.
+   *
+   * \return An error if `MAX_K` sequences were added already.
+   */
+  std::expected<void, error> add(const struct spa_pod_sequence *sequence,
+                                 const std::size_t input) {
+    if (added >= MAX_K) {
+      return std::unexpected(error::sequence_merging_too_many_sequences());
+    }
+    added++;
+
+    const auto *body = &sequence->body;
+    const uint32_t size = SPA_POD_BODY_SIZE(sequence);
+    const auto *control = spa_pod_control_first(body);
+    if (!spa_pod_control_is_inside(body, size, control)) {
+      return {};
+    }
+
+    cursors[heap_size++] = {body, size, control, input};
+    std::push_heap(cursors.begin(), cursors.begin() + heap_size, later);
+    return {};
+  }
+
+  /*! \brief Take the next control in offset order.
+   *
+   * \return The control or nothing if all sequences are exhausted.
+   */
+  std::optional<merged_control> next() {
+    if (heap_size == 0) {
+      return std::nullopt;
+    }
+
+    std::pop_heap(cursors.begin(), cursors.begin() + heap_size, later);
+    auto &cursor = cursors[heap_size - 1];
+    merged_control result{cursor.control->offset, cursor.input,
+                          cursor.control};
+
+    cursor.control = spa_pod_control_next(cursor.control);
+    if (spa_pod_control_is_inside(cursor.body, cursor.size, cursor.control)) {
+      std::push_heap(cursors.begin(), cursors.begin() + heap_size, later);
+    } else {
+      heap_size--;
+    }
+
+    return result;
+  }
+
+  /*! \brief Check whether all controls were taken. */
+  [[nodiscard]] bool empty() const { return heap_size == 0; }
+
+  /*! \brief Remove all sequences. */
+  void clear() {
+    heap_size = 0;
+    added = 0;
+  }
+
+private:
+  struct cursor {
+    const struct spa_pod_sequence_body *body;
+    uint32_t size;
+    const struct spa_pod_control *control;
+    std::size_t input;
+  };
+
+  /*! \brief Heap order, the cursor with the earliest control is on top. */
+  static bool later(const cursor &a, const cursor &b) {
+    if (a.control->offset != b.control->offset) {
+      return a.control->offset > b.control->offset;
+    }
+    return a.input > b.input;
+  }
+
+  std::array<cursor, MAX_K> cursors;
+  std::size_t heap_size = 0;
+  std::size_t added = 0;
+};
+
+/*! \brief Visit the controls of several sequences in offset order.
+ *
+ * \param sequences The sequences, their index is the input of their
+ * controls.
+ * \param f Called with every merged_control.
+ *
+ * \return The number of visited controls or an error if there are more than
+ * `MAX_K` sequences.
+ */
+template <std::size_t MAX_K, typename F>
+std::expected<std::size_t, error>
+merge_sequences(std::span<const struct spa_pod_sequence *const> sequences,
+                F &&f) {
+  SequenceMerger<MAX_K> merger;
+  for (std::size_t input = 0; input < sequences.size(); ++input) {
+    if (auto result = merger.add(sequences[input], input); !result) {
+      return std::unexpected(result.error());
+    }
+  }
+
+  std::size_t count(0);
+  while (auto control = merger.next()) {
+    f(control.value());
+    count++;
+  }
+
+  return count;
+}
+
+/*! \brief Merge the sequences of several buffers into one sequence.
+ *
+ * Typically used with the buffers of all input ports of a filter and the
+ * SequenceWriter of an output port. Buffers without a sequence are skipped.
+ *
+ * \return The number of written controls or the error that stopped writing,
+ * controls written up to that point are kept.
+ */
+template <std::size_t MAX_K>
+std::expected<std::size_t, error> merge_sequences(std::span<Buffer> buffers,
+                                                  SequenceWriter &writer) {
+  SequenceMerger<MAX_K> merger;
+  for (std::size_t input = 0; input < buffers.size(); ++input) {
+    auto pod = buffers[input].get_pod(0);
+    if (!pod.has_value() || pod.value() == nullptr ||
+        !spa_pod_is_sequence(pod.value())) {
+      continue;
+    }
+
+    if (auto result = merger.add(
+            reinterpret_cast<const struct spa_pod_sequence *>(pod.value()),
+            input);
+        !result) {
+      return std::unexpected(result.error());
+    }
+  }
+
+  std::size_t count(0);
+  while (auto merged = merger.next()) {
+    const auto *value = &merged->control->value;
+    if (auto result = writer.write(merged->offset, merged->control->type,
+                                   SPA_POD_BODY_CONST(value),
+                                   SPA_POD_BODY_SIZE(value));
+        !result) {
+      return std::unexpected(result.error());
+    }
+    count++;
+  }
+
+  return count;
+}
+
+} // namespace pwcpp::spa::pod
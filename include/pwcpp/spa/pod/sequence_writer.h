@@ -0,0 +1,166 @@
+#pragma once
+
+#include "pwcpp/error.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+
+#include <spa/buffer/buffer.h>
+#include <spa/pod/builder.h>
+#include <spa/pod/pod.h>
+
+namespace pwcpp::spa::pod {
+
+/*! \brief Writes controls into a sequence pod in a spa data block.
+ *
+ * The writer builds the sequence directly in the mapped memory of an output
+ * buffer. Controls have to be written with ascending sample offsets and are
+ * only written if they fit completely, so the sequence stays valid when the
+ * buffer is full. The sequence is completed with SequenceWriter::finish,
+ * which also updates the chunk of the spa data.
+ */
+class SequenceWriter {
+public:
+  /*! \brief Construct a writer for the given spa data.
+   *
+   * \param data The spa data of the output buffer, usually retrieved with
+   * Buffer::get_spa_data.
+   */
+  explicit SequenceWriter(const struct spa_data &data) : chunk(data.chunk) {
+    spa_pod_builder_init(&builder, data.data, data.maxsize);
+    if (data.data != nullptr &&
+        data.maxsize >= sizeof(struct spa_pod_sequence)) {
+      spa_pod_builder_push_sequence(&builder, &frame, 0);
+      open = true;
+    }
+  }
+
+  /*! \brief Write a control with the given body.
+   *
+   * \param offset The sample offset of the control.
+   * \param type The control type, e.g. `SPA_CONTROL_UMP`.
+   * \param body The body of the bytes pod of the control.
+   * \param size The size of the body in bytes.
+   *
+   * \return Nothing if successful, an error if the offset is smaller than
+   * the offset of the previous control or the control does not fit.
+   */
+  std::expected<void, error> write(const uint32_t offset, const uint32_t type,
+                                   const void *body, const uint32_t size) {
+    if (auto result = check(offset, size); !result.has_value()) {
+      return result;
+    }
+
+    spa_pod_builder_control(&builder, offset, type);
+    spa_pod_builder_bytes(&builder, body, size);
+    last_offset = offset;
+    controls++;
+    return {};
+  }
+
+  /*! \brief The memory the body of the next control can be built in.
+   *
+   * Lets a control be encoded in place instead of being copied, the control
+   * is added with SequenceWriter::commit. Writing another control discards
+   * the built body.
+   *
+   * \return The free space after the control header, empty if the sequence
+   * is full or finished.
+   */
+  [[nodiscard]] std::span<uint8_t> reserve() const {
+    const std::size_t header = sizeof(struct spa_pod_control);
+    if (!open || remaining() < header + 8) {
+      return {};
+    }
+
+    auto *body = static_cast<uint8_t *>(builder.data) + builder.state.offset +
+                 header;
+    return {body, (remaining() - header) & ~std::size_t(7)};
+  }
+
+  /*! \brief Add a control whose body was built in the memory returned by
+   * SequenceWriter::reserve.
+   *
+   * \param offset The sample offset of the control.
+   * \param type The control type, e.g. `SPA_CONTROL_OSC`.
+   * \param size The size of the built body in bytes.
+   */
+  std::expected<void, error> commit(const uint32_t offset, const uint32_t type,
+                                    const uint32_t size) {
+    if (auto result = check(offset, size); !result.has_value()) {
+      return result;
+    }
+
+    spa_pod_builder_control(&builder, offset, type);
+    // A null body only advances the builder, the body is already in place.
+    spa_pod_builder_bytes(&builder, nullptr, size);
+    last_offset = offset;
+    controls++;
+    return {};
+  }
+
+  /*! \brief Check whether a control with a body of the given size fits into
+   * the remaining space. */
+  [[nodiscard]] bool fits(const uint32_t size) const {
+    return open && required_size(size) <= remaining();
+  }
+
+  /*! \brief The number of bytes left in the buffer. */
+  [[nodiscard]] std::size_t remaining() const {
+    return builder.size - builder.state.offset;
+  }
+
+  /*! \brief The number of controls written so far. */
+  [[nodiscard]] std::size_t size() const { return controls; }
+
+  /*! \brief Complete the sequence and update the chunk of the spa data.
+   *
+   * Has to be called before the buffer is finished. Calling it more than
+   * once has no effect.
+   */
+  void finish() {
+    if (open) {
+      spa_pod_builder_pop(&builder, &frame);
+      open = false;
+    }
+
+    if (chunk != nullptr) {
+      chunk->offset = 0;
+      chunk->size = builder.state.offset <= builder.size
+                        ? builder.state.offset
+                        : 0;
+      chunk->stride = 1;
+      chunk->flags = 0;
+    }
+  }
+
+  /*! \brief The size of a control with a body of the given size. */
+  static constexpr std::size_t required_size(const uint32_t size) {
+    return sizeof(struct spa_pod_control) + SPA_ROUND_UP_N(size, 8);
+  }
+
+protected:
+  std::expected<void, error> check(const uint32_t offset,
+                                   const uint32_t size) const {
+    if (controls > 0 && offset < last_offset) {
+      return std::unexpected(error::sequence_writing_offset_not_ascending());
+    }
+
+    if (!fits(size)) {
+      return std::unexpected(error::sequence_writing_buffer_overflow());
+    }
+
+    return {};
+  }
+
+  struct spa_pod_builder builder{};
+  struct spa_pod_frame frame{};
+  struct spa_chunk *chunk;
+  bool open = false;
+  uint32_t last_offset = 0;
+  std::size_t controls = 0;
+};
+
+} // namespace pwcpp::spa::pod
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "pwcpp/midi/message.h"
+#include "pwcpp/osc/packet_view.h"
+#include "pwcpp/property/parameter_change.h"
+
+#include <oscpp/server.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <variant>
+
+namespace pwcpp {
+
+/*! \brief The kind of a timeline_event, the index of its data. */
+enum class event_kind : uint8_t {
+  MIDI,
+  OSC,
+  PARAMETER,
+};
+
+/*! \brief An OSC message of a timeline.
+ *
+ * Only the location of the message is kept, the packet still points into
+ * the memory it was parsed from.
+ */
+struct timeline_osc {
+  const void *data;
+  std::size_t size;
+
+  /*! \brief A view of the message. */
+  OSCPP::Server::Packet packet() const {
+    return OSCPP::Server::Packet(data, size);
+  }
+};
+
+/*! \brief A parameter change of a timeline, see property::parameter_change.
+ */
+struct timeline_parameter {
+  std::size_t slot;
+  double value;
+};
+
+/*! \brief An event of a timeline at its sample offset in the cycle. */
+struct timeline_event {
+  std::variant<midi::message, timeline_osc, timeline_parameter> data;
+  uint32_t offset;
+
+  event_kind kind() const { return static_cast<event_kind>(data.index()); }
+};
+
+/*! \brief The midi, OSC and parameter events of a cycle in one sorted list.
+ *
+ * Filters get midi from midi::parse_midi_batch, OSC from osc::packets and
+ * parameter changes from property::MidiBindings or property::OscParameters,
+ * every one in its own shape. The timeline collects all of them in the
+ * process callback and hands them out ordered by sample offset, so one
+ * render loop, e.g. Timeline::render, can split the cycle at every event.
+ *
+ * Events are stored in the order they are added, with a 64 bit key of offset
+ * and position per event. Only the keys are sorted, which keeps events with
+ * the same offset in the order they were added. Nothing is allocated, events
+ * beyond `CAPACITY` are dropped and counted.
+ *
+ * \tparam CAPACITY The maximum number of events per cycle.
+ */
+template <std::size_t CAPACITY = 256> class Timeline {
+public:
+  static_assert(CAPACITY > 0 && CAPACITY <= 0xffffffff);
+
+  /*! \brief Remove all events, called at the start of every cycle. */
+  void clear() {
+    count = 0;
+    sorted = true;
+  }
+
+  /*! \brief Add a midi message.
+   *
+   * \return False if the timeline is full.
+   */
+  bool add(const uint32_t offset, const midi::message &message) {
+    return insert(offset, message);
+  }
+
+  bool add(const midi::timed_message &message) {
+    return insert(message.offset, message.message);
+  }
+
+  /*! \brief Add an OSC message, bundles are not added.
+   *
+   * \return False if the timeline is full or the packet is a bundle.
+   */
+  bool add(const uint32_t offset, const OSCPP::Server::Packet &packet) {
+    if (!packet.isMessage()) {
+      return false;
+    }
+    return insert(offset, timeline_osc{packet.data(), packet.size()});
+  }
+
+  bool add(const osc::timed_packet &packet) {
+    return add(packet.offset, packet.packet);
+  }
+
+  /*! \brief Add a parameter change, e.g. from the callback of
+   * property::OscParameters::process.
+   *
+   * \return False if the timeline is full.
+   */
+  bool add(const property::parameter_change &change) {
+    return insert(change.offset, timeline_parameter{change.slot, change.value});
+  }
+
+  /*! \brief Add all events of a range.
+   *
+   * \param events Any element type Timeline::add accepts, or the
+   * `std::optional` values of midi::parse_midi and osc::parse_osc, which are
+   * added at offset 0.
+   *
+   * \return The number of added events.
+   */
+  template <std::ranges::input_range R> std::size_t add_all(R &&events) {
+    std::size_t added(0);
+    for (const auto &element : events) {
+      using T = std::decay_t<decltype(element)>;
+      if constexpr (std::is_same_v<T, std::optional<midi::message>> ||
+                    std::is_same_v<T, std::optional<OSCPP::Server::Packet>>) {
+        if (element.has_value() && add(0, element.value())) {
+          added++;
+        }
+      } else if (add(element)) {
+        added++;
+      }
+    }
+    return added;
+  }
+
+  /*! \brief The events ordered by offset, valid until the next change. */
+  auto events() {
+    sort();
+    return std::span<const uint64_t>(keys.data(), count) |
+           std::views::transform(
+               [this](const uint64_t key) -> const timeline_event & {
+                 return storage[key & position_mask];
+               });
+  }
+
+  /*! \brief Render a cycle in blocks between the events.
+   *
+   * Before the block that starts at an event's offset, the event is handed
+   * to `handle`. Events at or after `samples` are handled after the last
+   * block. Blocks are never empty.
+   *
+   * \param samples The number of samples of the cycle.
+   * \param handle Called with every `const timeline_event &` in order.
+   * \param render Called with the first and one past the last sample of
+   * every block.
+   */
+  template <typename H, typename R>
+  void render(const uint32_t samples, H &&handle, R &&render) {
+    uint32_t position(0);
+    for (const auto &event : events()) {
+      const auto offset = std::min(event.offset, samples);
+      if (offset > position) {
+        render(position, offset);
+        position = offset;
+      }
+      handle(event);
+    }
+    if (position < samples) {
+      render(position, samples);
+    }
+  }
+
+  [[nodiscard]] std::size_t size() const { return count; }
+
+  [[nodiscard]] bool empty() const { return count == 0; }
+
+  [[nodiscard]] static constexpr std::size_t capacity() { return CAPACITY; }
+
+  /*! \brief The number of events dropped because the timeline was full,
+   * over all cycles. */
+  [[nodiscard]] std::size_t dropped() const { return dropped_events; }
+
+private:
+  static constexpr uint64_t position_mask = 0xffffffff;
+
+  template <typename T> bool insert(const uint32_t offset, const T &data) {
+    if (count >= CAPACITY) {
+      dropped_events++;
+      return false;
+    }
+
+    const uint64_t key = (static_cast<uint64_t>(offset) << 32) | count;
+    if (count > 0 && key < keys[count - 1]) {
+      sorted = false;
+    }
+    storage[count] = {data, offset};
+    keys[count] = key;
+    count++;
+    return true;
+  }
+
+  void sort() {
+    if (!sorted) {
+      std::sort(keys.begin(), keys.begin() + count);
+      sorted = true;
+    }
+  }
+
+  std::array<timeline_event, CAPACITY> storage;
+  std::array<uint64_t, CAPACITY> keys;
+  std::size_t count = 0;
+  bool sorted = true;
+  std::size_t dropped_events = 0;
+};
+
+} // namespace pwcpp
@@ -0,0 +1,291 @@
+#pragma once
+
+#include "pwcpp/error.h"
+#include "pwcpp/midi/write_midi.h"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <expected>
+#include <span>
+
+#include <spa/node/io.h>
+
+namespace pwcpp {
+
+/*! \brief The state of the transport of the graph. */
+enum class transport_state {
+  STOPPED,
+  STARTING,
+  RUNNING,
+};
+
+/*! \brief The position of the transport at the first sample of a cycle. */
+struct transport_position {
+  transport_state state = transport_state::STOPPED;
+  /*! \brief The sample rate of the clock, 0 if unknown. */
+  uint32_t sample_rate = 0;
+  /*! \brief The number of samples of the cycle. */
+  uint32_t samples = 0;
+  /*! \brief The position on the timeline is known. */
+  bool frame_valid = false;
+  /*! \brief The position on the timeline in samples. */
+  uint64_t frame = 0;
+  /*! \brief The active segment loops. */
+  bool looping = false;
+  /*! \brief The tempo and beat fields are known. */
+  bool bar_valid = false;
+  double bpm = 0.0;
+  float signature_num = 4.0f;
+  float signature_denom = 4.0f;
+  /*! \brief The beat since the start of the timeline, in units of the
+   * signature denominator. */
+  double beat = 0.0;
+  /*! \brief The bar, counted from 0. */
+  uint64_t bar = 0;
+  /*! \brief The beat within the bar, counted from 0. */
+  double beat_in_bar = 0.0;
+};
+
+/*! \brief Derives the musical position and midi clock from
+ * `spa_io_position`.
+ *
+ * Transport::update is called once at the start of every process callback.
+ * It selects the segment of `position->segments` that contains the current
+ * running time, computes tempo, bar and beat at the first sample of the cycle
+ * and the sample offsets of the 24 PPQN midi clock ticks within the cycle.
+ *
+ * Ticks are counted continuously across cycles, so rounding never drops or
+ * repeats a tick. A jump of the position while running, e.g. a loop or a
+ * relocation, is reported as relocated.
+ */
+class Transport {
+public:
+  /*! \brief Midi clock ticks per quarter note. */
+  static constexpr uint32_t ticks_per_quarter = 24;
+
+  /*! \brief Update the position for a new cycle.
+   *
+   * \param position The position passed to the process callback, may be
+   * null.
+   *
+   * \return The position at the first sample of the cycle.
+   */
+  const transport_position &update(const spa_io_position *position) {
+    const bool was_running = clock_running;
+    current = {};
+    first_tick = next_tick;
+    tick_count = 0;
+    started = false;
+    stopped = false;
+    relocated = false;
+
+    if (position != nullptr) {
+      read_position(*position);
+    }
+
+    clock_running =
+        current.state == transport_state::RUNNING && current.bar_valid &&
+        current.sample_rate > 0;
+    if (!clock_running) {
+      stopped = was_running;
+      return current;
+    }
+
+    const double start = quarter_notes(current.beat) * ticks_per_quarter;
+    if (!was_running || std::abs(start - expected_tick) > 0.5) {
+      started = !was_running;
+      relocated = was_running;
+      next_tick = static_cast<int64_t>(std::ceil(start - 1e-9));
+    }
+
+    const double end = start + ticks_per_sample * current.samples;
+    const auto last = static_cast<int64_t>(std::ceil(end - 1e-9));
+    first_tick = next_tick;
+    tick_count = last > next_tick ? static_cast<uint32_t>(last - next_tick) : 0;
+    next_tick += tick_count;
+    tick_start = start;
+    expected_tick = end;
+
+    return current;
+  }
+
+  /*! \brief The position of the last update. */
+  [[nodiscard]] const transport_position &position() const { return current; }
+
+  /*! \brief The beat at a sample offset of the cycle. */
+  [[nodiscard]] double beat_at(const uint32_t offset) const {
+    if (!current.bar_valid || current.sample_rate == 0) {
+      return current.beat;
+    }
+    return current.beat + beats_per_sample * offset;
+  }
+
+  /*! \brief The transport started running in this cycle. */
+  [[nodiscard]] bool has_started() const { return started; }
+
+  /*! \brief The transport stopped in this cycle. */
+  [[nodiscard]] bool has_stopped() const { return stopped; }
+
+  /*! \brief The position jumped while running in this cycle. */
+  [[nodiscard]] bool has_relocated() const { return relocated; }
+
+  /*! \brief Visit the midi clock ticks of the cycle.
+   *
+   * \param f Called with the sample offset and the number of the tick since
+   * the start of the timeline.
+   */
+  template <typename F> void for_each_clock_tick(F &&f) const {
+    for (uint32_t i = 0; i < tick_count; ++i) {
+      const auto tick = first_tick + i;
+      const double offset = (tick - tick_start) / ticks_per_sample;
+      f(clamp_offset(offset), static_cast<uint64_t>(tick));
+    }
+  }
+
+  /*! \brief Write the midi clock of the cycle.
+   *
+   * Writes start, or song position pointer and continue, when the transport
+   * starts, stop when it stops and stop, song position pointer and continue
+   * when it relocates, followed by the clock ticks of the cycle. The song
+   * position pointer has a resolution of 6 ticks and is rounded down.
+   *
+   * \return The first error of the writer, the messages written up to that
+   * point are kept.
+   */
+  std::expected<void, error> write_clock(midi::MidiWriter &writer) const {
+    if (stopped || relocated) {
+      if (auto result = write_byte(writer, 0, 0xfc); !result.has_value()) {
+        return result;
+      }
+    }
+
+    if (started || relocated) {
+      if (first_tick <= 0) {
+        if (auto result = write_byte(writer, 0, 0xfa); !result.has_value()) {
+          return result;
+        }
+      } else {
+        const auto beats = static_cast<uint32_t>(first_tick / 6) & 0x3fff;
+        const std::array<uint8_t, 3> pointer{
+            0xf2, static_cast<uint8_t>(beats & 0x7f),
+            static_cast<uint8_t>(beats >> 7)};
+        if (auto result = writer.write_system(0, pointer); !result.has_value()) {
+          return result;
+        }
+        if (auto result = write_byte(writer, 0, 0xfb); !result.has_value()) {
+          return result;
+        }
+      }
+    }
+
+    std::expected<void, error> result;
+    for_each_clock_tick([&](const uint32_t offset, uint64_t) {
+      if (result.has_value()) {
+        result = write_byte(writer, offset, 0xf8);
+      }
+    });
+    return result;
+  }
+
+private:
+  void read_position(const spa_io_position &position) {
+    const auto &clock = position.clock;
+    current.sample_rate =
+        clock.rate.num != 0 ? clock.rate.denom / clock.rate.num : 0;
+    current.samples = static_cast<uint32_t>(clock.duration);
+    switch (position.state) {
+    case SPA_IO_POSITION_STATE_STARTING:
+      current.state = transport_state::STARTING;
+      break;
+    case SPA_IO_POSITION_STATE_RUNNING:
+      current.state = transport_state::RUNNING;
+      break;
+    default:
+      current.state = transport_state::STOPPED;
+      break;
+    }
+
+    const auto running = static_cast<int64_t>(clock.position) - position.offset;
+    const spa_io_segment *segment = nullptr;
+    for (uint32_t i = 0; i < position.n_segments && i < SPA_IO_POSITION_MAX_SEGMENTS;
+         ++i) {
+      const auto &s = position.segments[i];
+      if (running >= static_cast<int64_t>(s.start) &&
+          (s.duration == 0 ||
+           running < static_cast<int64_t>(s.start + s.duration))) {
+        segment = &s;
+        break;
+      }
+    }
+    if (segment == nullptr) {
+      return;
+    }
+
+    const double elapsed =
+        static_cast<double>(running - static_cast<int64_t>(segment->start)) *
+        segment->rate;
+    current.looping = (segment->flags & SPA_IO_SEGMENT_FLAG_LOOPING) != 0;
+    if ((segment->flags & SPA_IO_SEGMENT_FLAG_NO_POSITION) == 0) {
+      current.frame_valid = true;
+      current.frame = segment->position + static_cast<uint64_t>(elapsed);
+    }
+
+    const auto &bar = segment->bar;
+    if ((bar.flags & SPA_IO_SEGMENT_BAR_FLAG_VALID) == 0 || bar.bpm <= 0.0 ||
+        bar.signature_num <= 0.0f || bar.signature_denom <= 0.0f ||
+        current.sample_rate == 0) {
+      return;
+    }
+
+    current.bar_valid = true;
+    current.bpm = bar.bpm;
+    current.signature_num = bar.signature_num;
+    current.signature_denom = bar.signature_denom;
+
+    // The beat of the bar is valid at bar.offset samples into the segment.
+    beats_per_sample = bar.bpm / 60.0 / current.sample_rate * segment->rate;
+    ticks_per_sample = quarter_notes(beats_per_sample) * ticks_per_quarter;
+    current.beat = bar.beat + (elapsed - bar.offset) * bar.bpm / 60.0 /
+                                  current.sample_rate;
+    if (current.beat < 0.0) {
+      current.beat = 0.0;
+    }
+    const double bars = std::floor(current.beat / bar.signature_num);
+    current.bar = static_cast<uint64_t>(bars);
+    current.beat_in_bar = current.beat - bars * bar.signature_num;
+  }
+
+  [[nodiscard]] double quarter_notes(const double beats) const {
+    return beats * 4.0 / current.signature_denom;
+  }
+
+  [[nodiscard]] uint32_t clamp_offset(const double offset) const {
+    if (offset <= 0.0 || current.samples == 0) {
+      return 0;
+    }
+    const auto sample = static_cast<uint32_t>(offset);
+    return sample < current.samples ? sample : current.samples - 1;
+  }
+
+  static std::expected<void, error>
+  write_byte(midi::MidiWriter &writer, const uint32_t offset,
+             const uint8_t status) {
+    return writer.write_system(offset, std::span<const uint8_t>(&status, 1));
+  }
+
+  transport_position current;
+  double beats_per_sample = 0.0;
+  double ticks_per_sample = 0.0;
+  bool clock_running = false;
+  bool started = false;
+  bool stopped = false;
+  bool relocated = false;
+  int64_t next_tick = 0;
+  int64_t first_tick = 0;
+  uint32_t tick_count = 0;
+  double tick_start = 0.0;
+  double expected_tick = 0.0;
+};
+
+} // namespace pwcpp
@@ -0,0 +1,78 @@
+#include "pwcpp/buffer.h"
+#include "pwcpp/midi/parse_midi.h"
+#include "pwcpp/midi/parse_ump_batch.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+
+#include <spa/control/control.h>
+#include <spa/pod/builder.h>
+
+constexpr std::size_t message_count = 512;
+constexpr std::size_t iterations = 20000;
+
+template <typename F> double nanoseconds_per_iteration(F &&f) {
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < iterations; ++i) {
+    f();
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / iterations;
+}
+
+int main() {
+  static uint8_t pod_buffer[32768];
+  struct spa_pod_builder builder;
+  spa_pod_builder_init(&builder, pod_buffer, sizeof(pod_buffer));
+  struct spa_pod_frame frame;
+  spa_pod_builder_push_sequence(&builder, &frame, 0);
+  for (std::size_t i = 0; i < message_count; ++i) {
+    // A controller sweep on two channels with some MIDI 1.0 UMP in between.
+    uint32_t header = (i % 5 == 0 ? 0x20b00000 : 0x40b00000) |
+                      static_cast<uint32_t>(i & 1) << 16 | 74 << 8;
+    uint32_t ump[2] = {header, static_cast<uint32_t>(i) << 23};
+    spa_pod_builder_control(&builder, i, SPA_CONTROL_UMP);
+    spa_pod_builder_bytes(&builder, ump, sizeof(ump));
+  }
+  auto pod = static_cast<spa_pod *>(spa_pod_builder_pop(&builder, &frame));
+
+  pwcpp::Buffer buffer([](pw_buffer *, struct pwcpp::filter::port *) {},
+                       [pod](pw_buffer *, size_t) -> std::optional<spa_pod *> {
+                         return pod;
+                       });
+
+  std::size_t checksum(0);
+  auto scalar = nanoseconds_per_iteration([&] {
+    auto messages = pwcpp::midi::parse_midi<message_count>(buffer);
+    checksum += messages.has_value() && messages.value()[0].has_value();
+  });
+
+  std::array<pwcpp::midi::timed_message, message_count> batch_messages;
+  auto batch = nanoseconds_per_iteration([&] {
+    auto count = pwcpp::midi::parse_midi_batch(buffer, batch_messages);
+    checksum += count.value_or(0);
+  });
+
+  pwcpp::midi::ump_64_batch<message_count> gathered;
+  pwcpp::midi::gather_ump_64(reinterpret_cast<spa_pod_sequence *>(pod),
+                             gathered);
+  std::span<const uint32_t> headers(gathered.headers.data(), gathered.size);
+  std::array<uint32_t, message_count> selected;
+  auto classify_scalar = nanoseconds_per_iteration([&] {
+    checksum += pwcpp::midi::detail::classify_ump_64_scalar(headers, selected);
+  });
+  auto classify_vector = nanoseconds_per_iteration([&] {
+    checksum += pwcpp::midi::classify_ump_64(headers, selected);
+  });
+
+  std::cout << message_count << " messages per sequence" << std::endl;
+  std::cout << "parse_midi:            " << scalar << " ns" << std::endl;
+  std::cout << "parse_midi_batch:      " << batch << " ns" << std::endl;
+  std::cout << "classify (scalar):     " << classify_scalar << " ns" << std::endl;
+  std::cout << "classify (vectorized): " << classify_vector << " ns" << std::endl;
+  std::cout << "checksum " << checksum << std::endl;
+}
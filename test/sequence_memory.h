@@ -0,0 +1,52 @@
+#pragma once
+
+#include "pwcpp/buffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include <spa/buffer/buffer.h>
+#include <spa/pod/iter.h>
+
+/*! \brief Memory for a sequence, handed out like the buffer of a port.
+ *
+ * \tparam SIZE The number of bytes of the memory.
+ */
+template <std::size_t SIZE = 1024> struct sequence_memory {
+  alignas(8) uint8_t data[SIZE];
+  struct spa_chunk chunk{};
+
+  /*! \brief The spa data of the memory, e.g. for a writer.
+   *
+   * \param maxsize The usable number of bytes, to simulate a smaller
+   * buffer.
+   */
+  struct spa_data spa_data(const uint32_t maxsize = SIZE) {
+    struct spa_data d{};
+    d.data = data;
+    d.maxsize = maxsize;
+    d.chunk = &chunk;
+    return d;
+  }
+
+  /*! \brief The written sequence. */
+  const struct spa_pod_sequence *sequence() {
+    return static_cast<const struct spa_pod_sequence *>(
+        spa_pod_from_data(data, SIZE, chunk.offset, chunk.size));
+  }
+
+  /*! \brief A buffer over the memory, e.g. to parse what was written. */
+  pwcpp::Buffer buffer(const uint32_t maxsize = SIZE) {
+    return pwcpp::Buffer(
+        [](pw_buffer *, struct pwcpp::filter::port *) {},
+        [this](pw_buffer *, size_t) -> std::optional<spa_pod *> {
+          return static_cast<spa_pod *>(
+              spa_pod_from_data(data, SIZE, chunk.offset, chunk.size));
+        },
+        [this, maxsize](pw_buffer *,
+                        std::size_t) -> std::optional<struct spa_data> {
+          return spa_data(maxsize);
+        });
+  }
+};
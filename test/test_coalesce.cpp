@@ -0,0 +1,95 @@
+#include "pwcpp/midi/coalesce.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <microtest/microtest.h>
+
+namespace {
+std::vector<pwcpp::midi::timed_message> sweep() {
+  return {
+      {0, pwcpp::midi::control_change{0, 7, 1}},
+      {1, pwcpp::midi::note_on{0, 60, 100}},
+      {2, pwcpp::midi::control_change{0, 7, 2}},
+      {3, pwcpp::midi::control_change{1, 7, 9}},
+      {4, pwcpp::midi::pitch_bend{0, 5}},
+      {5, pwcpp::midi::control_change{0, 7, 3}},
+      {6, pwcpp::midi::pitch_bend{0, 6}},
+      {7, pwcpp::midi::note_off{0, 60, 0}},
+  };
+}
+} // namespace
+
+TEST(KeepsLastControllerValues) {
+  pwcpp::midi::Coalescer coalescer;
+  auto messages = sweep();
+  messages.resize(coalescer.coalesce(messages));
+
+  const std::vector<pwcpp::midi::timed_message> expected{
+      {1, pwcpp::midi::note_on{0, 60, 100}},
+      {3, pwcpp::midi::control_change{1, 7, 9}},
+      {5, pwcpp::midi::control_change{0, 7, 3}},
+      {6, pwcpp::midi::pitch_bend{0, 6}},
+      {7, pwcpp::midi::note_off{0, 60, 0}},
+  };
+  ASSERT_TRUE(messages == expected);
+
+  // The next cycle starts with an empty table.
+  auto next = sweep();
+  const auto kept = coalescer.coalesce(next);
+  ASSERT_EQ(kept, 5);
+}
+
+TEST(KeepsFirstAndLastControllerValues) {
+  pwcpp::midi::Coalescer coalescer(pwcpp::midi::coalesce_mode::FIRST_AND_LAST);
+  auto messages = sweep();
+  messages.resize(coalescer.coalesce(messages));
+
+  ASSERT_EQ(messages.size(), 7);
+  ASSERT_TRUE(messages[0] ==
+              (pwcpp::midi::timed_message{0, pwcpp::midi::control_change{0, 7, 1}}));
+  ASSERT_TRUE(messages[4] ==
+              (pwcpp::midi::timed_message{5, pwcpp::midi::control_change{0, 7, 3}}));
+}
+
+TEST(LimitsRateAndSendsPendingValues) {
+  pwcpp::midi::RateLimiter limiter(10);
+  std::array<pwcpp::midi::timed_message, 8> out;
+
+  const std::array<pwcpp::midi::timed_message, 3> first{
+      pwcpp::midi::timed_message{0, pwcpp::midi::control_change{0, 7, 1}},
+      pwcpp::midi::timed_message{2, pwcpp::midi::control_change{0, 7, 2}},
+      pwcpp::midi::timed_message{3, pwcpp::midi::note_on{0, 60, 1}}};
+  auto written = limiter.limit(0, first, out);
+  ASSERT_EQ(written, 2);
+  ASSERT_TRUE(out[0] == first[0]);
+  ASSERT_TRUE(out[1] == first[2]);
+
+  // The interval hasn't elapsed at the start of the next cycle.
+  written = limiter.limit(8, {}, out);
+  ASSERT_EQ(written, 0);
+
+  written = limiter.limit(16, {}, out);
+  ASSERT_EQ(written, 1);
+  ASSERT_TRUE(out[0] ==
+              (pwcpp::midi::timed_message{0, pwcpp::midi::control_change{0, 7, 2}}));
+  written = limiter.limit(24, {}, out);
+  ASSERT_EQ(written, 0);
+}
+
+TEST(ConfiguresIntervalsPerController) {
+  pwcpp::midi::RateLimiter limiter(100);
+  limiter.set_control_change_interval(0, 1, 0);
+  std::array<pwcpp::midi::timed_message, 8> out;
+
+  const std::array<pwcpp::midi::timed_message, 4> messages{
+      pwcpp::midi::timed_message{0, pwcpp::midi::control_change{0, 1, 1}},
+      pwcpp::midi::timed_message{1, pwcpp::midi::control_change{0, 1, 2}},
+      pwcpp::midi::timed_message{2, pwcpp::midi::control_change{0, 2, 1}},
+      pwcpp::midi::timed_message{3, pwcpp::midi::control_change{0, 2, 2}}};
+  const auto written = limiter.limit(0, messages, out);
+  ASSERT_EQ(written, 3);
+}
+
+TEST_MAIN()
@@ -0,0 +1,84 @@
+#include "pwcpp/midi/controller_state.h"
+
+#include <array>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include <microtest/microtest.h>
+
+using controller_state = pwcpp::midi::ControllerState<8>;
+
+TEST(KeepsControllerValues) {
+  controller_state state;
+  state.update(pwcpp::midi::control_change{3, 7, 0x12345678});
+  state.update(pwcpp::midi::note_on{3, 7, 0xffff});
+
+  ASSERT_EQ(state.value(3, 7), 0x12345678);
+  ASSERT_EQ(state.value(2, 7), 0);
+  ASSERT_TRUE(state.received(3, 7));
+  ASSERT_FALSE(state.received(3, 8));
+}
+
+TEST(PairsMsbAndLsb) {
+  controller_state state;
+  state.update(pwcpp::midi::control_change{0, 1, 0x80000000});
+  ASSERT_EQ(state.value_14_bit(0, 1), 0x2000);
+
+  state.update(pwcpp::midi::control_change{0, 33, 0x02000000});
+  ASSERT_EQ(state.value_14_bit(0, 1), 0x2001);
+
+  // A new MSB without LSB uses the resolution of the MSB value.
+  state.update(pwcpp::midi::control_change{0, 1, 0xffffffff});
+  ASSERT_EQ(state.value_14_bit(0, 1), 0x3fff);
+}
+
+TEST(VisitsDirtyControllersOnce) {
+  controller_state state;
+  const std::array<pwcpp::midi::timed_message, 3> messages{
+      pwcpp::midi::timed_message{0, pwcpp::midi::control_change{5, 100, 1}},
+      pwcpp::midi::timed_message{1, pwcpp::midi::control_change{1, 2, 3}},
+      pwcpp::midi::timed_message{2, pwcpp::midi::control_change{1, 2, 4}}};
+  state.update(messages);
+
+  std::vector<std::tuple<int, int, uint32_t>> visited;
+  state.for_each_dirty([&](uint8_t channel, uint8_t cc_number, uint32_t value) {
+    visited.emplace_back(channel, cc_number, value);
+  });
+
+  ASSERT_EQ(visited.size(), 2);
+  ASSERT_TRUE((visited[0] == std::tuple<int, int, uint32_t>{1, 2, 4}));
+  ASSERT_TRUE((visited[1] == std::tuple<int, int, uint32_t>{5, 100, 1}));
+  ASSERT_FALSE(state.dirty(1, 2));
+
+  visited.clear();
+  state.for_each_dirty([&](uint8_t channel, uint8_t cc_number, uint32_t value) {
+    visited.emplace_back(channel, cc_number, value);
+  });
+  ASSERT_TRUE(visited.empty());
+}
+
+TEST(KeepsParameters) {
+  controller_state state;
+  using parameter_type = controller_state::parameter_type;
+  state.update(pwcpp::midi::registered_controller{2, 0, 1, 42});
+  state.update(pwcpp::midi::assignable_controller{2, 0, 1, 43});
+  state.update(pwcpp::midi::registered_controller{2, 0, 1, 44});
+
+  ASSERT_EQ(state.parameter(parameter_type::REGISTERED, 2, 0, 1).value(), 44);
+  ASSERT_EQ(state.parameter(parameter_type::ASSIGNABLE, 2, 0, 1).value(), 43);
+  ASSERT_FALSE(state.parameter(parameter_type::REGISTERED, 3, 0, 1).has_value());
+
+  for (uint8_t index = 10; index < 20; ++index) {
+    state.update(pwcpp::midi::registered_controller{0, 1, index, index});
+  }
+  ASSERT_EQ(state.dropped_parameters(), 3);
+
+  std::size_t visited(0);
+  state.for_each_dirty_parameter(
+      parameter_type::REGISTERED,
+      [&](uint8_t, uint8_t, uint8_t, uint32_t) { visited++; });
+  ASSERT_EQ(visited, 8);
+}
+
+TEST_MAIN()
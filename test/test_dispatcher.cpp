@@ -0,0 +1,164 @@
+#include "pwcpp/error.h"
+#include "pwcpp/osc/dispatcher.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <oscpp/client.hpp>
+#include <oscpp/server.hpp>
+
+#include <microtest/microtest.h>
+
+namespace {
+struct message_memory {
+  OSCPP::Client::StaticPacket<128> packet;
+
+  message_memory() = default;
+
+  /*! A message without arguments. */
+  explicit message_memory(const char *address) {
+    packet.openMessage(address, 0).closeMessage();
+  }
+
+  OSCPP::Server::Message message() const {
+    return OSCPP::Server::Packet(packet.data(), packet.size());
+  }
+};
+} // namespace
+
+TEST(MatchesWildcards) {
+  pwcpp::osc::Dispatcher dispatcher;
+  auto ignore = [] {};
+  ASSERT_TRUE(dispatcher.on("/mixer/*/gain", ignore).has_value());
+  ASSERT_TRUE(dispatcher.on("/fx/?/wet", ignore).has_value());
+  ASSERT_TRUE(dispatcher.on("/track/[1-4]/mute", ignore).has_value());
+  ASSERT_TRUE(dispatcher.on("/track/[!1-4]/solo", ignore).has_value());
+  ASSERT_TRUE(dispatcher.on("/{play,stop}", ignore).has_value());
+  ASSERT_TRUE(dispatcher.compile().has_value());
+
+  ASSERT_TRUE(dispatcher.matches("/mixer/drums/gain"));
+  ASSERT_TRUE(dispatcher.matches("/mixer//gain"));
+  ASSERT_FALSE(dispatcher.matches("/mixer/a/b/gain"));
+  ASSERT_TRUE(dispatcher.matches("/fx/1/wet"));
+  ASSERT_FALSE(dispatcher.matches("/fx/12/wet"));
+  ASSERT_TRUE(dispatcher.matches("/track/3/mute"));
+  ASSERT_FALSE(dispatcher.matches("/track/5/mute"));
+  ASSERT_TRUE(dispatcher.matches("/track/5/solo"));
+  ASSERT_FALSE(dispatcher.matches("/track/2/solo"));
+  ASSERT_TRUE(dispatcher.matches("/play"));
+  ASSERT_TRUE(dispatcher.matches("/stop"));
+  ASSERT_FALSE(dispatcher.matches("/pause"));
+  ASSERT_FALSE(dispatcher.matches("/play/now"));
+}
+
+TEST(RejectsInvalidPatterns) {
+  pwcpp::osc::Dispatcher dispatcher;
+  auto ignore = [] {};
+  for (const char *pattern : {"gain", "/a/[b", "/a/{b,c", "/a/b}", "/[]"}) {
+    auto result = dispatcher.on(pattern, ignore);
+    ASSERT_FALSE(result.has_value());
+    ASSERT_TRUE(result.error().type ==
+                pwcpp::error_type::OSC_INVALID_ADDRESS_PATTERN);
+  }
+}
+
+TEST(CallsAllMatchingHandlersWithUnpackedArguments) {
+  pwcpp::osc::Dispatcher dispatcher;
+  std::vector<std::string> calls;
+  dispatcher.on<float>("/synth/*/cutoff", [&calls](float value) {
+    calls.push_back("any " + std::to_string(static_cast<int>(value)));
+  });
+  dispatcher.on_timed<int32_t, const char *>(
+      "/synth/lead/cutoff",
+      [&calls](uint32_t offset, int32_t value, const char *unit) {
+        calls.push_back("lead " + std::to_string(offset) + " " +
+                        std::to_string(value) + " " + unit);
+      });
+  ASSERT_TRUE(dispatcher.compile().has_value());
+
+  message_memory memory;
+  memory.packet.openMessage("/synth/lead/cutoff", 2)
+      .float32(439.75f)
+      .string("hz")
+      .closeMessage();
+  auto called = dispatcher.dispatch(memory.message(), 12);
+  ASSERT_EQ(called, 2);
+  // The float is rounded for the int handler.
+  ASSERT_TRUE((calls == std::vector<std::string>{"any 439", "lead 12 440 hz"}));
+}
+
+TEST(CountsUnmatchedAndMismatchedMessages) {
+  pwcpp::osc::Dispatcher dispatcher;
+  int calls = 0;
+  dispatcher.on<const char *>("/name", [&calls](const char *) { calls++; });
+  ASSERT_TRUE(dispatcher.compile().has_value());
+
+  message_memory number;
+  number.packet.openMessage("/name", 1).int32(1).closeMessage();
+  auto called = dispatcher.dispatch(number.message());
+  ASSERT_EQ(called, 0);
+  ASSERT_EQ(dispatcher.mismatched(), 1);
+
+  const message_memory missing("/name");
+  called = dispatcher.dispatch(missing.message());
+  ASSERT_EQ(called, 0);
+  ASSERT_EQ(dispatcher.mismatched(), 2);
+
+  const message_memory other("/other");
+  called = dispatcher.dispatch(other.message());
+  ASSERT_EQ(called, 0);
+  ASSERT_EQ(dispatcher.unmatched(), 1);
+  ASSERT_EQ(calls, 0);
+}
+
+TEST(ScalesToManyAddresses) {
+  pwcpp::osc::Dispatcher dispatcher;
+  int matched = -1;
+  for (int i = 0; i < 300; ++i) {
+    const auto pattern = "/filter/parameter" + std::to_string(i);
+    dispatcher.on(pattern, [&matched, i] { matched = i; });
+  }
+  ASSERT_TRUE(dispatcher.compile().has_value());
+  ASSERT_TRUE(dispatcher.states() < 400);
+
+  const message_memory message("/filter/parameter217");
+  auto called = dispatcher.dispatch(message.message());
+  ASSERT_EQ(called, 1);
+  ASSERT_EQ(matched, 217);
+}
+
+TEST(LimitsTheNumberOfStates) {
+  pwcpp::osc::Dispatcher dispatcher;
+  dispatcher.on("/*a*b*c*d", [] {});
+  dispatcher.on("/*d*c*b*a", [] {});
+  auto result = dispatcher.compile(4);
+  ASSERT_FALSE(result.has_value());
+  ASSERT_TRUE(result.error().type == pwcpp::error_type::OSC_PATTERNS_TOO_COMPLEX);
+  ASSERT_FALSE(dispatcher.matches("/xaxbxcxd"));
+}
+
+TEST(KeepsTheAutomatonWhenCompilingFails) {
+  pwcpp::osc::Dispatcher dispatcher;
+  int calls(0);
+  dispatcher.on("/ok", [&calls] { calls++; });
+  ASSERT_TRUE(dispatcher.compile().has_value());
+  const auto states = dispatcher.states();
+
+  dispatcher.on("/*a*b*c*d", [] {});
+  dispatcher.on("/*d*c*b*a", [] {});
+  ASSERT_FALSE(dispatcher.compile(4).has_value());
+  ASSERT_EQ(dispatcher.states(), states);
+
+  const message_memory ok("/ok");
+  const message_memory complex("/xaxbxcxd");
+  ASSERT_TRUE(dispatcher.matches("/ok"));
+  ASSERT_FALSE(dispatcher.matches("/xaxbxcxd"));
+  const auto called = dispatcher.dispatch(ok.message());
+  ASSERT_EQ(called, 1);
+  const auto not_called = dispatcher.dispatch(complex.message());
+  ASSERT_EQ(not_called, 0);
+  ASSERT_EQ(calls, 1);
+}
+
+TEST_MAIN()
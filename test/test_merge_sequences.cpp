@@ -0,0 +1,92 @@
+#include "pwcpp/buffer.h"
+#include "pwcpp/spa/pod/merge_sequences.h"
+#include "pwcpp/spa/pod/sequence_writer.h"
+#include "sequence_memory.h"
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include <spa/control/control.h>
+#include <spa/pod/iter.h>
+
+#include <microtest/microtest.h>
+
+namespace {
+/*! Writes one control per offset, the body is the value. */
+struct control_memory : sequence_memory<> {
+  void write(std::initializer_list<std::pair<uint32_t, uint32_t>> controls) {
+    pwcpp::spa::pod::SequenceWriter writer(spa_data());
+    for (auto [offset, value] : controls) {
+      writer.write(offset, SPA_CONTROL_UMP, &value, sizeof(value));
+    }
+    writer.finish();
+  }
+};
+
+uint32_t body_value(const struct spa_pod_control *control) {
+  return *static_cast<const uint32_t *>(SPA_POD_BODY_CONST(&control->value));
+}
+} // namespace
+
+TEST(MergesInOffsetOrder) {
+  std::array<control_memory, 3> memory;
+  memory[0].write({{0, 1}, {5, 2}, {5, 3}, {9, 4}});
+  memory[1].write({{2, 10}, {5, 11}});
+  memory[2].write({});
+
+  const std::array<const struct spa_pod_sequence *, 3> sequences{
+      memory[0].sequence(), memory[1].sequence(), memory[2].sequence()};
+  std::vector<std::pair<std::size_t, uint32_t>> merged;
+  auto count = pwcpp::spa::pod::merge_sequences<4>(
+      sequences, [&](const pwcpp::spa::pod::merged_control &control) {
+        merged.emplace_back(control.input, body_value(control.control));
+      });
+
+  ASSERT_TRUE(count.has_value());
+  ASSERT_EQ(count.value(), 6);
+  const std::vector<std::pair<std::size_t, uint32_t>> expected{
+      {0, 1}, {1, 10}, {0, 2}, {0, 3}, {1, 11}, {0, 4}};
+  ASSERT_TRUE(merged == expected);
+}
+
+TEST(MergingTooManySequencesFails) {
+  std::array<control_memory, 3> memory;
+  for (auto &m : memory) {
+    m.write({{0, 0}});
+  }
+  const std::array<const struct spa_pod_sequence *, 3> sequences{
+      memory[0].sequence(), memory[1].sequence(), memory[2].sequence()};
+  auto count = pwcpp::spa::pod::merge_sequences<2>(
+      sequences, [](const pwcpp::spa::pod::merged_control &) {});
+  ASSERT_FALSE(count.has_value());
+  ASSERT_TRUE(count.error().type ==
+              pwcpp::error_type::SEQUENCE_MERGING_TOO_MANY_SEQUENCES);
+}
+
+TEST(MergesBuffersIntoOutputSequence) {
+  std::array<control_memory, 2> inputs;
+  inputs[0].write({{1, 1}, {7, 2}});
+  inputs[1].write({{3, 3}});
+  std::array<pwcpp::Buffer, 2> buffers{inputs[0].buffer(), inputs[1].buffer()};
+
+  control_memory output;
+  pwcpp::spa::pod::SequenceWriter writer(output.spa_data());
+  auto count = pwcpp::spa::pod::merge_sequences<2>(buffers, writer);
+  writer.finish();
+  ASSERT_TRUE(count.has_value());
+  ASSERT_EQ(count.value(), 3);
+
+  std::vector<std::pair<uint32_t, uint32_t>> controls;
+  struct spa_pod_control *control;
+  SPA_POD_SEQUENCE_FOREACH(output.sequence(), control) {
+    controls.emplace_back(control->offset, body_value(control));
+  }
+  const std::vector<std::pair<uint32_t, uint32_t>> expected{
+      {1, 1}, {3, 3}, {7, 2}};
+  ASSERT_TRUE(controls == expected);
+}
+
+TEST_MAIN()
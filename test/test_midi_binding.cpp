@@ -0,0 +1,154 @@
+#include "pwcpp/property/midi_binding.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <microtest/microtest.h>
+
+namespace {
+using parameter_list =
+    std::vector<std::tuple<std::string, pwcpp::property::property_value_type>>;
+
+std::shared_ptr<parameter_list> make_parameters() {
+  return std::make_shared<parameter_list>(parameter_list{
+      {"gain", 0.0}, {"cutoff", 0.0}, {"midi.bindings", std::string()}});
+}
+
+std::unique_ptr<pwcpp::property::MidiBindings<4>> make_bindings() {
+  return pwcpp::property::MidiBindings<4>::create(
+             {{"gain", 0.0, 1.0}, {"cutoff", 20.0, 20020.0}}, 2)
+      .value();
+}
+
+template <typename T>
+T parameter(const parameter_list &parameters, const std::string &name) {
+  for (const auto &[key, value] : parameters) {
+    if (key == name) {
+      return std::get<T>(value);
+    }
+  }
+  return T{};
+}
+} // namespace
+
+TEST(DispatchesBoundControllers) {
+  auto bindings = make_bindings();
+  ASSERT_TRUE(bindings->bind({1, 2, 7, 1}).has_value());
+
+  const std::array<pwcpp::midi::timed_message, 3> messages{
+      pwcpp::midi::timed_message{3, pwcpp::midi::control_change{2, 7, 0}},
+      pwcpp::midi::timed_message{4, pwcpp::midi::control_change{2, 8, 0}},
+      pwcpp::midi::timed_message{9, pwcpp::midi::control_change{2, 7, 0xffffffff}}};
+
+  std::vector<pwcpp::property::parameter_change> changes;
+  bindings->process(1, messages, [&](const pwcpp::property::parameter_change &c) {
+    changes.push_back(c);
+  });
+  bindings->process(0, messages, [&](const pwcpp::property::parameter_change &c) {
+    changes.push_back(c);
+  });
+
+  ASSERT_EQ(changes.size(), 2);
+  ASSERT_EQ(changes[0].offset, 3);
+  ASSERT_EQ(changes[0].slot, 1);
+  ASSERT_TRUE(changes[0].value == 20.0);
+  ASSERT_EQ(changes[1].offset, 9);
+  ASSERT_TRUE(changes[1].value == 20020.0);
+}
+
+TEST(SyncsParametersAndPersistsBindings) {
+  auto list = make_parameters();
+  pwcpp::property::ParametersProperty parameters(list);
+  auto bindings = make_bindings();
+  bindings->bind({0, 0, 1, 0});
+
+  const std::array<pwcpp::midi::timed_message, 1> messages{
+      pwcpp::midi::timed_message{0, pwcpp::midi::control_change{0, 1, 0xffffffff}}};
+  bindings->process(0, messages, [](const pwcpp::property::parameter_change &) {});
+
+  ASSERT_TRUE(bindings->sync(parameters).value());
+  ASSERT_TRUE(parameter<double>(*list, "gain") == 1.0);
+  ASSERT_TRUE(parameter<std::string>(*list, "midi.bindings") == "0:0:1:gain");
+  ASSERT_FALSE(bindings->sync(parameters).value());
+
+  auto restored = make_bindings();
+  restored->restore(parameters);
+  ASSERT_EQ(restored->current().size(), 1);
+  ASSERT_TRUE((restored->current()[0] == pwcpp::property::midi_binding{0, 0, 1, 0}));
+}
+
+TEST(KeepsTheTypeOfBoundParameters) {
+  auto list = std::make_shared<parameter_list>(parameter_list{
+      {"steps", 0}, {"bypass", false}, {"midi.bindings", std::string()}});
+  pwcpp::property::ParametersProperty parameters(list);
+  auto bindings = pwcpp::property::MidiBindings<4>::create(
+                      {{"steps", 0.0, 16.0},
+                       {"bypass", 0.0, 1.0},
+                       {"missing", 0.0, 1.0}},
+                      1)
+                      .value();
+  bindings->bind({0, 0, 1, 0});
+  bindings->bind({0, 0, 2, 1});
+
+  // Three quarters of the controller range, 12 steps and on.
+  const std::array<pwcpp::midi::timed_message, 2> messages{
+      pwcpp::midi::timed_message{0, pwcpp::midi::control_change{0, 1, 0xc0000000}},
+      pwcpp::midi::timed_message{0, pwcpp::midi::control_change{0, 2, 0xc0000000}}};
+  bindings->process(0, messages, [](const pwcpp::property::parameter_change &) {});
+
+  ASSERT_TRUE(bindings->sync(parameters).value());
+  ASSERT_EQ(parameter<int>(*list, "steps"), 12);
+  ASSERT_TRUE(parameter<bool>(*list, "bypass"));
+
+  // A slot without a parameter reports the error.
+  bindings->bind({0, 0, 3, 2});
+  const std::array<pwcpp::midi::timed_message, 1> missing{
+      pwcpp::midi::timed_message{0, pwcpp::midi::control_change{0, 3, 0}}};
+  bindings->process(0, missing, [](const pwcpp::property::parameter_change &) {});
+  auto result = bindings->sync(parameters);
+  ASSERT_FALSE(result.has_value());
+  ASSERT_TRUE(result.error().type == pwcpp::error_type::PARAMETER_NOT_FOUND);
+}
+
+TEST(LearnsTheNextController) {
+  auto list = make_parameters();
+  pwcpp::property::ParametersProperty parameters(list);
+  auto bindings = make_bindings();
+  bindings->learn(1);
+  ASSERT_TRUE(bindings->learning());
+
+  const std::array<pwcpp::midi::timed_message, 2> messages{
+      pwcpp::midi::timed_message{0, pwcpp::midi::note_on{0, 60, 1}},
+      pwcpp::midi::timed_message{1, pwcpp::midi::control_change{5, 74, 0}}};
+  bindings->process(1, messages, [](const pwcpp::property::parameter_change &) {});
+  ASSERT_FALSE(bindings->learning());
+
+  ASSERT_TRUE(bindings->sync(parameters).has_value());
+  ASSERT_EQ(bindings->current().size(), 1);
+  ASSERT_TRUE((bindings->current()[0] == pwcpp::property::midi_binding{1, 5, 74, 1}));
+}
+
+TEST(SkipsInvalidPersistedBindings) {
+  auto bindings = make_bindings();
+  auto parsed = bindings->deserialize("0:1:2:gain;9:0:0:gain;0:0:x:gain;1:0:3:unknown;1:15:127:cutoff");
+  ASSERT_EQ(parsed.size(), 2);
+  ASSERT_TRUE((parsed[1] == pwcpp::property::midi_binding{1, 15, 127, 1}));
+}
+
+TEST(RejectsMoreSlotsThanItHolds) {
+  auto bindings = pwcpp::property::MidiBindings<2>::create(
+      {{"gain", 0.0, 1.0}, {"cutoff", 0.0, 1.0}, {"steps", 0.0, 16.0}}, 1);
+  ASSERT_FALSE(bindings.has_value());
+  ASSERT_TRUE(bindings.error().type == pwcpp::error_type::UNSUPPORTED_CONFIGURATION);
+
+  auto fitting = pwcpp::property::MidiBindings<2>::create(
+      {{"gain", 0.0, 1.0}, {"cutoff", 0.0, 1.0}}, 1);
+  ASSERT_TRUE(fitting.has_value());
+  ASSERT_TRUE(fitting.value()->bind({0, 0, 1, 1}).has_value());
+}
+
+TEST_MAIN()
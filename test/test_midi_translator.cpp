@@ -0,0 +1,233 @@
+#include "pwcpp/buffer.h"
+#include "pwcpp/error.h"
+#include "pwcpp/midi/parse_ump_batch.h"
+#include "pwcpp/midi/write_midi.h"
+#include "pwcpp/osc/midi_translator.h"
+#include "pwcpp/osc/packet_view.h"
+#include "pwcpp/osc/write_osc.h"
+#include "sequence_memory.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <oscpp/client.hpp>
+#include <oscpp/server.hpp>
+#include <spa/pod/iter.h>
+
+#include <microtest/microtest.h>
+
+namespace {
+using translator_memory = sequence_memory<2048>;
+
+struct osc_message {
+  uint32_t offset;
+  std::string address;
+  std::vector<float> arguments;
+};
+
+std::vector<osc_message> read_osc(translator_memory &memory) {
+  auto buffer = memory.buffer();
+  std::vector<osc_message> messages;
+  auto view = pwcpp::osc::packets(buffer);
+  for (const auto &packet : view.value()) {
+    OSCPP::Server::Message message(packet.packet);
+    osc_message read{packet.offset, message.address(), {}};
+    auto arguments = message.args();
+    while (!arguments.atEnd()) {
+      read.arguments.push_back(arguments.float32());
+    }
+    messages.push_back(read);
+  }
+  return messages;
+}
+
+std::vector<pwcpp::osc::midi_osc_mapping> make_mappings() {
+  using kind = pwcpp::midi::message_kind;
+  return {
+      {kind::CONTROL_CHANGE, 0, 7, "/mixer/volume", 0.0f, 100.0f},
+      {kind::CONTROL_CHANGE, 0, std::nullopt, "/mixer/cc"},
+      {kind::NOTE_ON, 1, std::nullopt, "/synth/note"},
+      {kind::PITCH_BEND, 1, std::nullopt, "/synth/bend", -1.0f, 1.0f},
+  };
+}
+} // namespace
+
+TEST(RejectsInvalidMappings) {
+  pwcpp::osc::MidiOscTranslator translator;
+  using kind = pwcpp::midi::message_kind;
+  ASSERT_FALSE(
+      translator.set_mappings({{kind::CONTROL_CHANGE, 16, 1, "/a"}}).has_value());
+  ASSERT_FALSE(translator
+                   .set_mappings({{kind::REGISTERED_CONTROLLER, 0, 1, "/a"}})
+                   .has_value());
+  auto result = translator.set_mappings({{kind::NOTE_ON, 0, 1, "no slash"}});
+  ASSERT_FALSE(result.has_value());
+  ASSERT_TRUE(result.error().type ==
+              pwcpp::error_type::OSC_INVALID_ADDRESS_PATTERN);
+  ASSERT_TRUE(translator.set_mappings(make_mappings()).has_value());
+
+  const std::vector<pwcpp::osc::midi_osc_mapping> too_many(
+      0x10000, {kind::CONTROL_CHANGE, 0, 1, "/a"});
+  ASSERT_FALSE(translator.set_mappings(too_many).has_value());
+}
+
+TEST(IgnoresTheNumberOfKindsWithoutOne) {
+  pwcpp::osc::MidiOscTranslator translator;
+  using kind = pwcpp::midi::message_kind;
+  ASSERT_TRUE(translator
+                  .set_mappings({{kind::PITCH_BEND, 2, 5, "/bend"},
+                                 {kind::CHANNEL_PRESSURE, 2, 9, "/pressure"}})
+                  .has_value());
+
+  const std::vector<pwcpp::midi::timed_message> messages{
+      {1, pwcpp::midi::pitch_bend{2, 0xffffffff}},
+      {3, pwcpp::midi::channel_pressure{2, 0}},
+  };
+
+  translator_memory memory;
+  pwcpp::osc::OscWriter writer(memory.spa_data());
+  const auto written = translator.midi_to_osc(messages, writer);
+  writer.finish();
+  ASSERT_EQ(written, 2);
+
+  const auto read = read_osc(memory);
+  ASSERT_EQ(read.size(), 2);
+  ASSERT_EQ(read[0].address, "/bend");
+  ASSERT_EQ(read[0].arguments.size(), 1);
+  ASSERT_TRUE(read[0].arguments[0] == 1.0f);
+  ASSERT_EQ(read[1].address, "/pressure");
+}
+
+TEST(TranslatesMidiToOsc) {
+  pwcpp::osc::MidiOscTranslator translator;
+  ASSERT_TRUE(translator.set_mappings(make_mappings()).has_value());
+
+  const std::vector<pwcpp::midi::timed_message> messages{
+      {2, pwcpp::midi::control_change{0, 7, 0xffffffff}},
+      {4, pwcpp::midi::control_change{0, 10, 0}},
+      {5, pwcpp::midi::control_change{3, 7, 0xffffffff}},
+      {6, pwcpp::midi::note_on{1, 60, 0xffff}},
+      {9, pwcpp::midi::pitch_bend{1, 0}},
+  };
+
+  translator_memory memory;
+  pwcpp::osc::OscWriter writer(memory.spa_data());
+  const auto written = translator.midi_to_osc(messages, writer);
+  writer.finish();
+  ASSERT_EQ(written, 4);
+
+  const auto read = read_osc(memory);
+  ASSERT_EQ(read.size(), 4);
+  ASSERT_EQ(read[0].offset, 2);
+  ASSERT_EQ(read[0].address, "/mixer/volume");
+  ASSERT_EQ(read[0].arguments.size(), 1);
+  ASSERT_TRUE(read[0].arguments[0] == 100.0f);
+  ASSERT_EQ(read[1].address, "/mixer/cc");
+  ASSERT_EQ(read[1].arguments.size(), 2);
+  ASSERT_TRUE(read[1].arguments[0] == 10.0f);
+  ASSERT_TRUE(read[1].arguments[1] == 0.0f);
+  ASSERT_EQ(read[2].address, "/synth/note");
+  ASSERT_TRUE(read[2].arguments[0] == 60.0f);
+  ASSERT_TRUE(read[2].arguments[1] == 1.0f);
+  ASSERT_EQ(read[3].offset, 9);
+  ASSERT_TRUE(read[3].arguments[0] == -1.0f);
+}
+
+TEST(TranslatesParseMidiOutput) {
+  pwcpp::osc::MidiOscTranslator translator;
+  ASSERT_TRUE(translator.set_mappings(make_mappings()).has_value());
+
+  const std::array<std::optional<pwcpp::midi::message>, 3> messages{
+      pwcpp::midi::message{pwcpp::midi::control_change{0, 7, 0}},
+      std::nullopt, std::nullopt};
+
+  translator_memory memory;
+  pwcpp::osc::OscWriter writer(memory.spa_data());
+  const auto written = translator.midi_to_osc(messages, writer);
+  writer.finish();
+  ASSERT_EQ(written, 1);
+  ASSERT_EQ(read_osc(memory)[0].address, "/mixer/volume");
+}
+
+TEST(TranslatesOscToMidi) {
+  pwcpp::osc::MidiOscTranslator translator;
+  ASSERT_TRUE(translator.set_mappings(make_mappings()).has_value());
+
+  OSCPP::Client::StaticPacket<64> volume;
+  volume.openMessage("/mixer/volume", 1).float32(200.0f).closeMessage();
+  OSCPP::Client::StaticPacket<64> note;
+  note.openMessage("/synth/note", 2).int32(64).float32(0.0f).closeMessage();
+  OSCPP::Client::StaticPacket<64> bend;
+  bend.openMessage("/synth/bend", 1).float32(1.0f).closeMessage();
+  OSCPP::Client::StaticPacket<64> unmapped;
+  unmapped.openMessage("/other", 1).float32(1.0f).closeMessage();
+
+  const std::vector<pwcpp::osc::timed_packet> packets{
+      {1, pwcpp::osc::immediately,
+       OSCPP::Server::Packet(volume.data(), volume.size())},
+      {3, pwcpp::osc::immediately,
+       OSCPP::Server::Packet(unmapped.data(), unmapped.size())},
+      {5, pwcpp::osc::immediately,
+       OSCPP::Server::Packet(note.data(), note.size())},
+      {7, pwcpp::osc::immediately,
+       OSCPP::Server::Packet(bend.data(), bend.size())},
+  };
+
+  translator_memory memory;
+  pwcpp::midi::MidiWriter writer(memory.spa_data());
+  const auto written = translator.osc_to_midi(packets, writer);
+  writer.finish();
+  ASSERT_EQ(written, 3);
+
+  auto buffer = memory.buffer();
+  std::array<pwcpp::midi::timed_message, 8> parsed;
+  auto count = pwcpp::midi::parse_midi_batch(buffer, parsed);
+  ASSERT_TRUE(count.has_value());
+  ASSERT_EQ(count.value(), 3);
+  ASSERT_TRUE((parsed[0] == pwcpp::midi::timed_message{
+                                1, pwcpp::midi::control_change{0, 7, 0xffffffff}}));
+  ASSERT_TRUE((parsed[1] ==
+               pwcpp::midi::timed_message{5, pwcpp::midi::note_on{1, 64, 0}}));
+  ASSERT_TRUE((parsed[2] == pwcpp::midi::timed_message{
+                                7, pwcpp::midi::pitch_bend{1, 0xffffffff}}));
+}
+
+TEST(DropsNumbersOutOfRange) {
+  pwcpp::osc::MidiOscTranslator translator;
+  ASSERT_TRUE(translator.set_mappings(make_mappings()).has_value());
+
+  OSCPP::Client::StaticPacket<64> negative;
+  negative.openMessage("/mixer/cc", 2).int32(-5).float32(0.5f).closeMessage();
+  OSCPP::Client::StaticPacket<64> large;
+  large.openMessage("/mixer/cc", 2).int32(128).float32(0.5f).closeMessage();
+  OSCPP::Client::StaticPacket<64> valid;
+  valid.openMessage("/mixer/cc", 2).int32(3).float32(1.0f).closeMessage();
+
+  const std::vector<pwcpp::osc::timed_packet> packets{
+      {1, pwcpp::osc::immediately,
+       OSCPP::Server::Packet(negative.data(), negative.size())},
+      {2, pwcpp::osc::immediately,
+       OSCPP::Server::Packet(large.data(), large.size())},
+      {3, pwcpp::osc::immediately,
+       OSCPP::Server::Packet(valid.data(), valid.size())},
+  };
+
+  translator_memory memory;
+  pwcpp::midi::MidiWriter writer(memory.spa_data());
+  const auto written = translator.osc_to_midi(packets, writer);
+  writer.finish();
+  ASSERT_EQ(written, 1);
+
+  auto buffer = memory.buffer();
+  std::array<pwcpp::midi::timed_message, 4> parsed;
+  auto count = pwcpp::midi::parse_midi_batch(buffer, parsed);
+  ASSERT_TRUE(count.has_value());
+  ASSERT_EQ(count.value(), 1);
+  ASSERT_TRUE((parsed[0] == pwcpp::midi::timed_message{
+                                3, pwcpp::midi::control_change{0, 3, 0xffffffff}}));
+}
+
+TEST_MAIN()
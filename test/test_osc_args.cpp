@@ -0,0 +1,194 @@
+#include <oscpp/client.hpp>
+#include <oscpp/detail/host.hpp>
+#include <oscpp/error.hpp>
+#include <oscpp/server.hpp>
+#include <oscpp/types.hpp>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <microtest/microtest.h>
+
+TEST(Bswap32ArrayMatchesScalarSwap) {
+  std::array<uint32_t, 41> words{};
+  for (std::size_t i = 0; i < words.size(); ++i) {
+    words[i] = static_cast<uint32_t>(0x01020304u * (i + 1));
+  }
+
+  // Every length exercises a different split into vector and scalar tails.
+  for (std::size_t count = 0; count <= words.size(); ++count) {
+    std::array<uint32_t, 41> swapped{};
+    OSCPP::bswap32Array(words.data(), swapped.data(), count);
+    for (std::size_t i = 0; i < count; ++i) {
+      ASSERT_EQ(swapped[i], OSCPP::bswap32(words[i]));
+    }
+    for (std::size_t i = count; i < swapped.size(); ++i) {
+      ASSERT_EQ(swapped[i], 0);
+    }
+  }
+
+  auto in_place = words;
+  OSCPP::bswap32Array(in_place.data(), in_place.data(), in_place.size());
+  ASSERT_EQ(in_place[40], OSCPP::bswap32(words[40]));
+}
+
+TEST(Float32sReadsRunsOfNumbers) {
+  OSCPP::Client::StaticPacket<512> packet;
+  packet.openMessage("/meter", 23);
+  for (int i = 0; i < 20; ++i) {
+    packet.float32(static_cast<float>(i) * 0.5f);
+  }
+  packet.int32(7).int32(-3).string("end").closeMessage();
+
+  OSCPP::Server::Message message(
+      OSCPP::Server::Packet(packet.data(), packet.size()));
+  auto args = message.args();
+  std::array<float, 32> values{};
+  const auto count = args.float32s(values.data(), values.size());
+
+  ASSERT_EQ(count, 22);
+  ASSERT_TRUE(values[0] == 0.0f);
+  ASSERT_TRUE(values[19] == 9.5f);
+  ASSERT_TRUE(values[20] == 7.0f);
+  ASSERT_TRUE(values[21] == -3.0f);
+  ASSERT_EQ(args.tag(), 's');
+  const char *text = args.string();
+  ASSERT_EQ(std::strcmp(text, "end"), 0);
+}
+
+TEST(Float32sStopsAtCount) {
+  OSCPP::Client::StaticPacket<128> packet;
+  packet.openMessage("/xyz", 3).float32(1.0f).float32(2.0f).float32(3.0f)
+      .closeMessage();
+
+  OSCPP::Server::Message message(
+      OSCPP::Server::Packet(packet.data(), packet.size()));
+  auto args = message.args();
+  std::array<float, 2> values{};
+  const auto count = args.float32s(values.data(), values.size());
+  ASSERT_EQ(count, 2);
+  ASSERT_TRUE(values[1] == 2.0f);
+  const float last = args.float32();
+  ASSERT_TRUE(last == 3.0f);
+  ASSERT_TRUE(args.atEnd());
+}
+
+TEST(Int32sConvertsFloats) {
+  OSCPP::Client::StaticPacket<128> packet;
+  packet.openMessage("/n", 4).int32(1).int32(2).float32(3.75f).int32(-4)
+      .closeMessage();
+
+  OSCPP::Server::Message message(
+      OSCPP::Server::Packet(packet.data(), packet.size()));
+  auto args = message.args();
+  std::array<int32_t, 8> values{};
+  const auto count = args.int32s(values.data(), values.size());
+  ASSERT_EQ(count, 4);
+  ASSERT_EQ(values[0], 1);
+  ASSERT_EQ(values[2], 3);
+  ASSERT_EQ(values[3], -4);
+}
+
+TEST(Float32sReportsTruncatedMessages) {
+  OSCPP::Client::StaticPacket<128> packet;
+  packet.openMessage("/t", 2).float32(1.0f).float32(2.0f).closeMessage();
+
+  // Drop the last argument but keep the type tags.
+  OSCPP::Server::Message message(
+      OSCPP::Server::Packet(packet.data(), packet.size() - 4));
+  auto args = message.args();
+  std::array<float, 2> values{};
+  bool underrun = false;
+  try {
+    args.float32s(values.data(), values.size());
+  } catch (const OSCPP::UnderrunError &) {
+    underrun = true;
+  }
+  ASSERT_TRUE(underrun);
+}
+
+TEST(Float32BlobDecodesBigEndianFloats) {
+  std::vector<uint32_t> encoded(100);
+  for (std::size_t i = 0; i < encoded.size(); ++i) {
+    const float value = static_cast<float>(i) / 4.0f;
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    encoded[i] = OSCPP::convert32<OSCPP::NetworkByteOrder>(bits);
+  }
+
+  OSCPP::Client::StaticPacket<1024> packet;
+  packet.openMessage("/spectrum", 1)
+      .blob(OSCPP::Blob(encoded.data(), encoded.size() * 4))
+      .closeMessage();
+
+  OSCPP::Server::Message message(
+      OSCPP::Server::Packet(packet.data(), packet.size()));
+  auto args = message.args();
+  std::array<float, 64> values{};
+  const auto count = args.float32Blob(values.data(), values.size());
+  ASSERT_EQ(count, 100);
+  ASSERT_TRUE(values[1] == 0.25f);
+  ASSERT_TRUE(values[63] == 15.75f);
+  ASSERT_TRUE(args.atEnd());
+}
+
+TEST(ReadsStringsOfEveryLength) {
+  // Lengths around the 4 byte padding and the 16 and 32 byte vector widths.
+  for (std::size_t length = 1; length < 72; ++length) {
+    std::string address(length, 'a');
+    address[0] = '/';
+    std::string text(length - 1, 'x');
+
+    OSCPP::Client::StaticPacket<512> packet;
+    packet.openMessage(address.c_str(), 2)
+        .string(text.c_str())
+        .int32(static_cast<int32_t>(length))
+        .closeMessage();
+
+    OSCPP::Server::Message message(
+        OSCPP::Server::Packet(packet.data(), packet.size()));
+    ASSERT_EQ(std::string(message.address()), address);
+    auto args = message.args();
+    const std::string read = args.string();
+    ASSERT_EQ(read, text);
+    const auto number = args.int32();
+    ASSERT_EQ(number, static_cast<int32_t>(length));
+  }
+}
+
+TEST(RejectsInvalidStringPadding) {
+  OSCPP::Client::StaticPacket<128> packet;
+  packet.openMessage("/a", 0).closeMessage();
+  std::array<char, 128> data{};
+  std::memcpy(data.data(), packet.data(), packet.size());
+  data[3] = 'x';
+
+  bool rejected = false;
+  try {
+    OSCPP::Server::Message message(
+        OSCPP::Server::Packet(data.data(), packet.size()));
+  } catch (const OSCPP::ParseError &) {
+    rejected = true;
+  }
+  ASSERT_TRUE(rejected);
+}
+
+TEST(RejectsUnterminatedStrings) {
+  std::array<char, 40> data{};
+  std::memset(data.data(), 'a', data.size());
+  data[0] = '/';
+
+  bool underrun = false;
+  try {
+    OSCPP::Server::Message message(
+        OSCPP::Server::Packet(data.data(), data.size()));
+  } catch (const OSCPP::UnderrunError &) {
+    underrun = true;
+  }
+  ASSERT_TRUE(underrun);
+}
+
+TEST_MAIN()
@@ -0,0 +1,201 @@
+#include "pwcpp/error.h"
+#include "pwcpp/osc/packet_view.h"
+#include "pwcpp/property/osc_parameters.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <oscpp/client.hpp>
+#include <oscpp/server.hpp>
+
+#include <microtest/microtest.h>
+
+namespace {
+using parameter_list =
+    std::vector<std::tuple<std::string, pwcpp::property::property_value_type>>;
+
+std::shared_ptr<parameter_list> make_parameters() {
+  return std::make_shared<parameter_list>(
+      parameter_list{{"gain", 0.5},
+                     {"voices", 4},
+                     {"bypass", false},
+                     {"mode", std::string("lowpass")},
+                     {"bad name", 1.0f}});
+}
+
+struct message_memory {
+  OSCPP::Client::StaticPacket<128> packet;
+
+  message_memory() = default;
+
+  message_memory(const char *address, const float value) {
+    packet.openMessage(address, 1).float32(value).closeMessage();
+  }
+
+  message_memory(const char *address, const int32_t value) {
+    packet.openMessage(address, 1).int32(value).closeMessage();
+  }
+
+  pwcpp::osc::timed_packet at(const uint32_t offset) const {
+    return {offset, pwcpp::osc::immediately,
+            OSCPP::Server::Packet(packet.data(), packet.size())};
+  }
+};
+
+template <typename T>
+T parameter(const parameter_list &parameters, const std::string &name) {
+  for (const auto &[key, value] : parameters) {
+    if (key == name) {
+      return std::get<T>(value);
+    }
+  }
+  return T{};
+}
+} // namespace
+
+TEST(MapsNumericParameters) {
+  auto list = make_parameters();
+  pwcpp::property::ParametersProperty parameters(list);
+  auto osc =
+      pwcpp::property::OscParameters<8>::create("/filter/synth", parameters)
+          .value();
+
+  ASSERT_EQ(osc->size(), 3);
+  ASSERT_TRUE(osc->slot("gain").has_value());
+  ASSERT_FALSE(osc->slot("mode").has_value());
+  ASSERT_FALSE(osc->slot("bad name").has_value());
+  ASSERT_EQ(osc->address(osc->slot("voices").value()), "/filter/synth/voices");
+  ASSERT_TRUE(osc->value(osc->slot("gain").value()) == 0.5);
+}
+
+TEST(AppliesMessagesAtTheirOffset) {
+  auto list = make_parameters();
+  pwcpp::property::ParametersProperty parameters(list);
+  auto osc =
+      pwcpp::property::OscParameters<8>::create("/filter/synth", parameters)
+          .value();
+
+  const message_memory gain("/filter/synth/gain", 0.25f);
+  const message_memory voices("/filter/synth/voices", 2.6f);
+  const message_memory other("/filter/other/gain", 1.0f);
+  const message_memory bypass("/filter/synth/bypass", 1);
+  const std::vector<pwcpp::osc::timed_packet> packets{
+      gain.at(3), other.at(5), voices.at(8), bypass.at(12)};
+
+  std::vector<pwcpp::property::parameter_change> changes;
+  const auto count = osc->process(
+      packets, [&](const pwcpp::property::parameter_change &change) {
+        changes.push_back(change);
+      });
+
+  ASSERT_EQ(count, 3);
+  ASSERT_EQ(changes.size(), 3);
+  ASSERT_EQ(changes[0].offset, 3);
+  ASSERT_EQ(changes[0].slot, osc->slot("gain").value());
+  ASSERT_TRUE(changes[0].value == 0.25);
+  ASSERT_EQ(changes[1].offset, 8);
+  ASSERT_TRUE(changes[1].value == 3.0);
+  ASSERT_EQ(changes[2].offset, 12);
+  ASSERT_TRUE(changes[2].value == 1.0);
+}
+
+TEST(SyncsConvertedValues) {
+  auto list = make_parameters();
+  pwcpp::property::ParametersProperty parameters(list);
+  auto osc =
+      pwcpp::property::OscParameters<8>::create("/filter/synth", parameters)
+          .value();
+
+  const message_memory voices("/filter/synth/voices", 7.4f);
+  const message_memory bypass("/filter/synth/bypass", 1.0f);
+  const std::vector<pwcpp::osc::timed_packet> packets{voices.at(0),
+                                                      bypass.at(0)};
+  osc->process(packets, [](const pwcpp::property::parameter_change &) {});
+
+  ASSERT_TRUE(osc->sync(parameters));
+  ASSERT_EQ(parameter<int>(*list, "voices"), 7);
+  ASSERT_TRUE(parameter<bool>(*list, "bypass"));
+  ASSERT_TRUE(parameter<double>(*list, "gain") == 0.5);
+  ASSERT_FALSE(osc->sync(parameters));
+}
+
+TEST(KeepsIntegersExact) {
+  auto list = make_parameters();
+  pwcpp::property::ParametersProperty parameters(list);
+  auto osc =
+      pwcpp::property::OscParameters<8>::create("/filter/synth", parameters)
+          .value();
+
+  // Not representable as a float.
+  const message_memory voices("/filter/synth/voices", int32_t(16777217));
+  const std::vector<pwcpp::osc::timed_packet> packets{voices.at(0)};
+  osc->process(packets, [](const pwcpp::property::parameter_change &) {});
+
+  ASSERT_TRUE(osc->sync(parameters));
+  ASSERT_EQ(parameter<int>(*list, "voices"), 16777217);
+}
+
+TEST(ChangesPrefix) {
+  auto list = make_parameters();
+  pwcpp::property::ParametersProperty parameters(list);
+  auto osc =
+      pwcpp::property::OscParameters<8>::create("/filter/synth", parameters)
+          .value();
+
+  ASSERT_TRUE(osc->set_prefix("/bus/2/").has_value());
+  ASSERT_EQ(osc->prefix(), "/bus/2");
+
+  const message_memory old_address("/filter/synth/gain", 0.1f);
+  const message_memory new_address("/bus/2/gain", 0.9f);
+  const std::vector<pwcpp::osc::timed_packet> packets{old_address.at(0),
+                                                      new_address.at(1)};
+  const auto count =
+      osc->process(packets, [](const pwcpp::property::parameter_change &) {});
+  ASSERT_EQ(count, 1);
+  ASSERT_TRUE(osc->value(osc->slot("gain").value()) == 0.9f);
+
+  for (const char *prefix : {"filter", "/a/*", "/a b"}) {
+    auto result = osc->set_prefix(prefix);
+    ASSERT_FALSE(result.has_value());
+    ASSERT_TRUE(result.error().type ==
+                pwcpp::error_type::OSC_INVALID_ADDRESS_PATTERN);
+  }
+  ASSERT_EQ(osc->prefix(), "/bus/2");
+}
+
+TEST(IgnoresMessagesWithoutNumbers) {
+  auto list = make_parameters();
+  pwcpp::property::ParametersProperty parameters(list);
+  auto osc =
+      pwcpp::property::OscParameters<8>::create("", parameters)
+          .value();
+
+  message_memory text;
+  text.packet.openMessage("/gain", 1).string("loud").closeMessage();
+  message_memory empty;
+  empty.packet.openMessage("/gain", 0).closeMessage();
+  const std::vector<pwcpp::osc::timed_packet> packets{text.at(0), empty.at(0)};
+
+  const auto count =
+      osc->process(packets, [](const pwcpp::property::parameter_change &) {});
+  ASSERT_EQ(count, 0);
+  ASSERT_FALSE(osc->sync(parameters));
+}
+
+TEST(RejectsMoreParametersThanItHolds) {
+  auto list = make_parameters();
+  pwcpp::property::ParametersProperty parameters(list);
+  auto osc = pwcpp::property::OscParameters<2>::create("", parameters);
+  ASSERT_FALSE(osc.has_value());
+  ASSERT_TRUE(osc.error().type ==
+              pwcpp::error_type::UNSUPPORTED_CONFIGURATION);
+
+  auto fitting = pwcpp::property::OscParameters<3>::create("", parameters);
+  ASSERT_TRUE(fitting.has_value());
+  ASSERT_EQ(fitting.value()->size(), 3);
+}
+
+TEST_MAIN()
@@ -0,0 +1,104 @@
+#include "pwcpp/osc/packet_pool.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <oscpp/client.hpp>
+#include <oscpp/server.hpp>
+
+#include <microtest/microtest.h>
+
+TEST(BuildsMessagesInPooledBuffers) {
+  pwcpp::osc::PacketPool<4, 64> pool;
+  auto packet = pool.message("/synth/gain", 0.5f, int32_t(3), "on");
+  ASSERT_TRUE(packet.has_value());
+  ASSERT_EQ(pool.used(), 1);
+
+  OSCPP::Server::Message message(
+      OSCPP::Server::Packet(packet->data(), packet->size()));
+  ASSERT_EQ(std::string(message.address()), "/synth/gain");
+  auto args = message.args();
+  const float gain = args.float32();
+  ASSERT_TRUE(gain == 0.5f);
+  const int32_t number = args.int32();
+  ASSERT_EQ(number, 3);
+  const std::string text = args.string();
+  ASSERT_EQ(text, "on");
+
+  packet.reset();
+  ASSERT_EQ(pool.used(), 0);
+}
+
+TEST(ReturnsNothingWhenExhausted) {
+  pwcpp::osc::PacketPool<2, 32> pool;
+  auto first = pool.message("/a", 1.0f);
+  auto second = pool.message("/b", 2.0f);
+  ASSERT_TRUE(first.has_value());
+  ASSERT_TRUE(second.has_value());
+  ASSERT_FALSE(pool.message("/c", 3.0f).has_value());
+
+  first->release();
+  ASSERT_EQ(pool.used(), 1);
+  auto third = pool.message("/c", 3.0f);
+  ASSERT_TRUE(third.has_value());
+
+  // The moved-from packet doesn't return the buffer a second time.
+  auto moved = std::move(third.value());
+  third.reset();
+  ASSERT_EQ(pool.used(), 2);
+  second.reset();
+  ASSERT_EQ(pool.used(), 1);
+}
+
+TEST(RejectsPacketsLargerThanABuffer) {
+  pwcpp::osc::PacketPool<2, 32> pool;
+  ASSERT_FALSE(
+      pool.message("/a/rather/long/address/for/a/small/buffer").has_value());
+  ASSERT_EQ(pool.used(), 0);
+
+  // Without a size the overflow is only found while building.
+  auto bundle = pool.build([](OSCPP::Client::Packet &packet) {
+    packet.openBundle(1).openMessage("/a", 1).float32(1.0f).closeMessage();
+    packet.openMessage("/b", 1).float32(2.0f).closeMessage().closeBundle();
+  });
+  ASSERT_FALSE(bundle.has_value());
+  ASSERT_EQ(pool.used(), 0);
+}
+
+TEST(SharesBuffersBetweenThreads) {
+  pwcpp::osc::PacketPool<8, 32> pool;
+  std::atomic<std::size_t> built = 0;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&pool, &built, t] {
+      std::array<std::optional<pwcpp::osc::PooledPacket<8, 32>>, 2> held;
+      for (int i = 0; i < 20000; ++i) {
+        auto &slot = held[i % held.size()];
+        slot.reset();
+        slot = pool.message("/t", int32_t(t));
+        if (slot.has_value()) {
+          OSCPP::Server::Message message(
+              OSCPP::Server::Packet(slot->data(), slot->size()));
+          if (message.args().int32() == t) {
+            built.fetch_add(1, std::memory_order_relaxed);
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(pool.used(), 0);
+  ASSERT_EQ(built.load(), 80000);
+}
+
+TEST_MAIN()
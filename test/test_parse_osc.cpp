@@ -0,0 +1,221 @@
+#include "pwcpp/buffer.h"
+#include "pwcpp/osc/packet_view.h"
+#include "pwcpp/osc/parse_osc.h"
+#include "pwcpp/rt/spsc_queue.h"
+#include "pwcpp/spa/pod/sequence_writer.h"
+#include "sequence_memory.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <oscpp/client.hpp>
+#include <spa/control/control.h>
+#include <spa/pod/iter.h>
+
+#include <microtest/microtest.h>
+
+TEST(QueuePassesValuesInOrder) {
+  pwcpp::rt::SpscQueue<int, 4> queue;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.try_push(i));
+  }
+  ASSERT_FALSE(queue.try_push(4));
+
+  auto first = queue.try_pop();
+  ASSERT_TRUE(first.has_value());
+  ASSERT_EQ(first.value(), 0);
+  ASSERT_TRUE(queue.try_push(4));
+
+  std::vector<int> drained;
+  auto count = queue.drain([&drained](int value) { drained.push_back(value); });
+  ASSERT_EQ(count, 4);
+  ASSERT_TRUE((drained == std::vector<int>{1, 2, 3, 4}));
+  ASSERT_TRUE(queue.empty());
+  ASSERT_FALSE(queue.try_pop().has_value());
+}
+
+TEST(ReportsSkippedControls) {
+  sequence_memory<> memory;
+  OSCPP::Client::StaticPacket<64> packet;
+  packet.openMessage("/gain", 1).float32(0.5f).closeMessage();
+
+  const uint32_t ump = 0x40b00700;
+  const uint8_t malformed[4] = {'x', 0, 0, 0};
+  pwcpp::spa::pod::SequenceWriter writer(memory.spa_data());
+  writer.write(0, SPA_CONTROL_UMP, &ump, sizeof(ump));
+  writer.write(2, SPA_CONTROL_OSC, malformed, sizeof(malformed));
+  writer.write(5, SPA_CONTROL_OSC, packet.data(),
+               static_cast<uint32_t>(packet.size()));
+  writer.finish();
+
+  pwcpp::osc::ParseDiagnostics diagnostics;
+  auto buffer = memory.buffer();
+  auto result = pwcpp::osc::parse_osc<4>(buffer, &diagnostics);
+  ASSERT_TRUE(result.has_value());
+  ASSERT_TRUE(result.value()[0].has_value());
+
+  const auto counters = diagnostics.counters();
+  ASSERT_EQ(counters.packets, 1);
+  ASSERT_EQ(counters.skipped_controls, 1);
+  ASSERT_EQ(counters.malformed_packets, 1);
+
+  std::vector<pwcpp::osc::parse_diagnostic> log;
+  diagnostics.drain(
+      [&log](const pwcpp::osc::parse_diagnostic &entry) { log.push_back(entry); });
+  ASSERT_EQ(log.size(), 2);
+  ASSERT_TRUE(log[0].event == pwcpp::osc::parse_event::NOT_AN_OSC_CONTROL);
+  ASSERT_EQ(log[0].offset, 0);
+  ASSERT_TRUE(log[1].event == pwcpp::osc::parse_event::MALFORMED_PACKET);
+  ASSERT_EQ(log[1].offset, 2);
+}
+
+TEST(CountsEventsWhenTheLogIsFull) {
+  pwcpp::osc::ParseDiagnostics diagnostics;
+  for (std::size_t i = 0; i < pwcpp::osc::ParseDiagnostics::log_capacity + 3;
+       ++i) {
+    diagnostics.report(pwcpp::osc::parse_event::POD_EMPTY);
+  }
+
+  const auto counters = diagnostics.counters();
+  ASSERT_EQ(counters.empty_pods, pwcpp::osc::ParseDiagnostics::log_capacity + 3);
+  ASSERT_EQ(counters.dropped_log_entries, 3);
+}
+
+TEST(ChecksPacketFraming) {
+  const uint8_t message[8] = {'/', 'a', 0, 0, ',', 0, 0, 0};
+  const uint8_t bundle[16] = {'#', 'b', 'u', 'n', 'd', 'l', 'e', 0};
+  ASSERT_TRUE(pwcpp::osc::is_osc_packet(message, sizeof(message)));
+  ASSERT_FALSE(pwcpp::osc::is_osc_packet(message, 6));
+  ASSERT_TRUE(pwcpp::osc::is_osc_packet(bundle, sizeof(bundle)));
+  ASSERT_FALSE(pwcpp::osc::is_osc_packet(bundle, 8));
+}
+
+TEST(StoresEveryPacketInItsOwnSlot) {
+  sequence_memory<> memory;
+  OSCPP::Client::StaticPacket<64> first;
+  first.openMessage("/a", 0).closeMessage();
+  OSCPP::Client::StaticPacket<64> second;
+  second.openMessage("/b", 0).closeMessage();
+
+  pwcpp::spa::pod::SequenceWriter writer(memory.spa_data());
+  writer.write(0, SPA_CONTROL_OSC, first.data(),
+               static_cast<uint32_t>(first.size()));
+  writer.write(1, SPA_CONTROL_OSC, second.data(),
+               static_cast<uint32_t>(second.size()));
+  writer.finish();
+
+  auto buffer = memory.buffer();
+  auto result = pwcpp::osc::parse_osc<2>(buffer);
+  ASSERT_TRUE(result.has_value());
+  ASSERT_TRUE(result.value()[1].has_value());
+  ASSERT_EQ(std::string(static_cast<OSCPP::Server::Message>(
+                            result.value()[1].value())
+                            .address()),
+            "/b");
+
+  auto too_many = pwcpp::osc::parse_osc<1>(buffer);
+  ASSERT_FALSE(too_many.has_value());
+}
+
+TEST(ViewFlattensNestedBundles) {
+  sequence_memory<> memory;
+  OSCPP::Client::StaticPacket<256> bundle;
+  bundle.openBundle(10)
+      .openMessage("/a", 1)
+      .int32(1)
+      .closeMessage()
+      .openBundle(20)
+      .openMessage("/b", 1)
+      .int32(2)
+      .closeMessage()
+      .closeBundle()
+      .openMessage("/c", 1)
+      .int32(3)
+      .closeMessage()
+      .closeBundle();
+  OSCPP::Client::StaticPacket<64> message;
+  message.openMessage("/d", 0).closeMessage();
+
+  pwcpp::spa::pod::SequenceWriter writer(memory.spa_data());
+  writer.write(3, SPA_CONTROL_OSC, bundle.data(),
+               static_cast<uint32_t>(bundle.size()));
+  writer.write(7, SPA_CONTROL_OSC, message.data(),
+               static_cast<uint32_t>(message.size()));
+  writer.finish();
+
+  auto buffer = memory.buffer();
+  auto view = pwcpp::osc::packets(buffer);
+  ASSERT_TRUE(view.has_value());
+
+  std::vector<std::string> addresses;
+  std::vector<uint64_t> times;
+  std::vector<uint32_t> offsets;
+  for (const auto &packet : view.value()) {
+    addresses.emplace_back(
+        static_cast<OSCPP::Server::Message>(packet.packet).address());
+    times.push_back(packet.time);
+    offsets.push_back(packet.offset);
+  }
+
+  ASSERT_TRUE((addresses == std::vector<std::string>{"/a", "/b", "/c", "/d"}));
+  ASSERT_TRUE((times == std::vector<uint64_t>{10, 20, 10, pwcpp::osc::immediately}));
+  ASSERT_TRUE((offsets == std::vector<uint32_t>{3, 3, 3, 7}));
+}
+
+TEST(ViewSkipsBundlesNestedTooDeep) {
+  sequence_memory<> memory;
+  OSCPP::Client::StaticPacket<256> bundle;
+  bundle.openBundle(1)
+      .openBundle(2)
+      .openMessage("/deep", 0)
+      .closeMessage()
+      .closeBundle()
+      .openMessage("/shallow", 0)
+      .closeMessage()
+      .closeBundle();
+
+  pwcpp::spa::pod::SequenceWriter writer(memory.spa_data());
+  writer.write(0, SPA_CONTROL_OSC, bundle.data(),
+               static_cast<uint32_t>(bundle.size()));
+  writer.finish();
+
+  pwcpp::osc::ParseDiagnostics diagnostics;
+  auto buffer = memory.buffer();
+  auto view = pwcpp::osc::packets<1>(buffer, &diagnostics);
+  ASSERT_TRUE(view.has_value());
+
+  std::vector<std::string> addresses;
+  for (const auto &packet : view.value()) {
+    addresses.emplace_back(
+        static_cast<OSCPP::Server::Message>(packet.packet).address());
+  }
+  ASSERT_TRUE((addresses == std::vector<std::string>{"/shallow"}));
+  ASSERT_EQ(diagnostics.counters().dropped_packets, 1);
+}
+
+TEST(ViewStopsAtMalformedBundleElements) {
+  sequence_memory<> memory;
+  OSCPP::Client::StaticPacket<128> bundle;
+  bundle.openBundle(1).openMessage("/a", 0).closeMessage().closeBundle();
+
+  // Claim a larger element than the bundle holds.
+  std::array<uint8_t, 128> corrupted{};
+  std::memcpy(corrupted.data(), bundle.data(), bundle.size());
+  corrupted[19] = 0x40;
+
+  pwcpp::spa::pod::SequenceWriter writer(memory.spa_data());
+  writer.write(0, SPA_CONTROL_OSC, corrupted.data(),
+               static_cast<uint32_t>(bundle.size()));
+  writer.finish();
+
+  pwcpp::osc::ParseDiagnostics diagnostics;
+  auto buffer = memory.buffer();
+  auto view = pwcpp::osc::packets(buffer, &diagnostics);
+  ASSERT_TRUE(view.has_value());
+  ASSERT_TRUE(view.value().begin() == std::default_sentinel);
+  ASSERT_EQ(diagnostics.counters().malformed_packets, 1);
+}
+
+TEST_MAIN()
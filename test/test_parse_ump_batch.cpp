@@ -0,0 +1,137 @@
+#include "pwcpp/buffer.h"
+#include "pwcpp/midi/parse_midi.h"
+#include "pwcpp/midi/parse_ump_batch.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include <spa/control/control.h>
+#include <spa/pod/builder.h>
+
+#include <microtest/microtest.h>
+
+namespace {
+std::vector<uint32_t> make_headers(std::size_t count) {
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<uint32_t> status(0x00, 0xff);
+  std::uniform_int_distribution<uint32_t> message_type(0x2, 0x5);
+  std::vector<uint32_t> headers;
+  for (std::size_t i = 0; i < count; ++i) {
+    headers.push_back(message_type(generator) << 28 | (i & 0xf) << 24 |
+                      status(generator) << 16 | (i & 0x7f) << 8);
+  }
+  return headers;
+}
+
+pwcpp::Buffer make_buffer(uint8_t *pod_buffer, std::size_t size,
+                          const std::vector<uint32_t> &headers) {
+  return pwcpp::Buffer(
+      [](pw_buffer *, struct pwcpp::filter::port *) {},
+      [pod_buffer, size, headers](pw_buffer *,
+                                  size_t index) -> std::optional<spa_pod *> {
+        if (index != 0)
+          return {};
+
+        struct spa_pod_builder builder;
+        spa_pod_builder_init(&builder, pod_buffer, size);
+
+        struct spa_pod_frame frame;
+        spa_pod_builder_push_sequence(&builder, &frame, 0);
+        for (std::size_t i = 0; i < headers.size(); ++i) {
+          uint32_t ump[2] = {headers[i], static_cast<uint32_t>(i) * 0x01010101};
+          spa_pod_builder_control(&builder, i, SPA_CONTROL_UMP);
+          spa_pod_builder_bytes(&builder, ump, sizeof(ump));
+        }
+
+        return static_cast<spa_pod *>(spa_pod_builder_pop(&builder, &frame));
+      });
+}
+} // namespace
+
+TEST(ClassifyUmpMatchesScalarForAllLengths) {
+  auto headers = make_headers(67);
+  for (std::size_t n = 0; n <= headers.size(); ++n) {
+    std::span<const uint32_t> input(headers.data(), n);
+    std::array<uint32_t, 67> expected{};
+    std::array<uint32_t, 67> actual{};
+    auto expected_count =
+        pwcpp::midi::detail::classify_ump_64_scalar(input, expected);
+    auto actual_count = pwcpp::midi::classify_ump_64(input, actual);
+    ASSERT_EQ(actual_count, expected_count);
+    ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + expected_count,
+                           actual.begin()));
+
+#if defined(__x86_64__)
+    // The dispatch picks one variant, check the others directly.
+    std::array<uint32_t, 67> sse2{};
+    auto sse2_count = pwcpp::midi::detail::classify_ump_64_sse2(input, sse2);
+    ASSERT_EQ(sse2_count, expected_count);
+    ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + expected_count,
+                           sse2.begin()));
+
+    if (pwcpp::midi::detail::cpu_supports_avx2()) {
+      std::array<uint32_t, 67> avx2{};
+      auto avx2_count = pwcpp::midi::detail::classify_ump_64_avx2(input, avx2);
+      ASSERT_EQ(avx2_count, expected_count);
+      ASSERT_TRUE(std::equal(expected.begin(),
+                             expected.begin() + expected_count, avx2.begin()));
+    }
+#endif
+  }
+}
+
+TEST(ParseMidiBatchMatchesParseMidi) {
+  auto headers = make_headers(300);
+  static uint8_t pod_buffer[16384];
+  auto buffer = make_buffer(pod_buffer, sizeof(pod_buffer), headers);
+
+  auto scalar = pwcpp::midi::parse_midi<300>(buffer);
+  ASSERT_TRUE(scalar.has_value());
+
+  std::array<pwcpp::midi::timed_message, 300> batch_messages;
+  auto count = pwcpp::midi::parse_midi_batch(buffer, batch_messages);
+  ASSERT_TRUE(count.has_value());
+
+  std::size_t scalar_count(0);
+  for (auto &&message : scalar.value()) {
+    if (!message.has_value()) {
+      break;
+    }
+    ASSERT_TRUE(scalar_count < count.value());
+    ASSERT_TRUE(batch_messages[scalar_count].message == message.value());
+    scalar_count++;
+  }
+  ASSERT_EQ(scalar_count, count.value());
+  ASSERT_TRUE(scalar_count > 0);
+}
+
+TEST(ParseMidiBatchKeepsOffsets) {
+  std::vector<uint32_t> headers = {0x40b00700, 0x20b00700, 0x40903c00};
+  static uint8_t pod_buffer[1024];
+  auto buffer = make_buffer(pod_buffer, sizeof(pod_buffer), headers);
+
+  std::array<pwcpp::midi::timed_message, 4> messages;
+  auto count = pwcpp::midi::parse_midi_batch(buffer, messages);
+  ASSERT_TRUE(count.has_value());
+  ASSERT_EQ(count.value(), 2);
+  ASSERT_EQ(messages[0].offset, 0);
+  ASSERT_EQ(messages[1].offset, 2);
+  ASSERT_TRUE(std::holds_alternative<pwcpp::midi::note_on>(messages[1].message));
+}
+
+TEST(ParseMidiBatchReportsTooManyMessages) {
+  auto headers = make_headers(8);
+  static uint8_t pod_buffer[1024];
+  auto buffer = make_buffer(pod_buffer, sizeof(pod_buffer), headers);
+
+  std::array<pwcpp::midi::timed_message, 4> messages;
+  auto count = pwcpp::midi::parse_midi_batch(buffer, messages);
+  ASSERT_FALSE(count.has_value());
+  ASSERT_TRUE(count.error().type ==
+              pwcpp::error_type::MIDI_PARSING_POD_CONTAINS_TOO_MANY_MESSAGES);
+}
+
+TEST_MAIN()
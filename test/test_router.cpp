@@ -0,0 +1,150 @@
+#include "pwcpp/error.h"
+#include "pwcpp/midi/router.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <microtest/microtest.h>
+
+namespace {
+std::vector<std::pair<uint8_t, pwcpp::midi::timed_message>>
+route(const pwcpp::midi::RouteTable &table, uint8_t port,
+      const pwcpp::midi::timed_message &message) {
+  std::vector<std::pair<uint8_t, pwcpp::midi::timed_message>> routed;
+  table.route(port, message,
+              [&](uint8_t output_port, const pwcpp::midi::timed_message &m) {
+                routed.emplace_back(output_port, m);
+              });
+  return routed;
+}
+} // namespace
+
+TEST(DropsUnmatchedMessages) {
+  auto compiled = pwcpp::midi::RouteTable::compile({}, 2);
+  ASSERT_TRUE(compiled.has_value());
+  const auto &table = compiled.value();
+  ASSERT_TRUE(route(table, 0, {0, pwcpp::midi::note_on{0, 60, 100}}).empty());
+}
+
+TEST(RemapsChannelAndNumber) {
+  const std::array<pwcpp::midi::route_rule, 1> rules{pwcpp::midi::route_rule{
+      .match = {.channels = {0, 0},
+                .kinds = pwcpp::midi::kind_mask(
+                    {pwcpp::midi::message_kind::NOTE_ON,
+                     pwcpp::midi::message_kind::NOTE_OFF}),
+                .numbers = {60, 71}},
+      .action = {.output_port = 1, .channel = 9, .number_offset = 12}}};
+  auto compiled = pwcpp::midi::RouteTable::compile(rules, 1);
+  ASSERT_TRUE(compiled.has_value());
+  const auto &table = compiled.value();
+
+  auto routed = route(table, 0, {5, pwcpp::midi::note_on{0, 60, 100}});
+  ASSERT_EQ(routed.size(), 1);
+  ASSERT_EQ(routed[0].first, 1);
+  ASSERT_TRUE((routed[0].second ==
+               pwcpp::midi::timed_message{5, pwcpp::midi::note_on{9, 72, 100}}));
+
+  ASSERT_TRUE(route(table, 0, {0, pwcpp::midi::note_on{0, 72, 100}}).empty());
+  ASSERT_TRUE(route(table, 0, {0, pwcpp::midi::note_on{1, 60, 100}}).empty());
+  ASSERT_TRUE(
+      route(table, 0, {0, pwcpp::midi::control_change{0, 60, 100}}).empty());
+}
+
+TEST(ScalesAndInvertsValues) {
+  const std::array<pwcpp::midi::route_rule, 2> rules{
+      pwcpp::midi::route_rule{
+          .match = {.kinds = pwcpp::midi::kind_mask(
+                        {pwcpp::midi::message_kind::CONTROL_CHANGE})},
+          .action = {.output_port = 0,
+                     .value_minimum = 0x40000000,
+                     .value_maximum = 0x7fffffff}},
+      pwcpp::midi::route_rule{
+          .match = {.kinds = pwcpp::midi::kind_mask(
+                        {pwcpp::midi::message_kind::CONTROL_CHANGE})},
+          .action = {.output_port = 2,
+                     .value_minimum = 0xffffffff,
+                     .value_maximum = 0}}};
+  auto compiled = pwcpp::midi::RouteTable::compile(rules, 1);
+  ASSERT_TRUE(compiled.has_value());
+  const auto &table = compiled.value();
+
+  auto routed = route(table, 0, {0, pwcpp::midi::control_change{0, 7, 0xffffffff}});
+  ASSERT_EQ(routed.size(), 2);
+  ASSERT_TRUE((routed[0].second.message ==
+               pwcpp::midi::message(pwcpp::midi::control_change{0, 7, 0x7fffffff})));
+  ASSERT_EQ(routed[1].first, 2);
+  ASSERT_TRUE((routed[1].second.message ==
+               pwcpp::midi::message(pwcpp::midi::control_change{0, 7, 0})));
+
+  routed = route(table, 0, {0, pwcpp::midi::control_change{0, 7, 0}});
+  ASSERT_TRUE((routed[0].second.message ==
+               pwcpp::midi::message(pwcpp::midi::control_change{0, 7, 0x40000000})));
+  ASSERT_TRUE((routed[1].second.message ==
+               pwcpp::midi::message(pwcpp::midi::control_change{0, 7, 0xffffffff})));
+}
+
+TEST(DropsMessagesMovedOutOfRange) {
+  const std::array<pwcpp::midi::route_rule, 1> rules{pwcpp::midi::route_rule{
+      .match = {}, .action = {.number_offset = 10}}};
+  auto compiled = pwcpp::midi::RouteTable::compile(rules, 1);
+  ASSERT_TRUE(compiled.has_value());
+  const auto &table = compiled.value();
+  ASSERT_EQ(route(table, 0, {0, pwcpp::midi::note_on{0, 117, 1}}).size(), 1);
+  ASSERT_TRUE(route(table, 0, {0, pwcpp::midi::note_on{0, 118, 1}}).empty());
+}
+
+TEST(RouterSwapsTables) {
+  pwcpp::midi::Router router;
+  ASSERT_TRUE(router.acquire() == nullptr);
+
+  const std::array<pwcpp::midi::route_rule, 1> first{
+      pwcpp::midi::route_rule{.match = {}, .action = {.output_port = 1}}};
+  ASSERT_TRUE(router.publish(first, 1).has_value());
+  const auto *table = router.acquire();
+  ASSERT_TRUE(table != nullptr);
+
+  const std::array<pwcpp::midi::route_rule, 1> second{
+      pwcpp::midi::route_rule{.match = {}, .action = {.output_port = 2}}};
+  ASSERT_TRUE(router.publish(second, 1).has_value());
+  // The first table is still in use by the process callback.
+  ASSERT_EQ(router.collect(), 1);
+  ASSERT_EQ(route(*table, 0, {0, pwcpp::midi::note_on{0, 1, 1}})[0].first, 1);
+
+  table = router.acquire();
+  ASSERT_EQ(router.collect(), 0);
+  ASSERT_EQ(route(*table, 0, {0, pwcpp::midi::note_on{0, 1, 1}})[0].first, 2);
+}
+
+TEST(RejectsTablesBeyondTheEntryWidth) {
+  const std::vector<pwcpp::midi::route_rule> too_many(0x10000);
+  auto compiled = pwcpp::midi::RouteTable::compile(too_many, 1);
+  ASSERT_FALSE(compiled.has_value());
+  ASSERT_TRUE(compiled.error().type ==
+              pwcpp::error_type::UNSUPPORTED_CONFIGURATION);
+
+  // A rule per port, channel, kind and number, so every entry has its own
+  // set of matching rules.
+  std::vector<pwcpp::midi::route_rule> rules;
+  for (uint8_t port = 0; port < 8; ++port) {
+    rules.push_back({.match = {.ports = {port, port}}});
+  }
+  for (uint8_t channel = 0; channel < 16; ++channel) {
+    rules.push_back({.match = {.channels = {channel, channel}}});
+  }
+  for (std::size_t kind = 0; kind < pwcpp::midi::message_kinds; ++kind) {
+    rules.push_back({.match = {.kinds = static_cast<uint16_t>(1 << kind)}});
+  }
+  for (uint8_t number = 0; number < 128; ++number) {
+    rules.push_back({.match = {.numbers = {number, number}}});
+  }
+  ASSERT_FALSE(pwcpp::midi::RouteTable::compile(rules, 8).has_value());
+
+  pwcpp::midi::Router router;
+  ASSERT_FALSE(router.publish(rules, 8).has_value());
+  ASSERT_TRUE(router.acquire() == nullptr);
+}
+
+TEST_MAIN()
@@ -0,0 +1,177 @@
+#include "pwcpp/scheduler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <spa/node/io.h>
+
+#include <microtest/microtest.h>
+
+namespace {
+using released_events = std::vector<std::pair<uint32_t, int>>;
+
+template <typename S> released_events release(S &scheduler) {
+  released_events events;
+  scheduler.release([&](const uint32_t offset, const int &event) {
+    events.emplace_back(offset, event);
+  });
+  return events;
+}
+} // namespace
+
+TEST(ReleasesEventsSortedByOffset) {
+  pwcpp::EventScheduler<int, 16> scheduler;
+  scheduler.update(4096, 256);
+  ASSERT_TRUE(scheduler.schedule(4096 + 200, 1));
+  ASSERT_TRUE(scheduler.schedule(4096 + 10, 2));
+  ASSERT_TRUE(scheduler.schedule_after(200, 0, 3));
+  ASSERT_TRUE(scheduler.schedule_after(100, 300, 4));
+  ASSERT_EQ(scheduler.size(), 4);
+
+  const released_events expected{{10, 2}, {200, 1}, {200, 3}};
+  ASSERT_TRUE(release(scheduler) == expected);
+  ASSERT_EQ(scheduler.size(), 1);
+
+  scheduler.update(4096 + 256, 256);
+  const released_events next{{144, 4}};
+  ASSERT_TRUE(release(scheduler) == next);
+  ASSERT_TRUE(scheduler.empty());
+}
+
+TEST(MovesFarEventsDownTheLevels) {
+  pwcpp::EventScheduler<int, 16> scheduler;
+  const uint64_t start = 1000;
+  scheduler.update(start, 512);
+  // A sample before and after the boundaries of the first levels.
+  const std::vector<uint64_t> delays{1023,        1024,
+                                     65535,       65536,
+                                     4194304 + 7, 48000 * 60 * 10};
+  for (std::size_t i = 0; i < delays.size(); ++i) {
+    ASSERT_TRUE(scheduler.schedule(start + delays[i], static_cast<int>(i)));
+  }
+
+  std::vector<uint64_t> times;
+  for (uint64_t cycle = start; cycle <= start + delays.back(); cycle += 512) {
+    scheduler.update(cycle, 512);
+    scheduler.release([&](const uint32_t offset, const int &) {
+      times.push_back(cycle + offset - start);
+    });
+  }
+  ASSERT_TRUE(times == delays);
+}
+
+TEST(MatchesASortedReference) {
+  pwcpp::EventScheduler<int, 512> scheduler;
+  std::mt19937 random(42);
+  std::vector<std::tuple<uint64_t, int>> reference;
+  std::vector<std::tuple<uint64_t, int>> released;
+
+  uint64_t cycle = 123456;
+  int next_event = 0;
+  for (int i = 0; i < 4000; ++i) {
+    const uint32_t samples = 64 + random() % 2048;
+    scheduler.update(cycle, samples);
+    for (int n = random() % 6; n > 0; --n) {
+      const uint64_t delay = random() % 4 == 0 ? random() % 300000
+                                               : random() % 3000;
+      if (scheduler.schedule(cycle + delay, next_event)) {
+        reference.emplace_back(cycle + delay, next_event);
+      }
+      next_event++;
+    }
+    scheduler.release([&](const uint32_t offset, const int &event) {
+      released.emplace_back(cycle + offset, event);
+    });
+    cycle += samples;
+  }
+
+  std::stable_sort(reference.begin(), reference.end(),
+                   [](const auto &a, const auto &b) {
+                     return std::get<0>(a) < std::get<0>(b);
+                   });
+  reference.resize(released.size());
+  ASSERT_TRUE(released == reference);
+  ASSERT_EQ(scheduler.dropped(), 0);
+  ASSERT_EQ(scheduler.late(), 0);
+}
+
+TEST(DropsEventsWhenFullOrBeyondTheHorizon) {
+  using scheduler_type = pwcpp::EventScheduler<int, 2, 2>;
+  scheduler_type scheduler;
+  scheduler.update(0, 128);
+  ASSERT_FALSE(scheduler.schedule(scheduler_type::horizon * 2, 0));
+  ASSERT_TRUE(scheduler.schedule(scheduler_type::horizon, 1));
+  ASSERT_TRUE(scheduler.schedule(5, 2));
+  ASSERT_FALSE(scheduler.schedule(6, 3));
+  ASSERT_EQ(scheduler.dropped(), 2);
+
+  release(scheduler);
+  ASSERT_TRUE(scheduler.schedule(200, 4));
+}
+
+TEST(ReleasesLateEventsAtTheStartOfTheCycle) {
+  pwcpp::EventScheduler<int, 16> scheduler;
+  scheduler.update(0, 256);
+  scheduler.schedule(300, 1);
+  scheduler.schedule(600, 2);
+  scheduler.schedule(5000, 3);
+  release(scheduler);
+
+  // An xrun skipped the cycles of the first two events.
+  scheduler.update(1024, 256);
+  const released_events expected{{0, 1}, {0, 2}};
+  ASSERT_TRUE(release(scheduler) == expected);
+  ASSERT_EQ(scheduler.late(), 2);
+
+  // Events scheduled while releasing are due in the next cycle.
+  scheduler.update(1280, 256);
+  scheduler.schedule(1290, 4);
+  scheduler.release([&](const uint32_t, const int &) {
+    scheduler.schedule(1300, 5);
+  });
+  scheduler.update(1536, 256);
+  const released_events next{{0, 5}};
+  ASSERT_TRUE(release(scheduler) == next);
+}
+
+TEST(KeepsDistancesWhenTimeGoesBackwards) {
+  pwcpp::EventScheduler<int, 16> scheduler;
+  scheduler.update(100000, 256);
+  scheduler.schedule(100000 + 2000, 1);
+  scheduler.schedule(100000 + 300, 2);
+  release(scheduler);
+
+  // The events keep their distance to the end of the last cycle.
+  scheduler.update(0, 256);
+  const released_events expected{{44, 2}};
+  ASSERT_TRUE(release(scheduler) == expected);
+  scheduler.update(1536, 512);
+  const released_events next{{208, 1}};
+  ASSERT_TRUE(release(scheduler) == next);
+}
+
+TEST(UsesTheGraphClock) {
+  pwcpp::EventScheduler<int, 4> scheduler;
+  spa_io_position position{};
+  position.clock.position = 48000;
+  position.clock.duration = 1024;
+  scheduler.update(&position);
+  ASSERT_EQ(scheduler.start(), 48000);
+  scheduler.schedule_after(0, 1500, 7);
+  ASSERT_TRUE(release(scheduler).empty());
+
+  position.clock.position += 1024;
+  scheduler.update(&position);
+  const released_events expected{{476, 7}};
+  ASSERT_TRUE(release(scheduler) == expected);
+
+  scheduler.schedule_after(0, 10, 8);
+  scheduler.update(nullptr);
+  ASSERT_TRUE(release(scheduler).empty());
+}
+
+TEST_MAIN()
@@ -0,0 +1,105 @@
+#include "pwcpp/midi/sysex.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <microtest/microtest.h>
+
+using sysex_assembler = pwcpp::midi::SysexAssembler<2, 16, 2>;
+
+namespace {
+std::vector<uint8_t> bytes(const pwcpp::midi::sysex_message &message) {
+  return {message.data.begin(), message.data.end()};
+}
+} // namespace
+
+TEST(AssemblesSevenBitMessages) {
+  sysex_assembler assembler;
+  const std::array<uint32_t, 2> start{0x30160102, 0x03040506};
+  const std::array<uint32_t, 2> end{0x30320708, 0x00000000};
+
+  ASSERT_FALSE(assembler.push_ump_64(0, start).has_value());
+  auto message = assembler.push_ump_64(7, end);
+  ASSERT_TRUE(message.has_value());
+  ASSERT_EQ(message->offset, 7);
+  ASSERT_TRUE(message->type == pwcpp::midi::sysex_type::SYSEX_7);
+  ASSERT_TRUE((bytes(message.value()) ==
+               std::vector<uint8_t>{1, 2, 3, 4, 5, 6, 7, 8}));
+  ASSERT_EQ(assembler.counters().completed, 1);
+}
+
+TEST(AssemblesEightBitStreamsIndependently) {
+  sysex_assembler assembler;
+  // Stream 1 and 2 of group 3 interleaved.
+  const std::array<uint32_t, 4> start_1{0x531301aa, 0xbb000000, 0, 0};
+  const std::array<uint32_t, 4> start_2{0x531202cc, 0, 0, 0};
+  const std::array<uint32_t, 4> end_1{0x533201dd, 0, 0, 0};
+  const std::array<uint32_t, 4> end_2{0x533302ee, 0xff000000, 0, 0};
+
+  ASSERT_FALSE(assembler.push_ump_128(0, start_1).has_value());
+  ASSERT_FALSE(assembler.push_ump_128(0, start_2).has_value());
+  auto first = assembler.push_ump_128(1, end_1);
+  auto second = assembler.push_ump_128(2, end_2);
+
+  ASSERT_TRUE(first.has_value());
+  ASSERT_EQ(first->group, 3);
+  ASSERT_EQ(first->stream, 1);
+  ASSERT_TRUE((bytes(first.value()) == std::vector<uint8_t>{0xaa, 0xbb, 0xdd}));
+  ASSERT_TRUE(second.has_value());
+  ASSERT_EQ(second->stream, 2);
+  ASSERT_TRUE((bytes(second.value()) == std::vector<uint8_t>{0xcc, 0xee, 0xff}));
+}
+
+TEST(AssemblesMidi1AcrossControls) {
+  sysex_assembler assembler;
+  std::vector<std::vector<uint8_t>> messages;
+  auto emit = [&](const pwcpp::midi::sysex_message &message) {
+    messages.push_back(bytes(message));
+  };
+
+  const std::array<uint8_t, 4> first{0xf0, 0x7e, 0x01, 0xf8};
+  const std::array<uint8_t, 5> second{0x02, 0xf7, 0x90, 0xf0, 0x05};
+  const std::array<uint8_t, 1> third{0xf7};
+  assembler.push_midi_1(0, first, emit);
+  assembler.push_midi_1(1, second, emit);
+  assembler.push_midi_1(2, third, emit);
+
+  ASSERT_EQ(messages.size(), 2);
+  ASSERT_TRUE((messages[0] == std::vector<uint8_t>{0x7e, 0x01, 0x02}));
+  ASSERT_TRUE((messages[1] == std::vector<uint8_t>{0x05}));
+}
+
+TEST(DropsOversizedMessages) {
+  sysex_assembler assembler;
+  std::size_t emitted(0);
+  std::array<uint8_t, 20> data{};
+  data.front() = 0xf0;
+  data.back() = 0xf7;
+  assembler.push_midi_1(0, data,
+                        [&](const pwcpp::midi::sysex_message &) { emitted++; });
+  ASSERT_EQ(emitted, 0);
+  ASSERT_EQ(assembler.counters().oversized, 1);
+
+  // The stream is usable again afterwards.
+  const std::array<uint8_t, 3> small{0xf0, 0x01, 0xf7};
+  assembler.push_midi_1(0, small,
+                        [&](const pwcpp::midi::sysex_message &) { emitted++; });
+  ASSERT_EQ(emitted, 1);
+}
+
+TEST(CountsMessagesWithoutStream) {
+  sysex_assembler assembler;
+  for (uint32_t stream = 0; stream < 3; ++stream) {
+    const std::array<uint32_t, 4> start{0x50110000 | stream << 8, 0, 0, 0};
+    assembler.push_ump_128(0, start);
+  }
+  ASSERT_EQ(assembler.counters().no_stream, 1);
+
+  const std::array<uint32_t, 2> end_without_start{0x30300000, 0};
+  ASSERT_FALSE(assembler.push_ump_64(0, end_without_start).has_value());
+  ASSERT_EQ(assembler.counters().interrupted, 1);
+}
+
+TEST_MAIN()
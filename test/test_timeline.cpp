@@ -0,0 +1,118 @@
+#include "pwcpp/midi/message.h"
+#include "pwcpp/osc/packet_view.h"
+#include "pwcpp/property/parameter_change.h"
+#include "pwcpp/timeline.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <oscpp/client.hpp>
+#include <oscpp/server.hpp>
+
+#include <microtest/microtest.h>
+
+TEST(MergesSourcesByOffset) {
+  pwcpp::Timeline<16> timeline;
+
+  const std::vector<pwcpp::midi::timed_message> midi{
+      {2, pwcpp::midi::note_on{0, 60, 0xffff}},
+      {10, pwcpp::midi::note_off{0, 60, 0}},
+  };
+  OSCPP::Client::StaticPacket<64> packet;
+  packet.openMessage("/cutoff", 1).float32(0.5f).closeMessage();
+  const std::vector<pwcpp::osc::timed_packet> osc{
+      {5, pwcpp::osc::immediately,
+       OSCPP::Server::Packet(packet.data(), packet.size())}};
+
+  const auto midi_added = timeline.add_all(midi);
+  ASSERT_EQ(midi_added, 2);
+  const auto osc_added = timeline.add_all(osc);
+  ASSERT_EQ(osc_added, 1);
+  ASSERT_TRUE(timeline.add(pwcpp::property::parameter_change{2, 3, 0.25}));
+  ASSERT_TRUE(timeline.add(pwcpp::property::parameter_change{0, 1, 1.0}));
+  ASSERT_EQ(timeline.size(), 5);
+
+  std::vector<std::pair<uint32_t, pwcpp::event_kind>> order;
+  for (const auto &event : timeline.events()) {
+    order.emplace_back(event.offset, event.kind());
+  }
+
+  using kind = pwcpp::event_kind;
+  const std::vector<std::pair<uint32_t, pwcpp::event_kind>> expected{
+      {0, kind::PARAMETER}, {2, kind::MIDI}, {2, kind::PARAMETER},
+      {5, kind::OSC},       {10, kind::MIDI}};
+  ASSERT_TRUE(order == expected);
+
+  const auto &osc_event = *std::next(timeline.events().begin(), 3);
+  OSCPP::Server::Message message(
+      std::get<pwcpp::timeline_osc>(osc_event.data).packet());
+  ASSERT_EQ(std::string(message.address()), "/cutoff");
+  const auto &first = *timeline.events().begin();
+  ASSERT_EQ(std::get<pwcpp::timeline_parameter>(first.data).slot, 1);
+}
+
+TEST(AddsParsedMessagesAtOffsetZero) {
+  pwcpp::Timeline<4> timeline;
+  ASSERT_TRUE(timeline.add(7, pwcpp::midi::pitch_bend{0, 0}));
+
+  const std::array<std::optional<pwcpp::midi::message>, 3> parsed{
+      pwcpp::midi::message{pwcpp::midi::control_change{0, 1, 0}},
+      std::nullopt, std::nullopt};
+  const auto midi_added = timeline.add_all(parsed);
+  ASSERT_EQ(midi_added, 1);
+
+  OSCPP::Client::StaticPacket<64> bundle;
+  bundle.openBundle(1).openMessage("/a", 0).closeMessage().closeBundle();
+  const std::array<std::optional<OSCPP::Server::Packet>, 1> packets{
+      OSCPP::Server::Packet(bundle.data(), bundle.size())};
+  const auto osc_added = timeline.add_all(packets);
+  ASSERT_EQ(osc_added, 0);
+
+  const auto &first = *timeline.events().begin();
+  ASSERT_EQ(first.offset, 0);
+  ASSERT_TRUE(first.kind() == pwcpp::event_kind::MIDI);
+}
+
+TEST(DropsEventsBeyondCapacity) {
+  pwcpp::Timeline<2> timeline;
+  ASSERT_TRUE(timeline.add(pwcpp::property::parameter_change{0, 0, 0.0}));
+  ASSERT_TRUE(timeline.add(pwcpp::property::parameter_change{1, 0, 0.0}));
+  ASSERT_FALSE(timeline.add(pwcpp::property::parameter_change{2, 0, 0.0}));
+  ASSERT_EQ(timeline.dropped(), 1);
+
+  timeline.clear();
+  ASSERT_TRUE(timeline.empty());
+  ASSERT_TRUE(timeline.add(pwcpp::property::parameter_change{2, 0, 0.0}));
+  ASSERT_EQ(timeline.dropped(), 1);
+}
+
+TEST(RendersBlocksBetweenEvents) {
+  pwcpp::Timeline<8> timeline;
+  timeline.add(pwcpp::property::parameter_change{64, 0, 0.5});
+  timeline.add(pwcpp::property::parameter_change{0, 0, 0.1});
+  timeline.add(pwcpp::property::parameter_change{64, 1, 0.5});
+  timeline.add(pwcpp::property::parameter_change{300, 0, 0.9});
+
+  std::vector<std::string> calls;
+  timeline.render(
+      256,
+      [&](const pwcpp::timeline_event &event) {
+        calls.push_back("event " + std::to_string(event.offset));
+      },
+      [&](const uint32_t begin, const uint32_t end) {
+        calls.push_back("render " + std::to_string(begin) + " " +
+                        std::to_string(end));
+      });
+
+  const std::vector<std::string> expected{
+      "event 0",  "render 0 64",  "event 64",
+      "event 64", "render 64 256", "event 300"};
+  ASSERT_TRUE(calls == expected);
+}
+
+TEST_MAIN()
@@ -0,0 +1,128 @@
+#include "pwcpp/osc/packet_view.h"
+#include "pwcpp/osc/timetag_scheduler.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <oscpp/client.hpp>
+#include <oscpp/server.hpp>
+#include <spa/node/io.h>
+
+#include <microtest/microtest.h>
+
+namespace {
+constexpr int64_t cycle_nsec = 1000000000ll;
+// 480 samples at 48 kHz are 10 ms.
+constexpr int64_t cycle_length = 10000000ll;
+
+spa_io_position position(int cycle) {
+  spa_io_position position{};
+  position.clock.rate = {1, 48000};
+  position.clock.nsec = cycle_nsec + cycle * cycle_length;
+  position.clock.next_nsec = position.clock.nsec + cycle_length;
+  position.clock.duration = 480;
+  return position;
+}
+
+struct message {
+  OSCPP::Client::StaticPacket<64> packet;
+
+  explicit message(const char *address) {
+    packet.openMessage(address, 0).closeMessage();
+  }
+
+  pwcpp::osc::timed_packet at(uint64_t time, uint32_t offset = 0) const {
+    return {offset, time, OSCPP::Server::Packet(packet.data(), packet.size())};
+  }
+};
+
+using released = std::vector<std::pair<uint32_t, std::string>>;
+
+template <typename S> released release(S &scheduler) {
+  released result;
+  scheduler.release([&result](uint32_t offset, const OSCPP::Server::Packet &p) {
+    result.emplace_back(offset, OSCPP::Server::Message(p).address());
+  });
+  return result;
+}
+} // namespace
+
+TEST(ConvertsTimetags) {
+  const int64_t nsec = 1700000000123456789ll;
+  const auto timetag = pwcpp::osc::unix_nsec_to_ntp(nsec);
+  const auto seconds = timetag >> 32;
+  ASSERT_EQ(seconds, 1700000000ull + pwcpp::osc::ntp_unix_offset);
+  const auto back = pwcpp::osc::ntp_to_unix_nsec(timetag);
+  ASSERT_TRUE(back - nsec <= 1 && nsec - back <= 1);
+}
+
+TEST(ReleasesMessagesAtTheirSampleOffset) {
+  pwcpp::osc::TimetagScheduler<8, 64> scheduler;
+  scheduler.set_clock_offset(0);
+
+  message a("/a");
+  message b("/b");
+  message c("/c");
+  message now("/now");
+
+  auto p0 = position(0);
+  scheduler.update(&p0);
+  // 2.5 ms into the second cycle is sample 120.
+  ASSERT_TRUE(scheduler.schedule(
+      a.at(pwcpp::osc::unix_nsec_to_ntp(cycle_nsec + cycle_length + 2500000))));
+  ASSERT_TRUE(scheduler.schedule(
+      b.at(pwcpp::osc::unix_nsec_to_ntp(cycle_nsec + 5000000))));
+  ASSERT_TRUE(scheduler.schedule(now.at(pwcpp::osc::immediately, 7)));
+
+  auto first = release(scheduler);
+  ASSERT_TRUE((first == released{{7, "/now"}, {240, "/b"}}));
+
+  auto p1 = position(1);
+  scheduler.update(&p1);
+  ASSERT_TRUE(scheduler.schedule(
+      c.at(pwcpp::osc::unix_nsec_to_ntp(cycle_nsec - cycle_length))));
+  auto second = release(scheduler);
+  ASSERT_TRUE((second == released{{0, "/c"}, {120, "/a"}}));
+
+  const auto &counters = scheduler.statistics();
+  ASSERT_EQ(counters.scheduled, 4);
+  ASSERT_EQ(counters.released, 4);
+  ASSERT_EQ(counters.early, 1);
+  ASSERT_EQ(counters.late, 1);
+  ASSERT_EQ(scheduler.size(), 0);
+}
+
+TEST(AppliesTheClockOffset) {
+  pwcpp::osc::TimetagScheduler<8, 64> scheduler;
+  // The wall clock is one hour ahead of the monotonic clock.
+  const int64_t offset = 3600ll * 1000000000ll;
+  scheduler.set_clock_offset(offset);
+
+  message a("/a");
+  auto p0 = position(0);
+  scheduler.update(&p0);
+  scheduler.schedule(
+      a.at(pwcpp::osc::unix_nsec_to_ntp(offset + cycle_nsec + 5000000)));
+  auto result = release(scheduler);
+  ASSERT_TRUE((result == released{{240, "/a"}}));
+}
+
+TEST(DropsMessagesWhenFull) {
+  pwcpp::osc::TimetagScheduler<2, 64> scheduler;
+  message a("/a");
+  auto p0 = position(0);
+  scheduler.update(&p0);
+  const auto later = pwcpp::osc::unix_nsec_to_ntp(cycle_nsec + 10 * cycle_length);
+  ASSERT_TRUE(scheduler.schedule(a.at(later)));
+  ASSERT_TRUE(scheduler.schedule(a.at(later)));
+  ASSERT_FALSE(scheduler.schedule(a.at(later)));
+  ASSERT_EQ(scheduler.statistics().dropped, 1);
+
+  scheduler.clear();
+  ASSERT_EQ(scheduler.size(), 0);
+  ASSERT_TRUE(scheduler.schedule(a.at(later)));
+}
+
+TEST_MAIN()
@@ -0,0 +1,146 @@
+#include "pwcpp/midi/scale.h"
+#include "pwcpp/midi/translate.h"
+#include "pwcpp/midi/write_midi.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include <microtest/microtest.h>
+
+namespace {
+std::optional<pwcpp::midi::message>
+translate(pwcpp::midi::Translator &translator,
+          const pwcpp::midi::midi_1_message &message) {
+  auto words = translator.midi_1_to_ump_64(message);
+  if (!words.has_value()) {
+    return std::nullopt;
+  }
+
+  return pwcpp::midi::parse_ump_64(words->data());
+}
+} // namespace
+
+TEST(ScaleUpKeepsMinimumCenterAndMaximum) {
+  ASSERT_EQ(pwcpp::midi::scale_up(0, 7, 16), 0);
+  ASSERT_EQ(pwcpp::midi::scale_up(64, 7, 16), 0x8000);
+  ASSERT_EQ(pwcpp::midi::scale_up(127, 7, 16), 0xffff);
+  ASSERT_EQ(pwcpp::midi::scale_up(0x3fff, 14, 32), 0xffffffff);
+  for (uint32_t value = 0; value < 128; ++value) {
+    ASSERT_EQ(pwcpp::midi::scale_7_to_32(value), pwcpp::midi::scale_up(value, 7, 32));
+    ASSERT_EQ(pwcpp::midi::scale_32_to_7(pwcpp::midi::scale_7_to_32(value)), value);
+    ASSERT_EQ(pwcpp::midi::scale_16_to_7(pwcpp::midi::scale_7_to_16(value)), value);
+  }
+}
+
+TEST(TranslateNoteOnWithoutVelocityToNoteOff) {
+  pwcpp::midi::Translator translator;
+  auto message = translate(translator, {{0x93, 60, 0}, 3});
+  ASSERT_TRUE(message.has_value());
+  ASSERT_TRUE(message.value() ==
+              pwcpp::midi::message(pwcpp::midi::note_off{3, 60, 0x8000}));
+}
+
+TEST(TranslatePitchBend) {
+  pwcpp::midi::Translator translator;
+  auto message = translate(translator, {{0xe1, 0x00, 0x40}, 3});
+  ASSERT_TRUE(message.has_value());
+  ASSERT_TRUE(message.value() ==
+              pwcpp::midi::message(pwcpp::midi::pitch_bend{1, 0x80000000}));
+}
+
+TEST(AssembleRegisteredController) {
+  pwcpp::midi::Translator translator;
+  ASSERT_FALSE(translate(translator, {{0xb0, 101, 0}, 3}).has_value());
+  ASSERT_FALSE(translate(translator, {{0xb0, 100, 2}, 3}).has_value());
+
+  auto coarse = translate(translator, {{0xb0, 6, 0x40}, 3});
+  ASSERT_TRUE(coarse.has_value());
+  ASSERT_TRUE(coarse.value() == pwcpp::midi::message(
+                                    pwcpp::midi::registered_controller{
+                                        0, 0, 2, 0x80000000}));
+
+  auto fine = translate(translator, {{0xb0, 38, 0x7f}, 3});
+  ASSERT_TRUE(fine.has_value());
+  ASSERT_TRUE(fine.value() ==
+              pwcpp::midi::message(pwcpp::midi::registered_controller{
+                  0, 0, 2, pwcpp::midi::scale_14_to_32(0x207f)}));
+
+  // The null function deselects the parameter, data entry is a plain
+  // controller again.
+  translate(translator, {{0xb0, 101, 0x7f}, 3});
+  translate(translator, {{0xb0, 100, 0x7f}, 3});
+  auto plain = translate(translator, {{0xb0, 6, 0x7f}, 3});
+  ASSERT_TRUE(plain.has_value());
+  ASSERT_TRUE(plain.value() == pwcpp::midi::message(
+                                   pwcpp::midi::control_change{0, 6, 0xffffffff}));
+}
+
+TEST(AssembleControllerWithLsb) {
+  pwcpp::midi::Translator translator;
+  auto msb = translate(translator, {{0xb2, 7, 0x40}, 3});
+  ASSERT_TRUE(msb.has_value());
+  ASSERT_TRUE(msb.value() == pwcpp::midi::message(
+                                 pwcpp::midi::control_change{2, 7, 0x80000000}));
+
+  auto lsb = translate(translator, {{0xb2, 39, 0x01}, 3});
+  ASSERT_TRUE(lsb.has_value());
+  ASSERT_TRUE(lsb.value() ==
+              pwcpp::midi::message(pwcpp::midi::control_change{
+                  2, 7, pwcpp::midi::scale_14_to_32(0x2001)}));
+
+  // Channels don't share state.
+  auto other = translate(translator, {{0xb3, 39, 0x01}, 3});
+  ASSERT_TRUE(other.has_value());
+  ASSERT_TRUE(other.value() == pwcpp::midi::message(pwcpp::midi::control_change{
+                                   3, 39, pwcpp::midi::scale_7_to_32(1)}));
+}
+
+TEST(BankSelectIsPartOfProgramChange) {
+  pwcpp::midi::Translator translator;
+  ASSERT_FALSE(translate(translator, {{0xb5, 0, 3}, 3}).has_value());
+  ASSERT_FALSE(translate(translator, {{0xb5, 32, 9}, 3}).has_value());
+  auto message = translate(translator, {{0xc5, 17, 0}, 2});
+  ASSERT_TRUE(message.has_value());
+  ASSERT_TRUE(message.value() == pwcpp::midi::message(
+                                     pwcpp::midi::program_change{5, 17, true, 3, 9}));
+}
+
+TEST(TranslateRegisteredControllerToMidi1) {
+  std::array<pwcpp::midi::midi_1_message, pwcpp::midi::max_translated_messages>
+      out;
+  auto count = pwcpp::midi::encode_midi_1(
+      pwcpp::midi::registered_controller{4, 0, 1, 0x80000000}, out);
+  ASSERT_EQ(count, 4);
+  ASSERT_TRUE((out[0] == pwcpp::midi::midi_1_message{{0xb4, 101, 0}, 3}));
+  ASSERT_TRUE((out[1] == pwcpp::midi::midi_1_message{{0xb4, 100, 1}, 3}));
+  ASSERT_TRUE((out[2] == pwcpp::midi::midi_1_message{{0xb4, 6, 0x40}, 3}));
+  ASSERT_TRUE((out[3] == pwcpp::midi::midi_1_message{{0xb4, 38, 0}, 3}));
+}
+
+TEST(RoundTripThroughMidi1) {
+  const std::array<pwcpp::midi::message, 6> messages{
+      pwcpp::midi::note_on{1, 60, 0x8000},
+      pwcpp::midi::note_off{1, 60, 0},
+      pwcpp::midi::poly_pressure{2, 61, 0xffffffff},
+      pwcpp::midi::channel_pressure{3, 0},
+      pwcpp::midi::pitch_bend{4, 0x80000000},
+      pwcpp::midi::program_change{5, 12, true, 1, 2}};
+
+  pwcpp::midi::Translator translator;
+  for (const auto &message : messages) {
+    std::array<pwcpp::midi::midi_1_message,
+               pwcpp::midi::max_translated_messages>
+        out;
+    auto count = pwcpp::midi::encode_midi_1(message, out);
+    std::optional<pwcpp::midi::message> translated;
+    for (std::size_t i = 0; i < count; ++i) {
+      translated = translate(translator, out[i]);
+    }
+
+    ASSERT_TRUE(translated.has_value());
+    ASSERT_TRUE(translated.value() == message);
+  }
+}
+
+TEST_MAIN()
@@ -0,0 +1,118 @@
+#include "pwcpp/midi/write_midi.h"
+#include "pwcpp/transport.h"
+#include "sequence_memory.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <spa/control/control.h>
+#include <spa/node/io.h>
+#include <spa/pod/iter.h>
+
+#include <microtest/microtest.h>
+
+namespace {
+struct output_memory : sequence_memory<4096> {
+  /*! \brief The offset and the first word of every written control. */
+  std::vector<std::pair<uint32_t, uint32_t>> controls() {
+    std::vector<std::pair<uint32_t, uint32_t>> result;
+    spa_pod_control *control;
+    SPA_POD_SEQUENCE_FOREACH(sequence(), control) {
+      result.emplace_back(control->offset,
+                          *static_cast<uint32_t *>(SPA_POD_BODY(&control->value)));
+    }
+    return result;
+  }
+};
+
+spa_io_position position(uint64_t sample, uint32_t state, double beat) {
+  spa_io_position position{};
+  position.clock.rate = {1, 48000};
+  position.clock.position = sample;
+  position.clock.duration = 1024;
+  position.state = state;
+  position.n_segments = 1;
+  auto &segment = position.segments[0];
+  segment.start = sample;
+  segment.rate = 1.0;
+  segment.position = sample;
+  segment.bar.flags = SPA_IO_SEGMENT_BAR_FLAG_VALID;
+  segment.bar.signature_num = 4.0f;
+  segment.bar.signature_denom = 4.0f;
+  segment.bar.bpm = 120.0;
+  segment.bar.beat = beat;
+  return position;
+}
+
+std::vector<std::pair<uint32_t, uint32_t>>
+write_cycle(pwcpp::Transport &transport, const spa_io_position &position) {
+  output_memory memory;
+  transport.update(&position);
+  pwcpp::midi::MidiWriter writer(memory.spa_data());
+  auto result = transport.write_clock(writer);
+  writer.finish();
+  return result.has_value() ? memory.controls()
+                            : std::vector<std::pair<uint32_t, uint32_t>>{};
+}
+} // namespace
+
+TEST(DerivesBarAndBeat) {
+  pwcpp::Transport transport;
+  auto p = position(0, SPA_IO_POSITION_STATE_RUNNING, 9.5);
+  const auto &current = transport.update(&p);
+  ASSERT_TRUE(current.state == pwcpp::transport_state::RUNNING);
+  ASSERT_TRUE(current.bar_valid);
+  ASSERT_EQ(current.sample_rate, 48000);
+  ASSERT_EQ(current.bar, 2);
+  ASSERT_TRUE(current.beat_in_bar == 1.5);
+  ASSERT_TRUE(transport.beat_at(24000) == 10.5);
+}
+
+TEST(IgnoresMissingPositions) {
+  pwcpp::Transport transport;
+  const auto &current = transport.update(nullptr);
+  ASSERT_TRUE(current.state == pwcpp::transport_state::STOPPED);
+  ASSERT_FALSE(current.bar_valid);
+}
+
+TEST(WritesClockTicksAtSampleOffsets) {
+  // 120 bpm at 48 kHz is a tick every 1000 samples.
+  pwcpp::Transport transport;
+  auto first = write_cycle(transport,
+                           position(0, SPA_IO_POSITION_STATE_RUNNING, 0.0));
+  ASSERT_EQ(first.size(), 3);
+  ASSERT_EQ(first[0].second, 0x10fa0000u);
+  ASSERT_EQ(first[1].first, 0);
+  ASSERT_EQ(first[1].second, 0x10f80000u);
+  ASSERT_EQ(first[2].first, 1000);
+
+  auto second = write_cycle(
+      transport, position(1024, SPA_IO_POSITION_STATE_RUNNING, 1024 / 24000.0));
+  ASSERT_EQ(second.size(), 1);
+  ASSERT_EQ(second[0].first, 976);
+  ASSERT_EQ(second[0].second, 0x10f80000u);
+
+  auto stopped = write_cycle(
+      transport, position(2048, SPA_IO_POSITION_STATE_STOPPED, 2048 / 24000.0));
+  ASSERT_EQ(stopped.size(), 1);
+  ASSERT_EQ(stopped[0].second, 0x10fc0000u);
+}
+
+TEST(WritesSongPositionWhenRelocated) {
+  pwcpp::Transport transport;
+  write_cycle(transport, position(0, SPA_IO_POSITION_STATE_RUNNING, 0.0));
+
+  auto relocated = write_cycle(
+      transport, position(1024, SPA_IO_POSITION_STATE_RUNNING, 8.0));
+  ASSERT_TRUE(transport.has_relocated());
+  ASSERT_EQ(relocated.size(), 5);
+  ASSERT_EQ(relocated[0].second, 0x10fc0000u);
+  // 8 quarter notes are 32 sixteenth notes.
+  ASSERT_EQ(relocated[1].second, 0x10f22000u);
+  ASSERT_EQ(relocated[2].second, 0x10fb0000u);
+  ASSERT_EQ(relocated[3].first, 0);
+  ASSERT_EQ(relocated[4].first, 1000);
+}
+
+TEST_MAIN()
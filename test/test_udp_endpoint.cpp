@@ -0,0 +1,206 @@
+#include "pwcpp/error.h"
+#include "pwcpp/osc/udp_endpoint.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <oscpp/client.hpp>
+#include <oscpp/server.hpp>
+
+#include <microtest/microtest.h>
+
+namespace {
+using endpoint = pwcpp::osc::UdpEndpoint<8, 256>;
+
+struct received_message {
+  std::string address;
+  int32_t value;
+};
+
+std::vector<received_message> collect(endpoint &receiver) {
+  std::vector<received_message> messages;
+  receiver.for_each_packet([&](const OSCPP::Server::Packet &packet) {
+    OSCPP::Server::Message message(packet);
+    auto arguments = message.args();
+    messages.push_back({message.address(), arguments.int32()});
+  });
+  return messages;
+}
+
+void connect(endpoint &sender, endpoint &receiver) {
+  ASSERT_TRUE(receiver.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(sender.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(
+      sender.set_destination("127.0.0.1", receiver.local_port()).has_value());
+}
+} // namespace
+
+TEST(BindChoosesPort) {
+  endpoint udp;
+  ASSERT_EQ(udp.fd(), -1);
+  ASSERT_EQ(udp.local_port(), 0);
+
+  ASSERT_TRUE(udp.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(udp.fd() >= 0);
+  ASSERT_TRUE(udp.local_port() != 0);
+}
+
+TEST(InvalidAddress) {
+  endpoint udp;
+  auto result = udp.bind("not an address", 0);
+  ASSERT_FALSE(result.has_value());
+  ASSERT_TRUE(result.error().type == pwcpp::error_type::OSC_SOCKET_ERROR);
+}
+
+TEST(RoundTripOverLoopback) {
+  endpoint sender;
+  endpoint receiver;
+  connect(sender, receiver);
+
+  ASSERT_TRUE(sender.send_message("/a", int32_t(1)).has_value());
+  ASSERT_TRUE(sender.send_message("/b", int32_t(2)).has_value());
+  ASSERT_TRUE(sender
+                  .send([](OSCPP::Client::Packet &packet) {
+                    packet.openMessage("/c", 1).int32(3).closeMessage();
+                  })
+                  .has_value());
+
+  const auto sent = sender.flush();
+  ASSERT_EQ(sent, 3);
+  const auto queued = receiver.receive();
+  ASSERT_EQ(queued, 3);
+
+  const auto messages = collect(receiver);
+  ASSERT_EQ(messages.size(), 3);
+  ASSERT_EQ(messages[0].address, "/a");
+  ASSERT_EQ(messages[0].value, 1);
+  ASSERT_EQ(messages[1].address, "/b");
+  ASSERT_EQ(messages[2].address, "/c");
+  ASSERT_EQ(messages[2].value, 3);
+
+  ASSERT_EQ(sender.statistics().sent, 3);
+  ASSERT_EQ(receiver.statistics().received, 3);
+}
+
+TEST(BuffersAreReturned) {
+  endpoint sender;
+  endpoint receiver;
+  connect(sender, receiver);
+
+  // More packets than either pool holds, in rounds.
+  for (int32_t round = 0; round < 5; ++round) {
+    for (int32_t i = 0; i < 8; ++i) {
+      ASSERT_TRUE(sender.send_message("/n", round * 8 + i).has_value());
+    }
+    const auto sent = sender.flush();
+    ASSERT_EQ(sent, 8);
+    const auto queued = receiver.receive();
+    ASSERT_EQ(queued, 8);
+    const auto messages = collect(receiver);
+    ASSERT_EQ(messages.size(), 8);
+    ASSERT_EQ(messages.back().value, round * 8 + 7);
+  }
+}
+
+TEST(SendQueueFull) {
+  endpoint sender;
+  ASSERT_TRUE(sender.bind("127.0.0.1", 0).has_value());
+
+  for (int32_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(sender.send_message("/n", i).has_value());
+  }
+  auto result = sender.send_message("/n", int32_t(8));
+  ASSERT_FALSE(result.has_value());
+  ASSERT_TRUE(result.error().type == pwcpp::error_type::OSC_SEND_QUEUE_FULL);
+  ASSERT_EQ(sender.statistics().send_overruns, 1);
+
+  // Without a destination the packets fail to send but free their buffers.
+  const auto sent = sender.flush();
+  ASSERT_EQ(sent, 0);
+  ASSERT_EQ(sender.statistics().send_errors, 8);
+  ASSERT_TRUE(sender.send_message("/n", int32_t(9)).has_value());
+}
+
+TEST(ReceiveOverrunDiscards) {
+  endpoint sender;
+  endpoint receiver;
+  connect(sender, receiver);
+
+  for (int32_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(sender.send_message("/n", i).has_value());
+  }
+  sender.flush();
+  for (int32_t i = 8; i < 10; ++i) {
+    ASSERT_TRUE(sender.send_message("/n", i).has_value());
+  }
+  sender.flush();
+
+  // Only eight buffers, the rest is read and discarded.
+  const auto queued = receiver.receive();
+  ASSERT_EQ(queued, 8);
+  ASSERT_EQ(receiver.statistics().receive_overruns, 2);
+  const auto messages = collect(receiver);
+  ASSERT_EQ(messages.size(), 8);
+  ASSERT_EQ(messages[7].value, 7);
+}
+
+TEST(MalformedDatagramsAreDropped) {
+  endpoint receiver;
+  ASSERT_TRUE(receiver.bind("127.0.0.1", 0).has_value());
+
+  endpoint sender;
+  ASSERT_TRUE(sender.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(
+      sender.set_destination("127.0.0.1", receiver.local_port()).has_value());
+  const char garbage[] = "garbage!";
+  ASSERT_TRUE(sender.send_packet(garbage, 8).has_value());
+  // Larger than a receive buffer.
+  std::vector<uint8_t> large(512, 0);
+  large[0] = '/';
+  auto too_large = sender.send_packet(large.data(), large.size());
+  ASSERT_FALSE(too_large.has_value());
+  sender.flush();
+
+  const auto queued = receiver.receive();
+  ASSERT_EQ(queued, 0);
+  ASSERT_EQ(receiver.statistics().malformed, 1);
+}
+
+TEST(MalformedDatagramsKeepTheBatchInOrder) {
+  endpoint sender;
+  endpoint receiver;
+  connect(sender, receiver);
+
+  // Junk between valid messages, all read by one recvmmsg call.
+  const char junk[] = "abc";
+  ASSERT_TRUE(sender.send_packet(junk, 3).has_value());
+  ASSERT_TRUE(sender.send_message("/ok", int32_t(1)).has_value());
+  ASSERT_TRUE(sender.send_packet(junk, 3).has_value());
+  ASSERT_TRUE(sender.send_message("/ok", int32_t(2)).has_value());
+  ASSERT_TRUE(sender.send_message("/ok", int32_t(3)).has_value());
+  const auto sent = sender.flush();
+  ASSERT_EQ(sent, 5);
+
+  const auto queued = receiver.receive();
+  ASSERT_EQ(queued, 3);
+  ASSERT_EQ(receiver.statistics().malformed, 2);
+  const auto messages = collect(receiver);
+  ASSERT_EQ(messages.size(), 3);
+  for (int32_t i = 0; i < 3; ++i) {
+    ASSERT_EQ(messages[i].address, "/ok");
+    ASSERT_EQ(messages[i].value, i + 1);
+  }
+
+  // The returned buffers are all usable again.
+  for (int32_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(sender.send_message("/n", i).has_value());
+  }
+  sender.flush();
+  const auto refilled = receiver.receive();
+  ASSERT_EQ(refilled, 8);
+  const auto refilled_messages = collect(receiver);
+  ASSERT_EQ(refilled_messages.back().value, 7);
+}
+
+TEST_MAIN()
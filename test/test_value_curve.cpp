@@ -0,0 +1,66 @@
+#include "pwcpp/midi/value_curve.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include <microtest/microtest.h>
+
+namespace {
+constexpr pwcpp::midi::ValueCurve<> frequency(
+    pwcpp::midi::exponential_curve::for_range(20.0, 20000.0), 20.0, 20000.0);
+
+constexpr pwcpp::midi::ValueCurve<> gain(
+    pwcpp::midi::breakpoint_curve(std::array<pwcpp::midi::curve_point, 3>{
+        pwcpp::midi::curve_point{0.0, 0.0}, {0.5, 0.8}, {1.0, 1.0}}),
+    0.0, 1.0);
+
+static_assert(frequency.map_7_bit(0) == 20.0f);
+static_assert(gain.map_7_bit(127) == 1.0f);
+
+bool near(double a, double b, double tolerance) {
+  return std::abs(a - b) <= tolerance * std::abs(b);
+}
+} // namespace
+
+TEST(ConstexprFunctionsMatchTheLibrary) {
+  for (double x = -10.0; x <= 10.0; x += 0.37) {
+    ASSERT_TRUE(near(pwcpp::midi::detail::constexpr_exp(x), std::exp(x), 1e-12));
+  }
+  for (double x = 0.001; x < 1000.0; x *= 1.7) {
+    ASSERT_TRUE(std::abs(pwcpp::midi::detail::constexpr_log(x) - std::log(x)) <
+                1e-12);
+  }
+}
+
+TEST(MapsSevenBitValuesExactly) {
+  for (uint8_t value = 0; value < 128; ++value) {
+    const double expected = 20.0 * std::pow(1000.0, value / 127.0);
+    ASSERT_TRUE(near(frequency.map_7_bit(value), expected, 1e-6));
+  }
+}
+
+TEST(InterpolatesHighResolutionValues) {
+  for (uint32_t value = 0; value < 0xff000000u; value += 0x00fedcbau) {
+    const double x = value / 4294967295.0;
+    const double expected = 20.0 * std::pow(1000.0, x);
+    ASSERT_TRUE(near(frequency.map_32_bit(value), expected, 1e-3));
+  }
+
+  ASSERT_TRUE(near(frequency.map_14_bit(0x3fff), 20000.0, 1e-6));
+  ASSERT_TRUE(near(frequency.map_16_bit(0), 20.0, 1e-6));
+  ASSERT_TRUE(near(gain.map_32_bit(0x80000000u), 0.8, 1e-6));
+  ASSERT_TRUE(near(gain.map_32_bit(0x40000000u), 0.4, 1e-6));
+}
+
+TEST(CurvesAreMonotonic) {
+  constexpr pwcpp::midi::ValueCurve<6> log_curve(
+      pwcpp::midi::logarithmic_curve{10.0}, 0.0, 1.0);
+  float previous = log_curve.map_7_bit(0);
+  for (uint32_t value = 0; value < 0xffff0000u; value += 0x10000u) {
+    const float mapped = log_curve.map_32_bit(value);
+    ASSERT_TRUE(mapped >= previous);
+    previous = mapped;
+  }
+}
+
+TEST_MAIN()
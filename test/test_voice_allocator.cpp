@@ -0,0 +1,122 @@
+#include "pwcpp/midi/note_tracker.h"
+#include "pwcpp/midi/voice_allocator.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <microtest/microtest.h>
+
+namespace {
+using event_type = pwcpp::midi::voice_event::type;
+
+struct recorder {
+  std::vector<pwcpp::midi::voice_event> events;
+
+  void operator()(const pwcpp::midi::voice_event &event) {
+    events.push_back(event);
+  }
+};
+} // namespace
+
+TEST(TrackerSustainsReleasedNotes) {
+  pwcpp::midi::NoteTracker tracker;
+  tracker.update(pwcpp::midi::note_on{0, 60, 100});
+  tracker.update(pwcpp::midi::control_change{0, 64, 0xffffffff});
+  tracker.update(pwcpp::midi::note_off{0, 60, 0});
+
+  ASSERT_FALSE(tracker.is_held(0, 60));
+  ASSERT_TRUE(tracker.is_sounding(0, 60));
+  ASSERT_EQ(tracker.sounding(0), 1);
+
+  tracker.update(pwcpp::midi::control_change{0, 64, 0});
+  ASSERT_FALSE(tracker.is_sounding(0, 60));
+}
+
+TEST(TrackerEmitsAllNotesOff) {
+  pwcpp::midi::NoteTracker tracker;
+  tracker.update(pwcpp::midi::note_on{2, 61, 100});
+  tracker.update(pwcpp::midi::note_on{1, 60, 100});
+  tracker.update(pwcpp::midi::control_change{2, 64, 0xffffffff});
+
+  std::vector<pwcpp::midi::message> messages;
+  tracker.all_notes_off(
+      [&](const pwcpp::midi::message &message) { messages.push_back(message); });
+
+  const std::vector<pwcpp::midi::message> expected{
+      pwcpp::midi::note_off{1, 60, 0}, pwcpp::midi::note_off{2, 61, 0},
+      pwcpp::midi::control_change{2, 64, 0}};
+  ASSERT_TRUE(messages == expected);
+  ASSERT_EQ(tracker.sounding(1), 0);
+}
+
+TEST(AllocatorKeepsActiveVoicesContiguous) {
+  pwcpp::midi::VoiceAllocator<4> allocator;
+  recorder events;
+  for (uint8_t note = 60; note < 63; ++note) {
+    allocator.update(pwcpp::midi::note_on{0, note, 100}, events);
+  }
+  ASSERT_EQ(allocator.active().size(), 3);
+  ASSERT_EQ(allocator.active()[1].slot, 1);
+
+  allocator.update(pwcpp::midi::note_off{0, 60, 0}, events);
+  ASSERT_TRUE(events.events.back().event_type == event_type::RELEASE);
+  allocator.free_if([](const pwcpp::midi::voice &v) { return !v.gate; });
+
+  ASSERT_EQ(allocator.active().size(), 2);
+  for (const auto &v : allocator.active()) {
+    ASSERT_TRUE(v.gate);
+  }
+  // The slots of the remaining voices are unchanged.
+  ASSERT_EQ(allocator.active()[0].note, 62);
+  ASSERT_EQ(allocator.active()[0].slot, 2);
+
+  allocator.update(pwcpp::midi::note_on{0, 70, 100}, events);
+  ASSERT_EQ(events.events.back().slot, 0);
+}
+
+TEST(AllocatorStealsReleasedVoicesFirst) {
+  pwcpp::midi::VoiceAllocator<2> allocator(pwcpp::midi::steal_policy::OLDEST);
+  recorder events;
+  allocator.update(pwcpp::midi::note_on{0, 60, 100}, events);
+  allocator.update(pwcpp::midi::note_on{0, 61, 100}, events);
+  allocator.update(pwcpp::midi::note_off{0, 61, 0}, events);
+  allocator.update(pwcpp::midi::note_on{0, 62, 100}, events);
+
+  ASSERT_TRUE(events.events.back().event_type == event_type::STEAL);
+  ASSERT_EQ(events.events.back().slot, 1);
+
+  allocator.update(pwcpp::midi::note_on{0, 63, 100}, events);
+  ASSERT_EQ(events.events.back().slot, 0);
+}
+
+TEST(AllocatorStealsByPolicy) {
+  pwcpp::midi::VoiceAllocator<2> quietest(pwcpp::midi::steal_policy::QUIETEST);
+  recorder events;
+  quietest.update(pwcpp::midi::note_on{0, 60, 10}, events);
+  quietest.update(pwcpp::midi::note_on{0, 61, 5}, events);
+  quietest.update(pwcpp::midi::note_on{0, 62, 100}, events);
+  ASSERT_EQ(events.events.back().slot, 1);
+
+  pwcpp::midi::VoiceAllocator<2> none(pwcpp::midi::steal_policy::NONE);
+  events.events.clear();
+  none.update(pwcpp::midi::note_on{0, 60, 10}, events);
+  none.update(pwcpp::midi::note_on{0, 61, 10}, events);
+  none.update(pwcpp::midi::note_on{0, 62, 10}, events);
+  ASSERT_EQ(events.events.size(), 2);
+}
+
+TEST(AllocatorReleasesSustainedVoicesWithPedal) {
+  pwcpp::midi::VoiceAllocator<2> allocator;
+  recorder events;
+  allocator.update(pwcpp::midi::control_change{0, 64, 0xffffffff}, events);
+  allocator.update(pwcpp::midi::note_on{0, 60, 10}, events);
+  allocator.update(pwcpp::midi::note_off{0, 60, 0}, events);
+  ASSERT_TRUE(allocator.active()[0].gate);
+  ASSERT_TRUE(allocator.active()[0].sustained);
+
+  allocator.update(pwcpp::midi::control_change{0, 64, 0}, events);
+  ASSERT_FALSE(allocator.active()[0].gate);
+  ASSERT_TRUE(events.events.back().event_type == event_type::RELEASE);
+}
+
+TEST_MAIN()
@@ -0,0 +1,97 @@
+#include "pwcpp/buffer.h"
+#include "pwcpp/midi/parse_ump_batch.h"
+#include "pwcpp/midi/write_midi.h"
+#include "sequence_memory.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <spa/control/control.h>
+#include <spa/pod/iter.h>
+
+#include <microtest/microtest.h>
+
+namespace {
+using output_memory = sequence_memory<4096>;
+} // namespace
+
+TEST(WrittenMessagesCanBeParsed) {
+  output_memory memory;
+  auto buffer = memory.buffer(sizeof(memory.data));
+
+  std::vector<pwcpp::midi::timed_message> messages = {
+      {0, pwcpp::midi::note_on{.channel = 1, .note = 60, .velocity = 0x8000}},
+      {3, pwcpp::midi::control_change{
+              .channel = 2, .cc_number = 7, .value = 0x12345678}},
+      {3, pwcpp::midi::note_off{.channel = 1, .note = 60, .velocity = 0}},
+  };
+
+  auto written = pwcpp::midi::write_midi(buffer, messages);
+  ASSERT_TRUE(written.has_value());
+  ASSERT_EQ(written.value(), 3);
+  ASSERT_TRUE(memory.chunk.size > 0);
+
+  std::array<pwcpp::midi::timed_message, 8> parsed;
+  auto count = pwcpp::midi::parse_midi_batch(buffer, parsed);
+  ASSERT_TRUE(count.has_value());
+  ASSERT_EQ(count.value(), 3);
+  for (std::size_t i = 0; i < messages.size(); ++i) {
+    ASSERT_TRUE(parsed[i] == messages[i]);
+  }
+}
+
+TEST(WritingDescendingOffsetsFails) {
+  output_memory memory;
+  pwcpp::midi::MidiWriter writer(memory.spa_data(sizeof(memory.data)));
+
+  ASSERT_TRUE(writer.write(5, pwcpp::midi::note_on{1, 60, 0x8000}));
+  auto result = writer.write(4, pwcpp::midi::note_off{1, 60, 0});
+  ASSERT_FALSE(result.has_value());
+  ASSERT_TRUE(result.error().type ==
+              pwcpp::error_type::SEQUENCE_WRITING_OFFSET_NOT_ASCENDING);
+  writer.finish();
+  ASSERT_EQ(writer.size(), 1);
+}
+
+TEST(WritingReportsOverflow) {
+  output_memory memory;
+  // The sequence header and two UMP controls of 24 bytes each.
+  pwcpp::midi::MidiWriter writer(memory.spa_data(16 + 2 * 24));
+
+  ASSERT_TRUE(writer.write(0, pwcpp::midi::note_on{1, 60, 0x8000}));
+  ASSERT_TRUE(writer.write(1, pwcpp::midi::note_on{1, 61, 0x8000}));
+  auto result = writer.write(2, pwcpp::midi::note_on{1, 62, 0x8000});
+  ASSERT_FALSE(result.has_value());
+  ASSERT_TRUE(result.error().type ==
+              pwcpp::error_type::SEQUENCE_WRITING_BUFFER_OVERFLOW);
+  writer.finish();
+  ASSERT_EQ(memory.chunk.size, 16 + 2 * 24);
+}
+
+TEST(WriteMidi1Bytes) {
+  output_memory memory;
+  pwcpp::midi::MidiWriter writer(memory.spa_data(sizeof(memory.data)),
+                                 pwcpp::midi::midi_format::MIDI_1);
+  ASSERT_TRUE(writer.write(0, pwcpp::midi::control_change{2, 7, 0xfe000000}));
+  ASSERT_TRUE(writer.write(1, pwcpp::midi::note_on{0, 60, 0x0100}));
+  writer.finish();
+
+  auto sequence = static_cast<spa_pod_sequence *>(spa_pod_from_data(
+      memory.data, sizeof(memory.data), 0, memory.chunk.size));
+  ASSERT_TRUE(sequence != nullptr);
+
+  std::vector<std::vector<uint8_t>> controls;
+  struct spa_pod_control *control;
+  SPA_POD_SEQUENCE_FOREACH(sequence, control) {
+    ASSERT_EQ(control->type, SPA_CONTROL_Midi);
+    auto body = static_cast<uint8_t *>(SPA_POD_BODY(&control->value));
+    controls.emplace_back(body, body + SPA_POD_BODY_SIZE(&control->value));
+  }
+
+  ASSERT_EQ(controls.size(), 2);
+  ASSERT_TRUE((controls[0] == std::vector<uint8_t>{0xb2, 7, 0x7f}));
+  ASSERT_TRUE((controls[1] == std::vector<uint8_t>{0x90, 60, 1}));
+}
+
+TEST_MAIN()
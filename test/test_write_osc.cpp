@@ -0,0 +1,140 @@
+#include "pwcpp/buffer.h"
+#include "pwcpp/error.h"
+#include "pwcpp/osc/packet_view.h"
+#include "pwcpp/osc/write_osc.h"
+#include "sequence_memory.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <oscpp/client.hpp>
+#include <oscpp/server.hpp>
+#include <spa/pod/iter.h>
+
+#include <microtest/microtest.h>
+
+namespace {
+struct output_memory : sequence_memory<> {
+  std::vector<pwcpp::osc::timed_packet> read() {
+    auto buffer = this->buffer();
+    std::vector<pwcpp::osc::timed_packet> packets;
+    auto view = pwcpp::osc::packets(buffer);
+    for (const auto &packet : view.value()) {
+      packets.push_back(packet);
+    }
+    return packets;
+  }
+};
+} // namespace
+
+TEST(WritesMessagesInPlace) {
+  output_memory memory;
+  pwcpp::osc::OscWriter writer(memory.spa_data());
+  auto written = writer.write_message(4, "/gain", 0.5f, int32_t(3), "db");
+  ASSERT_TRUE(written.has_value());
+  writer.finish();
+
+  auto packets = memory.read();
+  ASSERT_EQ(packets.size(), 1);
+  ASSERT_EQ(packets[0].offset, 4);
+  OSCPP::Server::Message message(packets[0].packet);
+  ASSERT_EQ(std::string(message.address()), "/gain");
+  auto args = message.args();
+  const auto gain = args.float32();
+  const auto count = args.int32();
+  const std::string unit = args.string();
+  ASSERT_TRUE(gain == 0.5f);
+  ASSERT_EQ(count, 3);
+  ASSERT_EQ(unit, "db");
+}
+
+TEST(BuildsBundlesInPlace) {
+  output_memory memory;
+  pwcpp::osc::OscWriter writer(memory.spa_data());
+  auto written = writer.write(0, [](OSCPP::Client::Packet &packet) {
+    packet.openBundle(42)
+        .openMessage("/a", 1)
+        .int32(1)
+        .closeMessage()
+        .openMessage("/b", 1)
+        .int32(2)
+        .closeMessage()
+        .closeBundle();
+  });
+  ASSERT_TRUE(written.has_value());
+  written = writer.write_message(8, "/c");
+  ASSERT_TRUE(written.has_value());
+  writer.finish();
+
+  auto packets = memory.read();
+  ASSERT_EQ(packets.size(), 3);
+  ASSERT_EQ(packets[0].time, 42);
+  ASSERT_EQ(packets[1].time, 42);
+  ASSERT_EQ(std::string(OSCPP::Server::Message(packets[2].packet).address()),
+            "/c");
+  ASSERT_EQ(packets[2].offset, 8);
+}
+
+TEST(RejectsPacketsThatDontFit) {
+  output_memory memory;
+  pwcpp::osc::OscWriter writer(memory.spa_data(64));
+  auto written = writer.write_message(0, "/a/long/address/that/does/not/fit",
+                                      int32_t(1), int32_t(2));
+  ASSERT_FALSE(written.has_value());
+  ASSERT_TRUE(written.error().type ==
+              pwcpp::error_type::SEQUENCE_WRITING_BUFFER_OVERFLOW);
+
+  written = writer.write(0, [](OSCPP::Client::Packet &packet) {
+    packet.openMessage("/a/long/address/that/does/not/fit", 0).closeMessage();
+  });
+  ASSERT_FALSE(written.has_value());
+
+  written = writer.write_message(1, "/ok");
+  ASSERT_TRUE(written.has_value());
+  ASSERT_EQ(writer.size(), 1);
+}
+
+TEST(ForwardsPacketViews) {
+  output_memory input;
+  pwcpp::osc::OscWriter writer(input.spa_data());
+  writer.write_message(1, "/a");
+  writer.write_message(2, "/b", 1.0f);
+  writer.write(3, [](OSCPP::Client::Packet &packet) {
+    packet.openBundle(42)
+        .openMessage("/c", 1)
+        .int32(1)
+        .closeMessage()
+        .openMessage("/d", 0)
+        .closeMessage()
+        .closeBundle();
+  });
+  writer.finish();
+
+  output_memory output;
+  auto input_buffer = input.buffer();
+  auto output_buffer = output.buffer();
+  auto written =
+      pwcpp::osc::write_osc(output_buffer, pwcpp::osc::packets(input_buffer).value());
+  ASSERT_TRUE(written.has_value());
+  ASSERT_EQ(written.value(), 4);
+
+  auto packets = output.read();
+  ASSERT_EQ(packets.size(), 4);
+  ASSERT_EQ(packets[1].offset, 2);
+  ASSERT_EQ(std::string(OSCPP::Server::Message(packets[1].packet).address()),
+            "/b");
+  ASSERT_TRUE(packets[1].time == pwcpp::osc::immediately);
+  ASSERT_EQ(packets[2].offset, 3);
+  ASSERT_EQ(packets[2].time, 42);
+  OSCPP::Server::Message bundled(packets[2].packet);
+  ASSERT_EQ(std::string(bundled.address()), "/c");
+  auto args = bundled.args();
+  const auto value = args.int32();
+  ASSERT_EQ(value, 1);
+  ASSERT_EQ(packets[3].time, 42);
+  ASSERT_EQ(std::string(OSCPP::Server::Message(packets[3].packet).address()),
+            "/d");
+}
+
+TEST_MAIN()